@@ -3040,10 +3040,31 @@ load_files(Module:Files, Options) :-
 '$end_load_file'(end_module, State) :-
     arg(2, State, Module),
     '$check_export'(Module),
+    arg(5, State, Id),
+    '$ifcompiling'('$qlf_index_hints'(Id)),
     '$ifcompiling'('$qlf_end_part').
-'$end_load_file'(end_non_module, _State) :-
+'$end_load_file'(end_non_module, State) :-
+    arg(5, State, Id),
+    '$ifcompiling'('$qlf_index_hints'(Id)),
     '$ifcompiling'('$qlf_end_part').
 
+%!  '$qlf_index_hints'(+File)
+%
+%   Add the primary clause indexes  created   while  loading File to the
+%   .qlf file, such that they are created again when the .qlf file is
+%   loaded.
+
+'$qlf_index_hints'(File) :-
+    (   '$source_file_predicates'(File, Preds),
+        '$member'(M:H, Preds),
+        functor(H, Name, Arity),
+        '$index_hints'(M:Name/Arity, Hints),
+        Hints \== [],
+        '$add_directive_wic'(system:'$set_index_hints'(M:Name/Arity, Hints)),
+        fail
+    ;   true
+    ).
+
 
 '$first_term'(?-(Directive), Layout, Id, State, Options) :-
     !,
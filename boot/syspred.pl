@@ -83,6 +83,7 @@
             call_with_inference_limit/3,        % :Goal, +Limit, -Result
             rule/2,                             % :Head, -Rule
             rule/3,                             % :Head, -Rule, ?Ref
+            assertz_all/2,                      % :Template, :Goal
             numbervars/3,                       % +Term, +Start, -End
             term_string/3,                      % ?Term, ?String, +Options
             nb_setval/2,                        % +Var, +Value
@@ -106,7 +107,8 @@
     transaction(0,0,+),
     snapshot(0),
     rule(:, -),
-    rule(:, -, ?).
+    rule(:, -, ?),
+    assertz_all(:, 0).
 
 
                 /********************************
@@ -890,6 +892,12 @@ define_or_generate(Pred) :-
     '$get_predicate_attribute'(Pred, hide_childs, 1).
 '$predicate_property'(spying, Pred) :-
     '$get_predicate_attribute'(Pred, spy, 1).
+'$predicate_property'(columnar(Spec), Pred) :-
+    '$get_predicate_attribute'(Pred, columnar, Spec).
+'$predicate_property'(bloom_filter(Stats), Pred) :-
+    '$get_predicate_attribute'(Pred, bloom, Stats).
+'$predicate_property'(sharded(Spec), Pred) :-
+    '$get_predicate_attribute'(Pred, sharded, Spec).
 '$predicate_property'(number_of_clauses(N), Pred) :-
     '$get_predicate_attribute'(Pred, number_of_clauses, N).
 '$predicate_property'(number_of_rules(N), Pred) :-
@@ -1044,6 +1052,8 @@ clause_property(Clause, Property) :-
 %     - discontiguous(+Bool)
 %     - thread(+Mode)
 %     - volatile(+Bool)
+%     - bloom(+Bool)
+%     - sharded(+Spec)
 
 dynamic(M:Predicates, Options) :-
     '$must_be'(list, Predicates),
@@ -1089,6 +1099,8 @@ opt_prop(abstract,      between(0,0),          0,     abstract).
 opt_prop(multifile,     boolean,               true,  multifile).
 opt_prop(discontiguous, boolean,               true,  discontiguous).
 opt_prop(volatile,      boolean,               true,  volatile).
+opt_prop(bloom,         boolean,               Bool,  bloom(Bool)).
+opt_prop(sharded,       ground,                Spec,  sharded(Spec)).
 opt_prop(thread,        oneof(atom, [local,shared],[local,shared]),
                                                local, thread_local).
 
@@ -1207,6 +1219,12 @@ current_trie(Trie) :-
 %       Number of hashed nodes.
 %     - compiled_size(Bytes)
 %       Size of the compiled representation (if the trie is compiled)
+%     - memory_slabs(Count)
+%       Number of memory slabs from which the nodes are allocated
+%     - memory_slab_size(Bytes)
+%       Total size of the memory slabs
+%     - memory_slab_used(Bytes)
+%       Bytes of the memory slabs in use by nodes
 %     - lookup_count(Count)
 %       Number of data lookups on the trie
 %     - gen_call_count(Count)
@@ -1236,6 +1254,9 @@ trie_property(value_count(_)).
 trie_property(size(_)).
 trie_property(hashed(_)).
 trie_property(compiled_size(_)).
+trie_property(memory_slabs(_)).
+trie_property(memory_slab_size(_)).
+trie_property(memory_slab_used(_)).
                                                 % below only when -DO_TRIE_STATS
 trie_property(lookup_count(_)).                 % is enabled in pl-trie.h
 trie_property(gen_call_count(_)).
@@ -1453,6 +1474,17 @@ split_on_cut((Cond,!,Body), Cond, Body) :-
 split_on_cut((A,B), (A,Cond), Body) :-
     split_on_cut(B, Cond, Body).
 
+%!  assertz_all(:Template, :Goal) is det.
+%
+%   Add all instances of Template for which Goal succeeds as clauses.
+%   The instances are collected in batches of at most 10,000 clauses
+%   that are added using assertz_all/1, so the instances need not all
+%   be kept at the same time.
+
+assertz_all(M:Template, Goal) :-
+    forall(findnsols(10000, Template, Goal, Clauses),
+           assertz_all(M:Clauses)).
+
 
 
                  /*******************************
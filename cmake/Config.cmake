@@ -136,6 +136,7 @@ check_function_exists(vfork HAVE_VFORK)
 check_function_exists(qsort_r HAVE_QSORT_R)
 check_function_exists(qsort_s HAVE_QSORT_S)
 check_function_exists(getpagesize HAVE_GETPAGESIZE)
+check_function_exists(malloc_usable_size HAVE_MALLOC_USABLE_SIZE)
 # files
 check_function_exists(access HAVE_ACCESS)
 check_function_exists(chmod HAVE_CHMOD)
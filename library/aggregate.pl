@@ -136,8 +136,6 @@ _|The development of this library was sponsored by SecuritEase,
         *|different semantics|*.
 @tbd    Analysing the aggregation template and compiling a predicate
         for the list aggregation can be done at compile time.
-@tbd    aggregate_all/3 can be rewritten to run in constant space using
-        non-backtrackable assignment on a term.
 */
 
                  /*******************************
@@ -175,7 +173,8 @@ aggregate(Template, Discriminator, Goal0, Result) :-
 %
 %   The Template values `count`, sum(X),   max(X),  min(X), max(X,W) and
 %   min(X,W) are processed incrementally rather than using findall/3 and
-%   run in constant memory.
+%   run in constant memory. For set(X),  ground answers that are already
+%   in the result are not stored.
 
 aggregate_all(Var, _, _) :-
     var(Var),
@@ -183,73 +182,26 @@ aggregate_all(Var, _, _) :-
     instantiation_error(Var).
 aggregate_all(count, Goal, Count) :-
     !,
-    aggregate_all(sum(1), Goal, Count).
+    aggregate_all_bag(count, Goal, Count, Count).
 aggregate_all(sum(X), Goal, Sum) :-
     !,
-    State = state(0),
-    (  call(Goal),
-           arg(1, State, S0),
-           S is S0 + X,
-           nb_setarg(1, State, S),
-           fail
-    ;  arg(1, State, Sum)
-    ).
+    aggregate_all_bag(sum, Goal, X, Sum).
 aggregate_all(max(X), Goal, Max) :-
     !,
-    State = state(X),
-    (  call(Goal),
-           arg(1, State, M0),
-           M is max(M0,X),
-           nb_setarg(1, State, M),
-           fail
-    ;  arg(1, State, Max),
-           nonvar(Max)
-    ).
+    aggregate_all_bag(max, Goal, X, Max).
 aggregate_all(min(X), Goal, Min) :-
     !,
-    State = state(X),
-    (  call(Goal),
-           arg(1, State, M0),
-           M is min(M0,X),
-           nb_setarg(1, State, M),
-           fail
-    ;  arg(1, State, Min),
-           nonvar(Min)
-    ).
+    aggregate_all_bag(min, Goal, X, Min).
 aggregate_all(max(X,W), Goal, max(Max,Witness)) :-
     !,
-    State = state(false, _Max, _Witness),
-    (  call(Goal),
-           (   State = state(true, Max0, _)
-           ->  X > Max0,
-               nb_setarg(2, State, X),
-               nb_setarg(3, State, W)
-           ;   number(X)
-           ->  nb_setarg(1, State, true),
-               nb_setarg(2, State, X),
-               nb_setarg(3, State, W)
-           ;   type_error(number, X)
-           ),
-           fail
-    ;  State = state(true, Max, Witness)
-    ).
+    aggregate_all_bag(max_witness, Goal, X-W, Max-Witness).
 aggregate_all(min(X,W), Goal, min(Min,Witness)) :-
     !,
-    State = state(false, _Min, _Witness),
-    (  call(Goal),
-           (   State = state(true, Min0, _)
-           ->  X < Min0,
-               nb_setarg(2, State, X),
-               nb_setarg(3, State, W)
-           ;   number(X)
-           ->  nb_setarg(1, State, true),
-               nb_setarg(2, State, X),
-               nb_setarg(3, State, W)
-           ;   type_error(number, X)
-           ),
-           fail
-    ;  State = state(true, Min, Witness)
-    ).
+    aggregate_all_bag(min_witness, Goal, X-W, Min-Witness).
+aggregate_all(set(X), Goal, Set) :-
+    !,
+    findall_set(X, Goal, List),
+    sort(List, Set).
 aggregate_all(Template, Goal0, Result) :-
     template_to_pattern(all, Template, Pattern, Goal0, Goal, Aggregate),
     findall(Pattern, Goal, List),
@@ -259,16 +211,69 @@ aggregate_all(Template, Goal0, Result) :-
 %
 %   Aggregate  bindings  in  Goal   according    to   Template.  The
 %   aggregate_all/4 version performs findall/3 followed by sort/2 on
-%   Goal. See aggregate_all/3 to understand   why this predicate can
-%   fail.
+%   Goal, where ground duplicates are removed while collecting. See
+%   aggregate_all/3 to understand why this predicate can fail.
 
 aggregate_all(Template, Discriminator, Goal0, Result) :-
     template_to_pattern(all, Template, Pattern, Goal0, Goal, Aggregate),
-    findall(Discriminator-Pattern, Goal, Pairs0),
+    findall_set(Discriminator-Pattern, Goal, Pairs0),
     sort(Pairs0, Pairs),
     pairs_values(Pairs, List),
     aggregate_list(Aggregate, List, Result).
 
+%!  aggregate_all_bag(+Op, :Goal, +Templ, -Result) is semidet.
+%
+%   Run Goal as a failure driven loop, feeding the instances of Templ
+%   to an accumulator in C.  Op is one of `count`, `sum`, `max`, `min`,
+%   `max_witness` or `min_witness`.  The witness variants use Templ =
+%   X-W and return Result as Value-Witness.
+
+aggregate_all_bag(Op, Goal, Templ, Result) :-
+    setup_call_cleanup(
+        '$new_aggregate_bag'(Op),
+        aggregate_all_loop(Op, Goal, Templ, Result),
+        '$destroy_findall_bag').
+
+aggregate_all_loop(count, Goal, _, Count) :-
+    !,
+    (   call(Goal),
+        '$add_aggregate_bag'(_)
+    ;   '$collect_aggregate_bag'(Count)
+    ).
+aggregate_all_loop(Op, Goal, X-W, Value-Witness) :-
+    witness_op(Op),
+    !,
+    (   call(Goal),
+        '$add_aggregate_bag'(X, W)
+    ;   '$collect_aggregate_bag'(Value, Witness)
+    ).
+aggregate_all_loop(_, Goal, X, Value) :-
+    (   call(Goal),
+        '$add_aggregate_bag'(X)
+    ;   '$collect_aggregate_bag'(Value)
+    ).
+
+witness_op(max_witness).
+witness_op(min_witness).
+
+%!  findall_set(+Templ, :Goal, -List) is det.
+%
+%   As findall/3, but ground answers that are already in the bag are
+%   not added.  The result is not sorted and may contain duplicates if
+%   Templ is not ground.
+
+findall_set(Templ, Goal, List) :-
+    setup_call_cleanup(
+        '$new_aggregate_bag'(set),
+        findall_set_loop(Templ, Goal, List),
+        '$destroy_findall_bag').
+
+findall_set_loop(Templ, Goal, List) :-
+    (   call(Goal),
+        '$add_findall_bag'(Templ)
+    ;   '$collect_findall_bag'(List, [])
+    ).
+
 template_to_pattern(All, Template, Pattern, Goal0, Goal, Aggregate) :-
     template_to_pattern(Template, Pattern, Post, Vars, Aggregate),
     existential_vars(Goal0, Goal1, AllVars, Vars),
@@ -35,14 +35,26 @@
 
 :- module(prolog_jiti,
           [ jiti_list/0,
-            jiti_list/1                         % +Spec
+            jiti_list/1,                        % +Spec
+            jiti_statistics/2,                  % :Head, -Statistics
+            jiti_buckets/2,                     % :Head, -Histograms
+            jiti_hints/2,                       % :PI, -Hints
+            jiti_save_hints/1,                  % +File
+            jiti_save_hints/2,                  % +File, +Spec
+            jiti_load_hints/1                   % +File
           ]).
 :- autoload(library(apply),[maplist/2]).
 :- autoload(library(dcg/basics),[number/3]).
+:- autoload(library(error),[type_error/2]).
+:- autoload(library(lists),[member/2,last/2]).
 
 
 :- meta_predicate
-    jiti_list(:).
+    jiti_list(:),
+    jiti_statistics(:, -),
+    jiti_buckets(:, -),
+    jiti_hints(:, -),
+    jiti_save_hints(+, :).
 
 /** <module> Just In Time Indexing (JITI) utilities
 
@@ -79,57 +91,81 @@ by the system and can help diagnosing space and performance issues.
 %         terms with the same name/arity that may be used to create
 %         deep indexes.  The deep indexes themselves are created
 %         as just-in-time indexes.
+%     - _Lookups_ is the number of calls that used the index
+%     - _Hit%_ is the percentage of lookups that found a clause
+%     - _Scan_ is the average number of clauses examined per lookup
+%     - _ChP%_ is the percentage of lookups that left a choicepoint
+%     - _Chain_ is the length of the longest bucket chain
+%
+%   The usage figures are counted since the index was created while
+%   the Prolog flag `index_statistics` is `true`. See
+%   jiti_statistics/2 and jiti_buckets/2 for details.
 
 jiti_list :-
     jiti_list(_:_).
 
-jiti_list(Module:Name/Arity) :-
-    atom(Name),
-    integer(Arity),
-    !,
-    functor(Head, Name, Arity),
-    jiti_list(Module:Head).
-jiti_list(Module:Name/Arity) :-
-    atom(Name),
-    var(Arity),
-    !,
-    freeze(Head, functor(Head, Name, _)),
-    jiti_list(Module:Head).
-jiti_list(Module:Name) :-
-    atom(Name),
-    !,
-    freeze(Head, functor(Head, Name, _)),
-    jiti_list(Module:Head).
-jiti_list(Head) :-
+jiti_list(Spec) :-
+    spec_head(Spec, Head),
     findall(Head-Indexed,
             (   predicate_property(Head, indexed(Indexed)),
                 \+ predicate_property(Head, imported_from(_))
             ), Pairs),
-    format('Predicate~46|~w ~t~8+ ~t~w~6+ ~t~w~6+ ~t~w~5+~n',
-           ['Indexed','Buckets','Speedup','Flags']),
-    format('~`=t~76|~n'),
+    format('Predicate~t~48|~w~t~8+~t~w~8+~t~w~8+~t~w~6+\c
+            ~t~w~12+~t~w~6+~t~w~7+~t~w~6+~t~w~7+~n',
+           ['Indexed','Buckets','Speedup','Flags',
+            'Lookups','Hit%','Scan','ChP%','Chain']),
+    format('~`=t~116|~n'),
     maplist(print_indexed, Pairs).
 
 print_indexed((M:Head)-[Args-hash(Buckets,Speedup,_Size,List)|More]) :-
     functor(Head, Name, Arity),
+    index_usage(M:Name/Arity, Usage),
     phrase(iarg_spec(Args), ArgsS),
     phrase(iflags(List), Flags),
-    format('~q ~t~48|~s ~t~8+ ~t~D~6+ ~t~1f~8+ ~t~s~3+~n',
-           [M:Name/Arity, ArgsS,Buckets,Speedup,Flags]),
-    maplist(print_secondary_index, More),
+    usage_columns(Args, Usage, Columns),
+    format('~q ~t~48|~s~t~8+~t~D~8+~t~1f~8+~t~s~6+\c
+            ~t~w~12+~t~w~6+~t~w~7+~t~w~6+~t~w~7+~n',
+           [M:Name/Arity, ArgsS,Buckets,Speedup,Flags|Columns]),
+    maplist(print_secondary_index(Usage), More),
     !.
 print_indexed(Pair) :-
     format('Failed: ~p~n', [Pair]).
 
-print_secondary_index(Args-hash(Buckets,Speedup,_Size,List)) :-
+print_secondary_index(Usage, Args-hash(Buckets,Speedup,_Size,List)) :-
     phrase(iarg_spec(Args), ArgsS),
     phrase(iflags(List), Flags),
-    format('~t~48|~s ~t~8+ ~t~D~6+ ~t~1f~8+ ~t~s~3+~n',
-           [ArgsS,Buckets,Speedup,Flags]),
+    usage_columns(Args, Usage, Columns),
+    format('~t~48|~s~t~8+~t~D~8+~t~1f~8+~t~s~6+\c
+            ~t~w~12+~t~w~6+~t~w~7+~t~w~6+~t~w~7+~n',
+           [ArgsS,Buckets,Speedup,Flags|Columns]),
     !.
-print_secondary_index(Pair) :-
+print_secondary_index(_, Pair) :-
     format('Secondary failed: ~p~n', [Pair]).
 
+index_usage(PI, Usage) :-
+    '$index_statistics'(PI, Stats),
+    '$index_buckets'(PI, Histograms),
+    !,
+    findall(Args-usage(Counters, Chain),
+            ( member(Args-Counters, Stats),
+              memberchk(Args-Histogram, Histograms),
+              last(Histogram, Chain-_)
+            ),
+            Usage).
+index_usage(_, []).
+
+usage_columns(Args, Usage, [Lookups, HitP, Scan, ChPP, Chain]) :-
+    memberchk(Args-usage(index_stats(Lookups, Hits, Scanned, ChPs), Chain),
+              Usage),
+    !,
+    (   Lookups > 0
+    ->  format(atom(HitP), '~0f', [100*Hits/Lookups]),
+        format(atom(Scan), '~1f', [Scanned/Lookups]),
+        format(atom(ChPP), '~0f', [100*ChPs/Lookups])
+    ;   HitP = '-', Scan = '-', ChPP = '-'
+    ).
+usage_columns(_, _, ['-', '-', '-', '-', '-']).
+
 iarg_spec(single(N)) -->
     number(N).
 iarg_spec(multi(L)) -->
@@ -156,3 +192,144 @@ deep_list([H|T]) -->
 
 iflags(true)  --> "L".
 iflags(false) --> "".
+
+
+%!  jiti_statistics(:Head, -Statistics) is nondet.
+%
+%   True when Statistics describes the usage of   the indexes of the
+%   predicate Head. Head may be partially  instantiated, in which case
+%   this enumerates all  matching  predicates   that  have  indexes.
+%   Statistics is a list of terms
+%
+%       Indexed-index_stats(Lookups, Hits, Scanned, ChoicePoints)
+%
+%   where Indexed is  the  same  as   for  the  predicate  property
+%   indexed(Indexed) (see predicate_property/2), Lookups is the number
+%   of calls that used the index, Hits the  number of these that found
+%   a clause, Scanned the total number of  clause references examined
+%   and ChoicePoints the number  of   lookups  that left a choicepoint.
+%   The counters start at zero when  the   index  is  created and are
+%   only updated by threads for  which   the  Prolog flag
+%   `index_statistics` is `true`. They are maintained without
+%   synchronization, so they are approximate if the predicate is used
+%   by multiple threads.   Reading the counters is
+%   cheap and this predicate may be used   to poll the behaviour of an
+%   application in production.
+
+jiti_statistics(M:Head, Stats) :-
+    indexed_predicate(M:Head, PI),
+    '$index_statistics'(PI, Stats).
+
+%!  jiti_buckets(:Head, -Histograms) is nondet.
+%
+%   True when Histograms describes the distribution of the clauses
+%   over the buckets of the indexes of the predicate Head.  Histograms
+%   is a list Indexed-Histogram, where Histogram is an ordered list of
+%   Length-Count, telling that Count buckets hold Length clauses. Long
+%   chains indicate skewed keys or too few buckets.  Unlike
+%   jiti_statistics/2, this scans the entire index.
+
+jiti_buckets(M:Head, Histograms) :-
+    indexed_predicate(M:Head, PI),
+    '$index_buckets'(PI, Histograms).
+
+indexed_predicate(M:Head, M:Name/Arity) :-
+    predicate_property(M:Head, indexed(_)),
+    \+ predicate_property(M:Head, imported_from(_)),
+    functor(Head, Name, Arity).
+
+
+spec_head(Module:Name/Arity, Module:Head) :-
+    atom(Name),
+    integer(Arity),
+    !,
+    functor(Head, Name, Arity).
+spec_head(Module:Name/Arity, Module:Head) :-
+    atom(Name),
+    var(Arity),
+    !,
+    freeze(Head, functor(Head, Name, _)).
+spec_head(Module:Name, Module:Head) :-
+    atom(Name),
+    !,
+    freeze(Head, functor(Head, Name, _)).
+spec_head(Head, Head).
+
+
+		 /*******************************
+		 *            HINTS		*
+		 *******************************/
+
+%!  jiti_hints(:PI, -Hints) is semidet.
+%
+%   Hints is a list of  terms hash(Args, Buckets, Speedup, IsList) that
+%   describe the primary (first  level)   just-in-time  indexes  of the
+%   predicate PI. Args is a  list   of  1-based argument positions. The
+%   list is empty if no  indexes  have   been  created.  Fails if PI is
+%   not a defined Prolog predicate.
+%
+%   Index hints are saved with  the   predicate  in saved states (see
+%   qsave_program/2) and .qlf files, such that  the index is created as
+%   soon as the predicate is loaded.
+
+jiti_hints(PI, Hints) :-
+    '$index_hints'(PI, Hints).
+
+%!  jiti_save_hints(+File) is det.
+%!  jiti_save_hints(+File, :Spec) is det.
+%
+%   Save the primary  just-in-time  indexes   of  all  predicates or the
+%   predicates matching Spec (see jiti_list/1) to File. The hints can be
+%   loaded into another process using   jiti_load_hints/1.  This allows
+%   for preparing the indexes of a  long   running  process from a test
+%   run without waiting for the first calls to create them.
+
+jiti_save_hints(File) :-
+    jiti_save_hints(File, _:_).
+
+jiti_save_hints(File, Spec) :-
+    spec_head(Spec, Head),
+    findall(index_hints(PI, Hints),
+            predicate_hints(Head, PI, Hints),
+            Terms),
+    setup_call_cleanup(
+        open(File, write, Out, [encoding(utf8)]),
+        forall(member(Term, Terms),
+               format(Out, '~q.~n', [Term])),
+        close(Out)).
+
+predicate_hints(M:Head, M:Name/Arity, Hints) :-
+    predicate_property(M:Head, indexed(_)),
+    \+ predicate_property(M:Head, imported_from(_)),
+    functor(Head, Name, Arity),
+    '$index_hints'(M:Name/Arity, Hints),
+    Hints \== [].
+
+%!  jiti_load_hints(+File) is det.
+%
+%   Create the indexes described in  File,   which  is  typically created
+%   using jiti_save_hints/1. Hints for  predicates   that  do  not exist
+%   or have no clauses are ignored.
+
+jiti_load_hints(File) :-
+    setup_call_cleanup(
+        open(File, read, In, [encoding(utf8)]),
+        load_hints(In),
+        close(In)).
+
+load_hints(In) :-
+    read_term(In, Term, []),
+    (   Term == end_of_file
+    ->  true
+    ;   Term = index_hints(PI, Hints)
+    ->  (   PI = M:Name/Arity,
+            atom(M), atom(Name), integer(Arity),
+            functor(Head, Name, Arity),
+            current_predicate(_, M:Head),
+            \+ predicate_property(M:Head, imported_from(_))
+        ->  '$set_index_hints'(PI, Hints)
+        ;   true
+        ),
+        load_hints(In)
+    ;   type_error(index_hints, Term)
+    ).
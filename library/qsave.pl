@@ -660,6 +660,17 @@ save_module(M, SaveClass) :-
         feedback('~n', [])
     ).
 
+save_predicate(P, _SaveClass) :-
+    predicate_property(P, columnar(Spec)),
+    !,
+    P = (M:_),
+    functor(Spec, Name, Arity),
+    feedback('~ndeclaring columnar ~w/~d ', [Name, Arity]),
+    '$add_directive_wic'(columnar(M:Spec)),
+    (   no_save(P)
+    ->  true
+    ;   save_columnar_rows(M, Name, Arity)
+    ).
 save_predicate(P, _SaveClass) :-
     predicate_property(P, foreign),
     !,
@@ -692,9 +703,48 @@ save_predicate(P, SaveClass) :-
             '$qlf_assert_clause'(Ref, SaveClass),
             fail
         ;   true
-        )
+        ),
+        save_index_hints(P)
+    ).
+
+%!  save_index_hints(+Head) is det.
+%
+%   Save the primary clause indexes   created for Head, such that these
+%   are created immediately when loading the state.
+
+save_index_hints(M:H) :-
+    functor(H, Name, Arity),
+    (   '$index_hints'(M:Name/Arity, Hints),
+        Hints \== []
+    ->  '$add_directive_wic'('$set_index_hints'(M:Name/Arity, Hints))
+    ;   true
     ).
 
+%!  save_columnar_rows(+Module, +Name, +Arity) is det.
+%
+%   Save the rows of a columnar predicate   as  directives that restore
+%   them using assertz_all/1.  Each  directive   holds  a chunk of rows
+%   to avoid a directive per row.
+
+save_columnar_rows(M, Name, Arity) :-
+    functor(Head, Name, Arity),
+    findall(Head, M:Head, Rows),
+    save_row_chunks(Rows, M).
+
+save_row_chunks([], _) :- !.
+save_row_chunks(Rows, M) :-
+    length(Chunk, 1000),
+    append(Chunk, Rest, Rows),
+    !,
+    save_row_chunk(Chunk, M),
+    save_row_chunks(Rest, M).
+save_row_chunks(Rows, M) :-
+    save_row_chunk(Rows, M).
+
+save_row_chunk(Rows, M) :-
+    feedback('.', []),
+    '$add_directive_wic'(system:assertz_all(M:Rows)).
+
 no_save(P) :-
     predicate_property(P, volatile),
     \+ predicate_property(P, dynamic),
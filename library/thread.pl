@@ -49,10 +49,11 @@
           ]).
 :- autoload(library(apply),[maplist/2,maplist/3,maplist/4,maplist/5]).
 :- autoload(library(error),[must_be/2]).
-:- autoload(library(lists),[subtract/3,same_length/2]).
+:- autoload(library(lists),[subtract/3,same_length/2,append/3]).
 :- autoload(library(option),[option/2, option/3]).
 :- autoload(library(ordsets), [ord_intersection/3]).
 :- autoload(library(debug), [debug/3, assertion/1]).
+:- autoload(library(aggregate), [aggregate_all/3]).
 
 %:- debug(concurrent).
 
@@ -314,11 +315,12 @@ join_all([Id|T]) :-
 %       Number of threads to use.  The default is determined by the
 %       Prolog flag `cpu_count`.
 %
-%   @tbd Ideally we would grow the   set of workers dynamically, similar
-%   to dynamic scheduling of  HTTP  worker   threads.  This  would avoid
-%   creating threads that are never used if Generate is too slow or does
-%   not provide enough answers and  would   further  raise the number of
-%   threads if Action is I/O bound rather than CPU bound.
+%   The Action goals are executed by threads from the pool of workers
+%   that is shared with concurrent_maplist/2. If less than Count pool
+%   workers are idle, the pool is extended. If an Action fails or raises
+%   an exception, Actions that are already running in other workers run
+%   to completion.  If concurrent_forall/3 is called from a pool worker it
+%   acts as forall/2 to avoid waiting for the pool from inside the pool.
 
 :- dynamic
     fa_aborted/1.
@@ -329,6 +331,7 @@ concurrent_forall(Generate, Test) :-
 concurrent_forall(Generate, Test, Options) :-
     jobs(Jobs, Options),
     Jobs > 1,
+    \+ in_pool_worker,
     !,
     term_variables(Generate, GVars),
     term_variables(Test, TVars),
@@ -338,28 +341,35 @@ concurrent_forall(Generate, Test, Options) :-
     Templ =.. [v|Shared],
     MaxSize is Jobs*4,
     message_queue_create(Q, [max_size(MaxSize)]),
-    length(Workers, Jobs),
+    message_queue_create(Done),
     thread_self(Me),
-    maplist(thread_create(fa_worker(Q, Me, Templ, Test)), Workers),
-    catch(( forall(Generate,
+    catch(( forall(between(1, Jobs, _),
+                   pool_send(forall(Q, Done, Me, Templ, Test))),
+            forall(Generate,
                    thread_send_message(Q, job(Templ))),
             forall(between(1, Jobs, _),
                    thread_send_message(Q, done)),
-            maplist(thread_join, Workers),
-            message_queue_destroy(Q)
+            forall(between(1, Jobs, _),
+                   thread_get_message(Done, finished)),
+            message_queue_destroy(Q),
+            message_queue_destroy(Done)
           ),
           Error,
-          fa_cleanup(Error, Workers, Q)).
+          fa_cleanup(Error, Q, Done)).
 concurrent_forall(Generate, Test, _) :-
     forall(Generate, Test).
 
-fa_cleanup(Error, Workers, Q) :-
-    maplist(safe_abort, Workers),
-    debug(concurrent(fail), 'Joining workers', []),
-    maplist(safe_join, Workers),
-    debug(concurrent(fail), 'Destroying queue', []),
-    retractall(fa_aborted(Q)),
-    message_queue_destroy(Q),
+%   Destroying the job queue makes the workers return to the pool after
+%   finishing their current Action.  This is synchronized with fa_stop/3
+%   to avoid signalling this thread after the cleanup.
+
+fa_cleanup(Error, Q, Done) :-
+    debug(concurrent(fail), 'Destroying queues', []),
+    with_mutex('$concurrent_forall',
+               ( retractall(fa_aborted(Q)),
+                 message_queue_destroy(Q)
+               )),
+    message_queue_destroy(Done),
     (   Error = fa_worker_failed(_0Test, Why)
     ->  debug(concurrent(fail), 'Test ~p failed: ~p', [_0Test, Why]),
         (   Why == false
@@ -393,7 +403,10 @@ fa_stop(Queue, Main, Why) :-
                fa_stop_sync(Queue, Main, Why)).
 
 fa_stop_sync(Queue, _Main, _Why) :-
-    fa_aborted(Queue),
+    (   fa_aborted(Queue)
+    ->  true
+    ;   \+ catch(message_queue_property(Queue, size(_)), error(_,_), fail)
+    ),
     !.
 fa_stop_sync(Queue, Main, Why) :-
     asserta(fa_aborted(Queue)),
@@ -547,8 +560,7 @@ ca_cleanup(GenThread, Workers, JobQueue, AnswerQueue) :-
 %!  concurrent_maplist(:Goal, +List1, +List2) is semidet.
 %!  concurrent_maplist(:Goal, +List1, +List2, +List3) is semidet.
 %
-%   Concurrent version of maplist/2. This   predicate uses concurrent/3,
-%   using multiple _worker_ threads.  The  number   of  threads  is  the
+%   Concurrent version of maplist/2. The  number   of  threads  is  the
 %   minimum of the list length and the   number  of cores available. The
 %   number of cores is determined using  the prolog flag =cpu_count=. If
 %   this flag is absent or 1 or List   has  less than two elements, this
@@ -556,15 +568,19 @@ ca_cleanup(GenThread, Workers, JobQueue, AnswerQueue) :-
 %   based on once/1. Note that all goals   are executed as if wrapped in
 %   once/1 and therefore these predicates are _semidet_.
 %
-%   Note that the the overhead  of   this  predicate is considerable and
-%   therefore Goal must  be  fairly  expensive   before  one  reaches  a
-%   speedup.
+%   The list is split into chunks that are executed by the calling
+%   thread and threads from a persistent pool of workers.  Each thread
+%   starts with an equal share of the chunks and takes chunks from the
+%   thread with most remaining work if it runs out of work.  All goals
+%   are copied once when the work is distributed and the bindings of
+%   goals executed by pool workers are copied back, so Goal must still
+%   be more expensive than copying its arguments to obtain a speedup.
 
 concurrent_maplist(Goal, List) :-
     workers(List, WorkerCount),
     !,
     maplist(ml_goal(Goal), List, Goals),
-    concurrent(WorkerCount, Goals, []).
+    pool_map(WorkerCount, Goals).
 concurrent_maplist(M:Goal, List) :-
     maplist(once_in_module(M, Goal), List).
 
@@ -578,7 +594,7 @@ concurrent_maplist(Goal, List1, List2) :-
     workers(List1, WorkerCount),
     !,
     maplist(ml_goal(Goal), List1, List2, Goals),
-    concurrent(WorkerCount, Goals, []).
+    pool_map(WorkerCount, Goals).
 concurrent_maplist(M:Goal, List1, List2) :-
     maplist(once_in_module(M, Goal), List1, List2).
 
@@ -592,7 +608,7 @@ concurrent_maplist(Goal, List1, List2, List3) :-
     workers(List1, WorkerCount),
     !,
     maplist(ml_goal(Goal), List1, List2, List3, Goals),
-    concurrent(WorkerCount, Goals, []).
+    pool_map(WorkerCount, Goals).
 concurrent_maplist(M:Goal, List1, List2, List3) :-
     maplist(once_in_module(M, Goal), List1, List2, List3).
 
@@ -614,6 +630,206 @@ same_length([_|T1], [_|T2], [_|T3]) :-
     same_length(T1, T2, T3).
 
 
+                 /*******************************
+                 *          WORKER POOL         *
+                 *******************************/
+
+%   The pool of workers is shared by concurrent_maplist/2,3,4 and
+%   concurrent_forall/2,3.  Workers are detached threads with an alias
+%   '__concurrent_worker_<N>' that wait for tasks on their thread message
+%   queue and are created on demand.  A caller claims an idle worker by
+%   retracting pool_idle/1 and sends it a task.  A worker
+%   asserts pool_idle/1 again after completing its task, so concurrent
+%   callers never wait for each other's workers.  Workers that are
+%   created because all others are busy terminate after their task if
+%   the pool already has `cpu_count` idle workers.  Idle workers
+%   terminate after 10 seconds without a task.
+
+:- dynamic
+    pool_worker/1,
+    pool_idle/1.
+
+%!  pool_send(+Task) is det.
+%
+%   Claim an idle worker from the pool,   or create a new worker, and
+%   send it Task.  Claiming and sending  run   with  signals delayed, so
+%   an exception cannot leave a worker  claimed without a task.  If the
+%   task cannot be sent, the worker is returned to the pool.
+
+pool_send(Task) :-
+    '$sig_atomic'(pool_claim_send(Task)).
+
+pool_claim_send(Task) :-
+    (   retract(pool_idle(W))
+    ->  true
+    ;   new_pool_worker(W)
+    ),
+    catch(thread_send_message(W, Task), E,
+          ( assertz(pool_idle(W)),
+            throw(E)
+          )).
+
+new_pool_worker(Id) :-
+    gensym('__concurrent_worker_', Alias),
+    thread_create(pool_worker, Id,
+                  [ alias(Alias),
+                    detached(true),
+                    at_exit(pool_worker_exit)
+                  ]),
+    assertz(pool_worker(Id)).
+
+pool_worker_exit :-
+    thread_self(Me),
+    retractall(pool_idle(Me)),
+    retractall(pool_worker(Me)).
+
+in_pool_worker :-
+    thread_self(Me),
+    pool_worker(Me).
+
+%!  pool_worker
+%
+%   Main loop of a pool worker.  After each task the worker returns
+%   itself to the pool of idle workers or terminates if there are
+%   enough idle workers.  An idle worker also terminates if it receives
+%   no task for 10 seconds.  If a caller claimed the worker just before
+%   that, the worker keeps running and waits for the task.  Tasks are
+%
+%     - map(+Job, +Slot, +Done)
+%       Execute chunks from the pool job Job for Slot and send the
+%       result of each chunk to the queue Done.
+%     - forall(+Queue, +Done, +Main, +Templ, +Test)
+%       Execute jobs for concurrent_forall/3 until Queue delivers `done`
+%       or is destroyed.  Send `finished` to Done.
+
+pool_worker :-
+    thread_self(Me),
+    repeat,
+      (   thread_get_message(Me, Task, [timeout(10)])
+      ->  debug(concurrent, 'Pool worker: received ~p', [Task]),
+          ignore(catch(pool_run(Task), _, true)),
+          (   with_mutex('$concurrent_pool', pool_return(Me))
+          ->  fail
+          ;   !
+          )
+      ;   retract(pool_idle(Me))
+      ->  !
+      ;   fail
+      ).
+
+pool_return(Me) :-
+    aggregate_all(count, pool_idle(_), Idle),
+    current_prolog_flag(cpu_count, Max),
+    Idle < max(Max, 1),
+    assertz(pool_idle(Me)).
+
+pool_run(map(Job, Slot, Done)) :-
+    repeat,
+    (   '$pool_job_next'(Job, Slot, I)
+    ->  \+ map_chunk(Job, I, Done)
+    ;   true
+    ),
+    !.
+pool_run(forall(Queue, Done, Main, Templ, Test)) :-
+    catch(fa_worker(Queue, Main, Templ, Test),
+          error(existence_error(message_queue, _), _),
+          true),
+    catch(thread_send_message(Done, finished), error(_,_), true).
+
+map_chunk(Job, I, Done) :-
+    '$pool_job_chunk'(Job, I, chunk(Goals, Vars)),
+    (   catch(run_goals(Goals), E, true)
+    ->  (   var(E)
+        ->  Reply = done(I, Vars)
+        ;   Reply = error(E)
+        )
+    ;   Reply = failed
+    ),
+    catch(thread_send_message(Done, Reply), error(_,_), true),
+    (   Reply = done(_,_)
+    ->  true
+    ;   '$pool_job_abort'(Job),
+        fail
+    ).
+
+run_goals([]).
+run_goals([H|T]) :-
+    call(H),
+    !,
+    run_goals(T).
+
+%!  pool_map(+Slots, +Goals) is semidet.
+%
+%   Run Goals using the calling thread and Slots-1 pool workers.  Goals
+%   is split into at most 8 chunks per slot.  The chunks are
+%   distributed by a pool job (see '$pool_job_create'/3), which lets
+%   slots that run out of work steal chunks from other slots.  As any
+%   chunk may be stolen by a worker, the job records all chunks when it
+%   is created.  Chunks executed by the calling thread nevertheless run
+%   the original goals and bind the variables of Goals directly.  For
+%   the other chunks the bindings are sent back as done(Index, Vars).
+
+pool_map(Slots, Goals) :-
+    length(Goals, Len),
+    Count is min(Len, Slots*8),
+    split_chunks(0, Count, Len, Goals, Chunks),
+    '$pool_job_create'(Chunks, Slots, Job),
+    ChunkTerm =.. [chunks|Chunks],
+    NWorkers is Slots-1,
+    setup_call_cleanup(
+        message_queue_create(Done),
+        ( forall(between(1, NWorkers, Slot),
+                 pool_send(map(Job, Slot, Done))),
+          map_own(Job, ChunkTerm, 0, Own),
+          Left is Count-Own,
+          map_wait(Left, Done, ChunkTerm)
+        ),
+        ( '$pool_job_abort'(Job),
+          message_queue_destroy(Done)
+        )).
+
+split_chunks(Count, Count, _, [], []) :-
+    !.
+split_chunks(K, Count, Len, Goals, [chunk(Chunk, Vars)|Chunks]) :-
+    Size is (Len*(K+1))//Count - (Len*K)//Count,
+    length(Chunk, Size),
+    append(Chunk, Rest, Goals),
+    term_variables(Chunk, Vars),
+    K1 is K+1,
+    split_chunks(K1, Count, Len, Rest, Chunks).
+
+map_own(Job, Chunks, N0, N) :-
+    (   '$pool_job_next'(Job, 0, I)
+    ->  arg(I, Chunks, chunk(Goals, _)),
+        (   run_goals(Goals)
+        ->  true
+        ;   '$pool_job_abort'(Job),
+            fail
+        ),
+        N1 is N0+1,
+        map_own(Job, Chunks, N1, N)
+    ;   N = N0
+    ).
+
+map_wait(0, _, _) :-
+    !.
+map_wait(N, Done, Chunks) :-
+    thread_get_messages(Done, Replies, []),
+    map_replies(Replies, Chunks, N, N1),
+    map_wait(N1, Done, Chunks).
+
+map_replies([], _, N, N).
+map_replies([H|T], Chunks, N0, N) :-
+    (   H = done(I, Vars)
+    ->  arg(I, Chunks, chunk(_, Vars)),
+        N1 is N0-1,
+        map_replies(T, Chunks, N1, N)
+    ;   H = error(E)
+    ->  throw(E)
+    ;   fail
+    ).
+
+
                  /*******************************
                  *             FIRST            *
                  *******************************/
@@ -459,6 +459,7 @@ PL_EXPORT(term_t)	PL_yielded(qid_t qid);
 #define PL_CREATE_INCREMENTAL	0x0020
 
 PL_EXPORT(int)		PL_assert(term_t term, module_t m, int flags);
+PL_EXPORT(int)		PL_assert_all(term_t clauses, module_t m, int flags);
 
 
 
@@ -50,7 +50,9 @@ test_arith :-
 		    float_overflow,
 		    float_zero,
 		    float_special,
-		    arith_misc
+		    int128,
+		    arith_misc,
+		    float_vmi
 		  ]).
 
 :- begin_tests(div).
@@ -454,6 +456,39 @@ test(cmp, fail) :-
 
 :- end_tests(float_special).
 
+:- begin_tests(int128, [condition(current_prolog_flag(bounded, false))]).
+
+test(add, X == 18446744073709551616) :-
+	A is 2**64-1,
+	X is A+1.
+test(sub, X == 9223372036854775807) :-
+	A is 2**64,
+	X is A-(2**63+1).
+test(sub, X == -36893488147419103232) :-
+	A is -(2**63),
+	X is A-(2**63)-(2**63)-(2**63).
+test(mul, X == 42535295865117307932921825928971026432) :-
+	A is 2**63,
+	X is A*(2**62).
+test(mul, X == 85070591730234615865843651857942052864) :-
+	A is -(2**63),
+	X is A*A.
+test(mul, X == -85070591730234615865843651857942052870) :-
+	A is 2**125+3,
+	X is A * -2.
+test(mul, X == 1219326311370217952237463801111263526900) :-
+	A = 12345678901234567890,
+	X is A*98765432109876543210.
+test(add, X == 170141183460469231731687303715884105726) :-
+	A is 2**126-1,
+	X is A+A.
+test(normalise, X == 42) :-
+	A is 2**64+42,
+	X is A-(2**64),
+	integer(X).
+
+:- end_tests(int128).
+
 :- begin_tests(arith_misc).
 
 test(string) :-
@@ -465,3 +500,56 @@ test(float_rval) :-
 	6.5 is max(6.5,3).
 
 :- end_tests(arith_misc).
+
+:- begin_tests(float_vmi).
+
+% Compiled with optimise=true (see arith_misc), using A_*_F instructions
+
+fv_add(X, Y) :- Y is X + 1.5.
+fv_sub(X, Y) :- Y is 10.0 - X.
+fv_mul(X, Y) :- Y is X * 10.0.
+fv_div(X, Y) :- Y is X / 2.0.
+fv_poly(X, Y) :- float(X), Y is X*X - 2*X + 1.
+
+fv_vm(Head, Names) :-
+	clause(Head, _, Ref),
+	fv_vm(Ref, 0, Names).
+
+fv_vm(Ref, PC, [Name|T]) :-
+	'$fetch_vm'(Ref, PC, NPC, I),
+	!,
+	functor(I, Name, _),
+	fv_vm(Ref, NPC, T).
+fv_vm(_, _, []).
+
+test(compile, true) :-
+	fv_vm(fv_poly(_,_), Names),
+	memberchk(a_mul_f, Names),
+	memberchk(a_sub_f, Names),
+	memberchk(a_add_f, Names).
+test(float, Y == 4.0) :-
+	fv_add(2.5, Y).
+test(int, Y == 3.5) :-
+	fv_add(2, Y).
+test(bigint, Y =:= 2**100+1.5) :-
+	fv_add(2**100, Y).
+test(rational, Y == 7.5) :-
+	fv_div(15r1, Y).
+test(expr, Y == 7.0) :-
+	fv_sub(1+2, Y).
+test(poly, Y == 2.25) :-
+	fv_poly(2.5, Y).
+test(overflow, error(evaluation_error(float_overflow))) :-
+	fv_mul(1.0e308, _).
+test(overflow_flag, Y =:= inf) :-
+	setup_call_cleanup(
+	    set_prolog_flag(float_overflow, infinity),
+	    fv_mul(1.0e308, Y),
+	    set_prolog_flag(float_overflow, error)).
+test(zero_div, error(evaluation_error(zero_divisor))) :-
+	X = 0.0,
+	_ is 1.0/X.
+test(type, error(type_error(evaluable, foo/0))) :-
+	fv_add(foo, _).
+
+:- end_tests(float_vmi).
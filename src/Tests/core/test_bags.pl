@@ -87,4 +87,39 @@ gen_atom(A) :-
 	between(1, infinite, X),
 	atom_concat(aaaa, X, A).
 
+% Atoms and small integers are stored in the bag without a record.
+% Check they are kept in order with answers that need a record.
+
+test(mixed, Xs =@= [a, 1, f(_), "s", 2.0, b, -5, g(A,A), [], 1<<70]) :-
+	findall(X, member(X, [a, 1, f(_), "s", 2.0, b, -5, g(B,B), [], 1<<70]),
+		Xs),
+	var(B).
+test(mixed_tail, Xs == [1, a, f(1), 2, b, f(2), tail]) :-
+	findall(X, ( between(1, 2, I),
+		     nth1(I, [a,b], A),
+		     member(X, [I, A, f(I)])
+		   ), Xs, [tail]).
+test(mixed_bagof, Groups == [a-[1, f(x), foo, 3], b-[bar, g(y, 2)]]) :-
+	findall(K-L,
+		bagof(X, member(K-X, [a-1, b-bar, a-f(x), a-foo, b-g(y,2), a-3]),
+		      L),
+		Groups).
+test(mixed_setof, L == [1, 3, bar, foo, f(x)]) :-
+	setof(X, member(X, [foo, 3, f(x), bar, 1, foo, f(x), 3]), L).
+test(agc_inline, Strings == Expected) :-
+	findall(X, ( between(1, 1000, I),
+		     format(atom(X), 'bag_agc_~d', [I]),
+		     (   I == 500
+		     ->  garbage_collect_atoms
+		     ;   true
+		     )
+		   ), Xs),
+	garbage_collect_atoms,
+	maplist(atom_string, Xs, Strings),
+	numlist(1, 1000, Is),
+	maplist(bag_agc_string, Is, Expected).
+
+bag_agc_string(I, S) :-
+	format(string(S), 'bag_agc_~d', [I]).
+
 :- end_tests(bags).
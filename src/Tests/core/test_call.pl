@@ -48,6 +48,8 @@ test_call :-
 		    apply,
 		    callN,
 		    cross_module_call,
+		    call_cache,
+		    fused_call,
 		    at2,
 		    snip,
 		    no_autoload,
@@ -175,6 +177,69 @@ test(c_cm2, X == test_call) :-
 :- end_tests(cross_module_call).
 
 
+:- begin_tests(call_cache, [ cleanup(( retractall(ccache1:cc_p(_)),
+					retractall(ccache2:cc_p(_))
+				      ))
+			    ]).
+
+:- dynamic user:cc_p/1.
+user:cc_p(user).
+
+cc_call(M, X) :-			% single call site
+	M:call(cc_p, X).
+
+cc_calls(M, L) :-
+	findall(X, (between(1, 3, _), cc_call(M, X)), L).
+
+test(redefine, L1-L2 == [user,user,user]-[local,local,local]) :-
+	cc_calls(ccache1, L1),
+	assertz(ccache1:cc_p(local)),
+	cc_calls(ccache1, L2).
+test(import, L1-L2 == [user,user,user]-[ccache2,ccache2,ccache2]) :-
+	cc_calls(ccache3, L1),
+	assertz(ccache2:cc_p(ccache2)),
+	add_import_module(ccache3, ccache2, start),
+	cc_calls(ccache3, L2),
+	delete_import_module(ccache3, ccache2).
+test(hits, true(H1 >= H0+100)) :-
+	statistics(call_cache_hits, H0),
+	forall(between(1, 100, _), cc_call(user, _)),
+	statistics(call_cache_hits, H1).
+
+:- end_tests(call_cache).
+
+
+:- begin_tests(fused_call).
+
+fc_color(red).
+fc_color(green).
+
+fc_neq(A, B) :- A \== B.
+
+fc_pair(X, Y) :- fc_color(X), fc_color(Y), fc_neq(X, Y).
+
+vm_names(Head, Names) :-
+	clause(Head, _, Ref),
+	vm_names(Ref, 0, Names).
+
+vm_names(Ref, PC, [Name|T]) :-
+	'$fetch_vm'(Ref, PC, NPC, I),
+	!,
+	functor(I, Name, _),
+	vm_names(Ref, NPC, T).
+vm_names(_, _, []).
+
+test(run, L == [red-green, green-red]) :-
+	findall(X-Y, fc_pair(X, Y), L).
+test(decode, Names == [i_enter,b_var0,i_call,b_var1,i_call,l_nolco,i_lcall,
+		       b_var0,b_var1,i_depart,i_exit]) :-
+	vm_names(fc_pair(_,_), Names).
+test(decode, Names == [h_atom,i_exitfact]) :-
+	vm_names(fc_color(red), Names).
+
+:- end_tests(fused_call).
+
+
 :- begin_tests(at2).
 
 :- op(900, xfx, @).
@@ -47,7 +47,9 @@ test_db :-
 		    retractall,
 		    dynamic,
 		    protect,
-		    res_compiler
+		    res_compiler,
+		    columnar,
+		    sharded
 		  ]).
 
 :- begin_tests(assert).
@@ -93,6 +95,53 @@ test(cut_cond, Body = (! -> fail)) :-
 
 :- end_tests(assert).
 
+:- begin_tests(assertz_all).
+
+:- dynamic
+	bulk/2, bulk2/1.
+
+test(list, [ L-N == [3,6,9]-1000,
+	     cleanup(retractall(bulk(_,_)))
+	   ]) :-
+	assertz(bulk(a, 0)),
+	numlist(1, 999, Is),
+	findall(bulk(K,I), (member(I,Is), K is I mod 3), Clauses),
+	assertz_all(Clauses),
+	predicate_property(bulk(_,_), number_of_clauses(N)),
+	findall(V, (bulk(0, V), V < 10), L).
+test(mixed, [ L1-L2 == [1,2]-[x,y],
+	      cleanup((retractall(bulk(_,_)), retractall(bulk2(_))))
+	    ]) :-
+	assertz_all([bulk2(x), bulk(1,a), (bulk(2,b) :- true), bulk2(y)]),
+	findall(X, bulk(X,_), L1),
+	findall(X, bulk2(X), L2).
+test(generator, [ L == [1,4,9],
+		  cleanup(retractall(bulk2(_)))
+		]) :-
+	assertz_all(bulk2(X2), (between(1,3,X), X2 is X*X)),
+	findall(X, bulk2(X), L).
+test(batches, [ L == Is,
+		cleanup(retractall(bulk2(_)))
+	      ]) :-
+	assertz_all(bulk2(X), between(1, 25000, X)),
+	findall(X, bulk2(X), L),
+	numlist(1, 25000, Is).
+test(no_solutions, [ \+ bulk2(_),
+		     cleanup(retractall(bulk2(_)))
+		   ]) :-
+	assertz_all(bulk2(_), fail).
+test(static, [ error(permission_error(modify, static_procedure, _)),
+	       cleanup(retractall(bulk2(_)))
+	     ]) :-
+	assertz_all([bulk2(1), test_db]).
+test(partial, [ fail,
+		cleanup(retractall(bulk2(_)))
+	      ]) :-
+	catch(assertz_all([bulk2(1)|foo]), error(type_error(list, foo), _), true),
+	bulk2(_).
+
+:- end_tests(assertz_all).
+
 :- begin_tests(retract).
 
 :- dynamic foo/1, insect/1, icopy/1.
@@ -238,3 +287,127 @@ test(big_clause,
 	test_big_clause(60000).
 
 :- end_tests(res_compiler).
+
+
+:- begin_tests(columnar).
+
+:- columnar(ctab(atom, integer, float)).
+
+fill_ctab(N) :-
+	retractall(ctab(_,_,_)),
+	forall(between(1, N, I),
+	       ( K is I mod 10,
+		 atom_concat(k, K, A),
+		 F is I/2.0,
+		 assertz(ctab(A, I, F))
+	       )).
+
+test(enum, L == [3,13,23]) :-
+	fill_ctab(30),
+	findall(I, ctab(k3, I, _), L).
+test(det, F == 21.0) :-
+	fill_ctab(100),
+	ctab(_, 42, F).
+test(nomatch, fail) :-
+	fill_ctab(100),
+	ctab(_, 42.0, _).
+test(count, N == 90) :-
+	fill_ctab(100),
+	retractall(ctab(k0, _, _)),
+	predicate_property(ctab(_,_,_), number_of_clauses(N)).
+test(luv, N == 10) :-
+	fill_ctab(10),
+	forall(ctab(A, I, F), assertz(ctab(A, I, F))),
+	aggregate_all(count, ctab(_,_,_), C),
+	N is C - 10.
+test(type, error(type_error(integer, a))) :-
+	assertz(ctab(a, a, 1.0)).
+test(asserta, error(permission_error(modify, columnar_procedure, _))) :-
+	asserta(ctab(a, 1, 1.0)).
+test(property, S == ctab(atom, integer, float)) :-
+	predicate_property(ctab(_,_,_), columnar(S)).
+test(luv_retract, L == [1,2,3]) :-
+	fill_ctab(3),
+	findall(I, (ctab(_, I, _), retractall(ctab(_,_,_))), L).
+test(transaction, error(permission_error(modify, columnar_procedure, _))) :-
+	transaction(assertz(ctab(a, 1, 1.0))).
+test(transaction, error(permission_error(modify, columnar_procedure, _))) :-
+	transaction(retractall(ctab(_,_,_))).
+test(abolish, L == [1]) :-
+	columnar(ctab2(atom, integer)),
+	assertz(ctab2(a, 1)),
+	abolish(ctab2/2),
+	columnar(ctab2(integer, atom)),
+	assertz(ctab2(1, a)),
+	findall(X, ctab2(X, _), L).
+test(abolish_running, L == [1,2]) :-
+	columnar(ctab3(integer)),
+	assertz(ctab3(1)),
+	assertz(ctab3(2)),
+	findall(X, (ctab3(X), abolish(ctab3/1)), L).
+
+:- end_tests(columnar).
+
+
+:- begin_tests(sharded).
+
+:- dynamic([shard/2], [sharded(8)]).
+:- dynamic([shard2/3], [sharded(4-2)]).
+
+fill_shard(N) :-
+	retractall(shard(_,_)),
+	forall(between(1, N, I), assertz(shard(I, I))).
+
+test(call, X == 42) :-
+	fill_shard(100),
+	shard(42, X).
+test(all, L == [1,2,3]) :-
+	fill_shard(3),
+	findall(K, shard(K, _), L0),
+	msort(L0, L).
+test(count, N == 90) :-
+	fill_shard(100),
+	forall(between(1, 10, I), retract(shard(I, _))),
+	predicate_property(shard(_,_), number_of_clauses(N)).
+test(retract_all, L == []) :-
+	fill_shard(50),
+	forall(retract(shard(_, _)), true),
+	findall(K, shard(K, _), L).
+test(retractall, N == 99) :-
+	fill_shard(100),
+	retractall(shard(7, _)),
+	aggregate_all(count, shard(_,_), N).
+test(clause, L == [b]) :-
+	retractall(shard(_,_)),
+	assertz(shard(a, b)),
+	findall(V, clause(shard(_, V), true), L).
+test(arg, L == [a-x,c-z]) :-
+	assertz(shard2(a, 1, x)),
+	assertz(shard2(b, 2, y)),
+	assertz(shard2(c, 1, z)),
+	findall(A-C, shard2(A, 1, C), L).
+test(unbound, error(instantiation_error)) :-
+	assertz(shard(_, 1)).
+test(property, S == 4-2) :-
+	predicate_property(shard2(_,_,_), sharded(S)).
+test(abolish, L-S == [b]-(4-1)) :-
+	dynamic([shard3/2], [sharded(8)]),
+	assertz(shard3(a, 1)),
+	abolish(shard3/2),
+	garbage_collect_clauses,
+	\+ predicate_property(shard3(_,_), sharded(_)),
+	dynamic([shard3/2], [sharded(4)]),
+	assertz(shard3(b, 1)),
+	garbage_collect_clauses,
+	findall(X, shard3(X, _), L),
+	predicate_property(shard3(_,_), sharded(S)).
+test(abolish_running, true) :-		% logical update view is per shard
+	dynamic([shard4/1], [sharded(2)]),
+	forall(between(1, 3, I), assertz(shard4(I))),
+	findall(X, ( shard4(X),
+		     abolish(shard4/1),
+		     garbage_collect_clauses
+		   ), L),
+	L \== [].
+
+:- end_tests(sharded).
@@ -38,6 +38,7 @@
 	  ]).
 :- use_module(library(plunit)).
 :- use_module(library(debug)).
+:- use_module(library(prolog_jiti)).
 
 test_jit :-
 	run_tests([ jit
@@ -51,7 +52,8 @@ This module tests behaviour of the just-in-time indexes.
 :- begin_tests(jit).
 
 :- dynamic
-	d/2.
+	d/2,
+	ds/2.
 
 :- meta_predicate
 	has_hashes(:, ?),
@@ -179,6 +181,109 @@ p1(a(b(c(d(e(f(g(2)))))))).
 p2(a(b(c(d(e(f(g(h(1))))))))).
 p2(a(b(c(d(e(f(g(h(2))))))))).
 
+test(async, [ setup(set_prolog_flag(index_async_threshold, 100)),
+	       cleanup((set_prolog_flag(index_async_threshold, 0),
+			retractall(d(_,_))))
+	     ]) :-
+	forall(between(1,1000,X), assertz(d(X,X))),
+	statistics(indexes_built_async, A0),
+	assertion(d(_,500)),
+	wait_async_index(A0, 100),
+	assertion(has_hashes(d(_,_), [2])),
+	assertion(d(_,501)).
+
+wait_async_index(A0, _) :-
+	statistics(indexes_built_async, A),
+	A > A0,
+	!.
+wait_async_index(A0, N) :-
+	N > 0,
+	sleep(0.01),
+	N1 is N - 1,
+	wait_async_index(A0, N1).
+
+test(hints, [cleanup(retractall(d(_,_)))]) :-
+	forall(between(1,50,X), assertz(d(X,X))),
+	d(_,30),
+	jiti_hints(d/2, Hints),
+	assertion(Hints = [hash([2],_,_,false)]),
+	retractall(d(_,_)),
+	forall(between(1,50,X), assertz(d(X,X))),
+	assertion(not_hashed(d(_,_))),
+	'$set_index_hints'(d/2, Hints),
+	assertion(has_hashes(d(_,_), [2])).
+
+% s/2 has too many clauses without a first argument key to be hashed
+% and is scanned linearly using the packed key array.
+
+term_expansion(gen_s, Clauses) :-
+	findall(s(X,X), between(1,40,X), C1),
+	findall(s(_,v(X)), between(1,8,X), C2),
+	append(C1, C2, C12),
+	append(C12, [s(last,last)], Clauses).
+
+gen_s.
+
+test(scan, Xs == [20,v(1),v(2),v(3),v(4),v(5),v(6),v(7),v(8)]) :-
+	findall(X, s(20, X), Xs),
+	assertion(not_hashed(s(_,_))).
+test(scan, Xs == [v(1),v(2),v(3),v(4),v(5),v(6),v(7),v(8)]) :-
+	findall(X, s(none, X), Xs).
+test(scan, Xs == [v(1),v(2),v(3),v(4),v(5),v(6),v(7),v(8),last]) :-
+	findall(X, s(last, X), Xs).
+test(scan) :-
+	s(last, last).
+test(scan_dynamic, [cleanup(retractall(ds(_,_)))]) :-
+	forall(between(1,8,X), assertz(ds(X,X))),
+	assertz(ds(_,v)),
+	assertion(findall(X, ds(3,X), [3,v])),
+	assertz(ds(3,new)),
+	assertion(findall(X, ds(3,X), [3,v,new])),
+	retract(ds(3,3)),
+	assertion(findall(X, ds(3,X), [v,new])),
+	asserta(ds(3,first)),
+	assertion(findall(X, ds(3,X), [first,v,new])),
+	assertion(\+ ds(42,new)).
+
+test(statistics, [ setup(set_prolog_flag(index_statistics, true)),
+		   cleanup(( retractall(d(_,_)),
+			     set_prolog_flag(index_statistics, false)
+			   ))
+		 ]) :-
+	forall(between(1,50,X), assertz(d(X,X))),
+	forall(between(1,10,X), d(X,_)),
+	\+ d(100,_),
+	jiti_statistics(test_jit:d(_,_), Stats),
+	assertion(Stats = [single(1)-index_stats(11,10,_,0)]),
+	jiti_buckets(test_jit:d(_,_), [single(1)-Histogram]),
+	aggregate_all(sum(L*C), member(L-C, Histogram), 50).
+
+test(bloom, [ setup(( dynamic([b/1], [bloom(true)]),
+		     set_prolog_flag(index_statistics, true)
+		   )),
+	      cleanup(( abolish(b/1),
+			set_prolog_flag(index_statistics, false)
+		      ))
+	    ]) :-
+	forall(between(1,100,X), assertz(b(X))),
+	\+ b(1000),
+	assertion(b(42)),
+	retract(b(42)),
+	assertion(\+ b(42)),
+	assertz(b(_)),
+	assertion(b(1000)),
+	predicate_property(b(_), bloom_filter(bloom(_,_,Lookups,Rejected,_))),
+	assertion(Lookups >= 1),
+	assertion(Rejected =:= 1).
+test(bloom_rebuild, [ setup(dynamic([b/1], [bloom(true)])),
+		      cleanup(abolish(b/1))
+		    ]) :-
+	forall(between(1,5000,X), assertz(b(X))),
+	predicate_property(b(_), bloom_filter(bloom(Bits,_,_,_,_))),
+	assertion(Bits >= 5000*8),
+	retractall(b(_)),
+	\+ b(1).
+
 test(depth) :-
 	p1(a(b(c(d(e(f(g(1)))))))),
 	p1(a(b(c(d(e(f(g(2)))))))).
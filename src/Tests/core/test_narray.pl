@@ -0,0 +1,183 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_narray, [test_narray/0]).
+:- use_module(library(plunit)).
+
+/** <module> Test packed numeric arrays
+
+This module tests the narray blob and its map/reduce predicates.
+*/
+
+test_narray :-
+	run_tests([ narray
+		  ]).
+
+:- begin_tests(narray).
+
+test(infer_int, T-L == int64-[1,2,3]) :-
+	list_narray([1,2,3], T, A),
+	narray_list(A, L).
+test(infer_float, T-L == float-[1.0,2.5]) :-
+	list_narray([1,2.5], T, A),
+	narray_list(A, L).
+test(empty, L-S == []-0) :-
+	list_narray([], A),
+	narray_length(A, 0),
+	narray_list(A, L),
+	narray_sum(A, S).
+test(big_int, L == [X,Y]) :-
+	X is 1<<62, Y is -(1<<63),
+	list_narray([X,Y], int64, A),
+	narray_list(A, L).
+test(type, error(type_error(integer, a))) :-
+	list_narray([1,a], int64, _).
+test(nth0, E == 30) :-
+	list_narray([10,20,30], A),
+	narray_nth0(2, A, E).
+test(nth0, fail) :-
+	list_narray([10,20,30], A),
+	narray_nth0(3, A, _).
+test(slice, L == [20,30]) :-
+	list_narray([10,20,30,40], A),
+	narray_slice(A, 1, 2, S),
+	narray_list(S, L).
+test(slice, fail) :-
+	list_narray([10,20,30,40], A),
+	narray_slice(A, 3, 2, _).
+test(sum, S == 5050) :-
+	numlist(1, 100, L),
+	list_narray(L, A),
+	narray_sum(A, S).
+test(sum_overflow, S == X) :-
+	M is 1<<63-1,
+	list_narray([M,M,M], A),
+	narray_sum(A, S),
+	X is 3*M.
+test(sum_float, S =:= 5050.0) :-
+	numlist(1, 100, L),
+	list_narray(L, float, A),
+	narray_sum(A, S).
+test(dot, D == 14) :-
+	list_narray([1,2,3], A),
+	narray_dot(A, A, D).
+test(dot_overflow, D == X) :-
+	M is 1<<62,
+	list_narray([M,M], A),
+	narray_dot(A, A, D),
+	X is 2*M*M.
+test(dot_mixed, D =:= 3.5) :-
+	list_narray([1,2], A),
+	list_narray([1.5,1.0], B),
+	narray_dot(A, B, D).
+test(min_max, Min-Max == (-3)-7) :-
+	list_narray([4,-3,7,0], A),
+	narray_min(A, Min),
+	narray_max(A, Max).
+test(min_max, fail) :-
+	list_narray([], A),
+	narray_min(A, _).
+test(map, L == [11,22,33]) :-
+	list_narray([1,2,3], A),
+	list_narray([10,20,30], B),
+	narray_map(+, A, B, C),
+	narray_list(C, L).
+test(map_scalar, L == [2.0,4.0,6.0]) :-
+	list_narray([1,2,3], A),
+	narray_map(*, A, 2.0, C),
+	narray_list(C, L).
+test(map_div, L == [0.5,1.0]) :-
+	list_narray([1,2], A),
+	narray_map(/, A, 2, C),
+	narray_list(C, L).
+test(map_overflow, error(evaluation_error(int_overflow))) :-
+	M is 1<<63-1,
+	list_narray([M], A),
+	narray_map(+, A, 1, _).
+test(map_float_overflow, error(evaluation_error(float_overflow))) :-
+	list_narray([1.0e308], A),
+	narray_map(*, A, 10.0, _).
+test(map_zero_div, error(evaluation_error(zero_divisor))) :-
+	list_narray([1.0,2.0], A),
+	list_narray([1.0,0.0], B),
+	narray_map(/, A, B, _).
+test(map_zero_div, L == [0.5,inf]) :-
+	list_narray([1.0,2.0], A),
+	list_narray([2.0,0.0], B),
+	current_prolog_flag(float_zero_div, Old),
+	setup_call_cleanup(
+	    set_prolog_flag(float_zero_div, infinity),
+	    narray_map(/, A, B, C),
+	    set_prolog_flag(float_zero_div, Old)),
+	narray_list(C, L0),
+	maplist(float_text, L0, L).
+test(map_undefined, error(evaluation_error(undefined))) :-
+	list_narray([0.0], A),
+	narray_map(/, A, 0.0, _).
+test(compare, [A,B] == [A1,B1]) :-
+	list_narray([1,2,3], A1),
+	list_narray([1,2,4], B1),
+	msort([B1,A1], [A,B]).
+test(sort_distinct, Len == 2) :-
+	list_narray([1,2,3], A),
+	list_narray([1,2,3], B),
+	A \== B,
+	sort([A,B], L),
+	length(L, Len).
+test(compare_same, O == (=)) :-
+	list_narray([1,2,3], A),
+	compare(O, A, A).
+test(fast_serialize, L == [1.5,-2.0]) :-
+	list_narray([1.5,-2.0], A),
+	fast_term_serialized(t(A), S),
+	fast_term_serialized(t(A2), S),
+	narray_list(A2, L).
+test(fast_serialize, L == [1,2,3]) :-
+	list_narray([1,2,3], A),
+	fast_term_serialized(A, S),
+	fast_term_serialized(A2, S),
+	narray_list(A2, L).
+test(message_queue, A2 == A) :-
+	list_narray([1,2,3], A),
+	message_queue_create(Q),
+	thread_send_message(Q, a(A)),
+	thread_get_message(Q, a(A2)),
+	message_queue_destroy(Q).
+
+:- end_tests(narray).
+
+float_text(F, T) :-
+	(   F =:= inf
+	->  T = inf
+	;   T = F
+	).
@@ -36,7 +36,9 @@ test_sort :-
 	run_tests([ sort,
 		    msort,
 		    keysort,
-		    sort4
+		    sort4,
+		    parallel_sort,
+		    radix_sort
 		  ]).
 
 :- begin_tests(sort).
@@ -144,3 +146,131 @@ test(dict, error(type_error(dict,a(1)))) :-
 	sort(a, @<, [a(1), a(2)], _).
 
 :- end_tests(sort4).
+
+:- begin_tests(parallel_sort).
+
+%	par_sort(:Goal)
+%
+%	Run Goal such that sorting uses 4 threads for lists of 2048 and
+%	more elements.
+
+par_sort(Goal) :-
+	current_prolog_flag(cpu_count, Cpus),
+	current_prolog_flag(sort_parallel_threshold, Threshold),
+	setup_call_cleanup(
+	    ( set_prolog_flag(cpu_count, 4),
+	      set_prolog_flag(sort_parallel_threshold, 2048)
+	    ),
+	    Goal,
+	    ( set_prolog_flag(cpu_count, Cpus),
+	      set_prolog_flag(sort_parallel_threshold, Threshold)
+	    )).
+
+seq_sort(Goal) :-
+	current_prolog_flag(sort_parallel_threshold, Threshold),
+	setup_call_cleanup(
+	    set_prolog_flag(sort_parallel_threshold, 0),
+	    Goal,
+	    set_prolog_flag(sort_parallel_threshold, Threshold)).
+
+%	random_pairs(+N, -Pairs)
+%
+%	Pairs has float keys with many duplicates.  Small integers or
+%	atoms would be sorted by radix_sort_list() instead of the
+%	parallel merge sort.  The tests use 3100 pairs, which are sorted
+%	as three blocks of at least 1024 elements, such that one block
+%	passes unmerged to the next round.
+
+random_pairs(N, Pairs) :-
+	set_random(seed(42)),
+	findall(K-I, (between(1, N, I), K is random(100)*0.5), Pairs).
+
+test(msort, Par == Seq) :-
+	random_pairs(3100, Pairs),
+	seq_sort(msort(Pairs, Seq)),
+	par_sort(msort(Pairs, Par)).
+test(sort, Par == Seq) :-
+	random_pairs(3100, Pairs),
+	pairs_keys(Pairs, Keys),
+	seq_sort(sort(Keys, Seq)),
+	par_sort(sort(Keys, Par)).
+test(keysort, Par == Seq) :-
+	random_pairs(3100, Pairs),
+	seq_sort(keysort(Pairs, Seq)),
+	par_sort(keysort(Pairs, Par)).
+test(sort4) :-
+	random_pairs(3100, Pairs),
+	forall(member(Order, [@<, @=<, @>, @>=]),
+	       ( seq_sort(sort(1, Order, Pairs, Seq)),
+		 par_sort(sort(1, Order, Pairs, Par)),
+		 assertion(Par == Seq)
+	       )).
+test(mixed, Par == Seq) :-
+	set_random(seed(42)),
+	findall(X, ( between(1, 2500, _),
+		     K is random(100),
+		     (   K < 30 -> X = K
+		     ;   K < 60 -> X is K/7
+		     ;   K < 80 -> format(atom(X), 'a~w', [K])
+		     ;   format(string(X), 's~w', [K])
+		     )
+		   ), List),
+	seq_sort(msort(List, Seq)),
+	par_sort(msort(List, Par)).
+test(big, Par == Seq) :-			% sequential fallback
+	set_random(seed(42)),
+	findall(X, (between(1, 2500, _), X is random(100)*10^20), List),
+	seq_sort(msort(List, Seq)),
+	par_sort(msort(List, Par)).
+
+:- end_tests(parallel_sort).
+
+:- begin_tests(radix_sort).
+
+%	merge_sort(+Key, +Order, +Sentinel, +List, -Sorted)
+%
+%	Sort using the merge sort by adding Sentinel, which has a different
+%	type than the keys of List and thus disables the radix sort.
+
+merge_sort(Key, Order, Sentinel, List, Sorted) :-
+	sort(Key, Order, [Sentinel|List], Sorted0),
+	selectchk(Sentinel, Sorted0, Sorted).
+
+int_pairs(N, Pairs) :-
+	set_random(seed(42)),
+	findall(K-I, (between(1, N, I), K is random(200)-100), Pairs).
+atom_pairs(N, Pairs) :-
+	int_pairs(N, IPairs),
+	findall(A-I, (member(K-I, IPairs), format(atom(A), 'a~w', [K])), Pairs).
+
+test(int) :-
+	int_pairs(1000, Pairs),
+	forall(member(Order, [@<, @=<, @>, @>=]),
+	       ( sort(1, Order, Pairs, Radix),
+		 merge_sort(1, Order, a-0, Pairs, Merge),
+		 assertion(Radix == Merge)
+	       )).
+test(atom) :-
+	atom_pairs(1000, Pairs),
+	forall(member(Order, [@<, @=<, @>, @>=]),
+	       ( sort(1, Order, Pairs, Radix),
+		 merge_sort(1, Order, "a"-0, Pairs, Merge),
+		 assertion(Radix == Merge)
+	       )).
+test(keysort, Sorted == Merge) :-
+	int_pairs(1000, Pairs),
+	keysort(Pairs, Sorted),
+	merge_sort(1, @=<, a-0, Pairs, Merge).
+test(sort, Sorted == Merge) :-
+	int_pairs(1000, Pairs),
+	pairs_keys(Pairs, Keys0),
+	current_prolog_flag(min_tagged_integer, Min),
+	current_prolog_flag(max_tagged_integer, Max),
+	append(Keys0, [Max,Min], Keys),
+	sort(Keys, Sorted),
+	merge_sort(0, @<, a, Keys, Merge).
+test(sorted, Sorted == List) :-
+	numlist(1, 1000, List),
+	msort(List, Sorted).
+
+:- end_tests(radix_sort).
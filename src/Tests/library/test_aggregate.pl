@@ -163,5 +163,40 @@ test(aggregate_all, Max == 3) :-
 	aggregate_all(r(max(A)), member(A,List), r(Max)).
 test(e_vars, all(X == [1,2,3,4,5])) :-
 	aggregate(r(sum(0)), Y^(between(1, 5, X), Y=1), _).
+test(all_count, Count == 55) :-
+	aggregate_all(count, country(_,_,_), Count).
+test(all_sum, Sum == 15) :-
+	aggregate_all(sum(X), between(1, 5, X), Sum).
+test(all_sum_empty, Sum == 0) :-
+	aggregate_all(sum(X), between(1, 0, X), Sum).
+test(all_sum_mixed, Sum == 7r2) :-
+	aggregate_all(sum(X), member(X, [1, 1r2, 2]), Sum).
+test(all_sum_big, Sum == 100000000000000000000000000000000000000000) :-
+	aggregate_all(sum(X), (between(1, 10, _), X is 10^40), Sum).
+test(all_max, Max == 'Russia') :-
+	aggregate_all(max(Pop, C), country(C, _, Pop), max(_, Max)).
+test(all_min, Min == 0.44) :-
+	aggregate_all(min(Area), country(_, Area, _), Min).
+test(all_max_empty, fail) :-
+	aggregate_all(max(X), between(1, 0, X), _).
+test(all_max_first_witness, W == b) :-
+	aggregate_all(max(X, W0), member(X-W0, [1-a,3-b,3-c]), max(_, W)).
+test(all_max_witness_eval, Max-W == 3-b) :-
+	aggregate_all(max(X, W0), member(X-W0, [1-a,1+2-b]), max(Max, W)).
+test(all_max_witness_type, error(type_error(evaluable, a/0))) :-
+	aggregate_all(max(X, x), member(X, [a]), _).
+test(all_min_witness_type, error(type_error(evaluable, a/0))) :-
+	aggregate_all(min(X, x), member(X, [1,a]), _).
+test(all_set, Set == [1,2,3]) :-
+	aggregate_all(set(X), member(X, [3,1,2,1,3]), Set).
+test(all_set_nonground, Set =@= [f(_),f(_),f(a)]) :-
+	aggregate_all(set(X), member(X, [f(_),f(a),f(_),f(a)]), Set).
+test(all_disc_count, Count == 2) :-
+	aggregate_all(count, Age, age(_, Age), Count).
+test(all_nested, Sum == 6) :-
+	aggregate_all(sum(S),
+		      ( member(Y, [1,2]),
+			aggregate_all(sum(Z), member(Z, [Y,Y]), S)
+		      ), Sum).
 
 :- end_tests(aggregate).
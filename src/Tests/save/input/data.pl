@@ -47,7 +47,8 @@ test :-
 	halt.
 
 run_tests :-
-	test_dict_sorting.
+	test_dict_sorting,
+	test_columnar.
 
 		 /*******************************
 		 *	       TESTS		*
@@ -58,3 +59,10 @@ test_dict_sorting :-
 	var(Dict.a).
 
 dict(_{a:_}).
+
+:- columnar(cfact(atom, integer)).
+:- forall(between(1, 1500, I), assertz(cfact(a, I))).
+
+test_columnar :-
+	aggregate_all(count, cfact(_,_), 1500),
+	cfact(a, 1500).
@@ -130,6 +130,22 @@ test(gen_indirect, true) :-
 	trie_new(T),
 	trie_insert(T, 0.25, true),
 	trie_gen(T, 0.25).
+test(slabs, true) :-
+	trie_new(T),
+	trie_property(T, memory_slabs(S0)),
+	assertion(S0 == 0),
+	forall(between(1, 1000, I), trie_insert(T, f(I), I)),
+	trie_property(T, memory_slabs(S1)),
+	trie_property(T, memory_slab_size(Size1)),
+	trie_property(T, memory_slab_used(Used1)),
+	assertion(S1 > 0),
+	assertion(Used1 =< Size1),
+	forall(between(1, 1000, I), trie_delete(T, f(I), _)),
+	trie_property(T, memory_slab_used(Used2)),
+	assertion(Used2 < Used1),
+	forall(between(1001, 2000, I), trie_insert(T, f(I), I)),
+	trie_property(T, memory_slab_size(Size3)),
+	assertion(Size3 == Size1).		% reuses the freed nodes
 test(var1, set(Y == [1,2,3])) :-
         test_var(_, Y).
 test(var2, set(Y == [1,2])) :-
@@ -0,0 +1,158 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+:- module(queue_batch,
+	  [ queue_batch/0
+	  ]).
+:- use_module(library(plunit)).
+:- use_module(library(apply)).
+:- use_module(library(lists)).
+
+/** <module> Test thread_send_messages/2 and thread_get_messages/3
+*/
+
+queue_batch :-
+    run_tests([ queue_batch
+              ]).
+
+:- begin_tests(queue_batch).
+
+test(order,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       Ms == [a,f(x),3,"s"]
+     ]) :-
+    thread_send_messages(Q, [a,f(x)]),
+    thread_send_message(Q, 3),
+    thread_send_messages(Q, ["s"]),
+    message_queue_property(Q, size(4)),
+    thread_get_messages(Q, Ms, []).
+test(max,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       [L1,L2,L3] == [[1,2,3],[4,5,6],[7]]
+     ]) :-
+    numlist(1, 7, L),
+    thread_send_messages(Q, L),
+    thread_get_messages(Q, L1, [max(3)]),
+    thread_get_messages(Q, L2, [max(3)]),
+    thread_get_messages(Q, L3, [max(3)]).
+test(empty,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q))
+     ]) :-
+    thread_send_messages(Q, []),
+    message_queue_property(Q, size(0)),
+    \+ thread_get_messages(Q, _, [timeout(0.01)]).
+test(unify,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q))
+     ]) :-
+    thread_send_messages(Q, [a,b]),
+    \+ thread_get_messages(Q, [a,c], []),
+    message_queue_property(Q, size(0)).
+test(wait,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       Ms == [a,b]
+     ]) :-
+    thread_create((sleep(0.05), thread_send_messages(Q, [a,b])), Id, []),
+    thread_get_messages(Q, Ms, []),
+    thread_join(Id).
+test(max_size,
+     [ setup(message_queue_create(Q, [max_size(10)])),
+       cleanup(message_queue_destroy(Q)),
+       Ms == L
+     ]) :-
+    numlist(1, 100, L),
+    thread_create(thread_send_messages(Q, L), Id, []),
+    get_batches(Q, 100, Ms),
+    thread_join(Id).
+test(fifo,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       Ms == L
+     ]) :-
+    numlist(1, 2000, L),
+    thread_create(thread_send_messages(Q, L), Id, []),
+    get_batches(Q, 2000, Ms),
+    thread_join(Id).
+test(threads,
+     [ setup(message_queue_create(Q, [max_size(16)])),
+       cleanup(message_queue_destroy(Q)),
+       Sum == 8002000
+     ]) :-
+    length(Ps, 4),
+    foldl({Q}/[Id,I0,I]>>( I is I0+1000,
+                           High is I-1,
+                           numlist(I0, High, L),
+                           thread_create(thread_send_messages(Q, L), Id, [])
+                         ), Ps, 1, _),
+    get_batches(Q, 4000, Ms),
+    maplist(thread_join, Ps),
+    sum_list(Ms, Sum).
+test(index,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       [L1,L2] == [[f(0)],[g(100)]]
+     ]) :-
+    forall(between(0, 99, I), ( K is I mod 7, thread_send_message(Q, f(K,I)) )),
+    thread_get_message(Q, f(1,99), [timeout(0)]),
+    thread_get_messages(Q, Ms, [max(50)]),
+    length(Ms, 50),
+    thread_get_messages(Q, Rest, []),
+    length(Rest, 49),
+    thread_send_messages(Q, [f(0), g(100)]),
+    thread_get_messages(Q, L1, [max(1)]),
+    thread_get_messages(Q, L2, [timeout(0)]).
+test(type, error(type_error(list, b))) :-
+    message_queue_create(Q),
+    call_cleanup(thread_send_messages(Q, [a|b]),
+                 message_queue_destroy(Q)).
+test(domain, error(domain_error(max_messages, [max(0)]))) :-
+    message_queue_create(Q),
+    call_cleanup(thread_get_messages(Q, _, [max(0)]),
+                 message_queue_destroy(Q)).
+
+%!  get_batches(+Queue, +Count, -Messages)
+%
+%   Get Count messages from Queue using thread_get_messages/3.
+
+get_batches(_, 0, []) :- !.
+get_batches(Q, N, Ms) :-
+    thread_get_messages(Q, Batch, [max(N)]),
+    length(Batch, Len),
+    N1 is N-Len,
+    append(Batch, Rest, Ms),
+    get_batches(Q, N1, Rest).
+
+:- end_tests(queue_batch).
@@ -0,0 +1,165 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(queue_fifo,
+	  [ queue_fifo/0
+	  ]).
+:- use_module(library(plunit)).
+:- use_module(library(apply)).
+:- use_module(library(lists)).
+
+/** <module> Test message queues created with fifo(true)
+*/
+
+queue_fifo :-
+    run_tests([ queue_fifo
+              ]).
+
+:- begin_tests(queue_fifo).
+
+test(order,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       Ms == [1,2,3,4,5]
+     ]) :-
+    forall(between(1, 5, I), thread_send_message(Q, I)),
+    message_queue_property(Q, size(5)),
+    message_queue_property(Q, fifo(true)),
+    get_all(Q, Ms).
+test(selective,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       [X,Y,Z,P] == [2,a(1),a(3),c]
+     ]) :-
+    thread_send_message(Q, a(1)),
+    thread_send_message(Q, b(2)),
+    thread_send_message(Q, a(3)),
+    thread_get_message(Q, b(X)),
+    thread_send_message(Q, c),
+    thread_peek_message(Q, c),
+    thread_get_message(Q, Y),
+    thread_get_message(Q, Z),
+    thread_get_message(Q, P).
+test(constraint,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       X == 2
+     ]) :-
+    thread_send_message(Q, 1),
+    thread_send_message(Q, 2),
+    freeze(X, X mod 2 =:= 0),
+    thread_get_message(Q, X),
+    thread_get_message(Q, 1).
+test(full,
+     [ setup(message_queue_create(Q, [fifo(true), max_size(2)])),
+       cleanup(message_queue_destroy(Q))
+     ]) :-
+    thread_send_message(Q, a),
+    thread_send_message(Q, b),
+    \+ thread_send_message(Q, c, [timeout(0.01)]),
+    thread_get_message(Q, a),
+    thread_send_message(Q, c, [timeout(0.01)]),
+    \+ thread_get_message(Q, d, [timeout(0.01)]).
+test(full_peek,
+     [ setup(message_queue_create(Q, [fifo(true), max_size(4)])),
+       cleanup(message_queue_destroy(Q)),
+       Ms == [1,2,3,4]
+     ]) :-
+    forall(between(1, 4, I), thread_send_message(Q, I)),
+    thread_peek_message(Q, _),
+    \+ thread_send_message(Q, 5, [timeout(0.01)]),
+    message_queue_property(Q, size(4)),
+    get_all(Q, Ms).
+test(full_exact,
+     [ setup(message_queue_create(Q, [fifo(true), max_size(3)])),
+       cleanup(message_queue_destroy(Q))
+     ]) :-
+    forall(between(1, 3, I), thread_send_message(Q, I)),
+    \+ thread_send_message(Q, 4, [timeout(0.01)]).
+test(wait,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       X == hello
+     ]) :-
+    thread_create((sleep(0.05), thread_send_message(Q, hello)), Id, []),
+    thread_get_message(Q, X),
+    thread_join(Id).
+test(threads,
+     [ setup(message_queue_create(Q, [fifo(true), max_size(16)])),
+       cleanup(message_queue_destroy(Q)),
+       Sum == 8002000
+     ]) :-
+    length(Ps, 4),
+    length(Cs, 4),
+    maplist({Q}/[Id]>>thread_create(consume(Q, 1000), Id, []), Cs),
+    foldl({Q}/[Id,I0,I]>>( I is I0+1000,
+                           thread_create(produce(Q, I0, I), Id, [])
+                         ), Ps, 1, _),
+    maplist(thread_join, Ps),
+    maplist([Id,S]>>thread_join(Id, exited(S)), Cs, Sums),
+    sum_list(Sums, Sum).
+test(agc,
+     [ setup(message_queue_create(Q, [fifo(true)])),
+       cleanup(message_queue_destroy(Q)),
+       Atoms == Expected
+     ]) :-
+    findall(A, (between(1, 100, I), atom_concat(fifo_msg_, I, A)), Expected),
+    forall(between(1, 100, I),
+           ( atom_concat(fifo_msg_, I, A),
+             thread_send_message(Q, A)
+           )),
+    garbage_collect_atoms,
+    get_all(Q, Atoms).
+
+get_all(Q, [H|T]) :-
+    thread_get_message(Q, H, [timeout(0)]),
+    !,
+    get_all(Q, T).
+get_all(_, []).
+
+produce(Q, From, To) :-
+    High is To-1,
+    forall(between(From, High, I), thread_send_message(Q, I)).
+
+consume(Q, N) :-
+    consume(Q, N, 0, Sum),
+    thread_exit(Sum).
+
+consume(_, 0, Sum, Sum) :- !.
+consume(Q, N, Sum0, Sum) :-
+    thread_get_message(Q, X),
+    Sum1 is Sum0+X,
+    N1 is N-1,
+    consume(Q, N1, Sum1, Sum).
+
+:- end_tests(queue_fifo).
@@ -0,0 +1,117 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(queue_index,
+	  [ queue_index/0
+	  ]).
+:- use_module(library(plunit)).
+
+/** <module> Test selective receive from large queues
+
+Queues that hold many messages  are  indexed  on  the  first  argument
+when a selective receive does not match the head. These tests verify the
+index preserves the queue order.
+*/
+
+queue_index :-
+    run_tests([ queue_index
+              ]).
+
+:- begin_tests(queue_index).
+
+test(reverse,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       Size == 0
+     ]) :-
+    forall(between(1, 500, I),
+           thread_send_message(Q, reply(I, I))),
+    forall(between(1, 500, J),
+           ( I is 501-J,
+             thread_get_message(Q, reply(I, X)),
+             assertion(X == I)
+           )),
+    message_queue_property(Q, size(Size)).
+test(order,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       Vs-Rest =@= [a,b,c,_]-[k(2,x)]
+     ]) :-
+    forall(between(1, 100, I),
+           thread_send_message(Q, z(I))),
+    thread_send_message(Q, k(1,a)),
+    thread_send_message(Q, k(_,b)),
+    thread_send_message(Q, k(2,x)),
+    thread_send_message(Q, k(1,c)),
+    thread_send_message(Q, _),
+    findall(V, (between(1, 4, _), thread_get_message(Q, k(1,V))), Vs),
+    forall(between(1, 100, I),
+           thread_get_message(Q, z(I))),
+    findall(M, thread_get_message(Q, M, [timeout(0)]), Rest).
+test(keys,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q)),
+       [V1,V2,V3,V4,V5] == [4,3,2,1,5]
+     ]) :-
+    forall(between(1, 100, I),
+           thread_send_message(Q, f(I, -))),
+    thread_send_message(Q, f("abc", 1)),
+    thread_send_message(Q, f(1.5, 2)),
+    thread_send_message(Q, f(abc, 3)),
+    thread_send_message(Q, f(g(x), 4)),
+    thread_send_message(Q, f(1000000000000000000000, 5)),
+    thread_get_message(Q, f(g(_), V1)),
+    thread_get_message(Q, f(abc, V2)),
+    thread_get_message(Q, f(1.5, V3)),
+    thread_get_message(Q, f("abc", V4)),
+    thread_peek_message(Q, f(1000000000000000000000, V5)),
+    thread_get_message(Q, f(1000000000000000000000, V5)),
+    \+ thread_peek_message(Q, f(abc, _)),
+    thread_peek_message(Q, f(50, -)).
+test(threads,
+     [ setup(message_queue_create(Q)),
+       cleanup(message_queue_destroy(Q))
+     ]) :-
+    thread_create(forall(between(1, 500, J),
+                         ( I is 501-J,
+                           thread_send_message(Q, reply(I, I))
+                         )),
+                  Id, []),
+    forall(between(1, 500, I),
+           ( thread_get_message(Q, reply(I, X)),
+             assertion(X == I)
+           )),
+    thread_join(Id, Status),
+    assertion(Status == true).
+
+:- end_tests(queue_index).
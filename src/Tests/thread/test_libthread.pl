@@ -42,7 +42,9 @@
 :- use_module(library(thread)).
 
 test_libthread :-
-    run_tests([ concurrent_and
+    run_tests([ concurrent_and,
+                concurrent_maplist,
+                concurrent_forall
               ]).
 
 :- begin_tests(concurrent_and, [sto(rational_trees)]).
@@ -65,6 +67,94 @@ test(gen_error, error(evaluation_error(zero_divisor))) :-
 
 :- end_tests(concurrent_and).
 
+:- begin_tests(concurrent_maplist).
+
+test(map, L2 == Expected) :-
+    numlist(1, 1000, L),
+    with_cpu_count(4, concurrent_maplist(succ, L, L2)),
+    numlist(2, 1001, Expected).
+test(map3, L3 == Expected) :-
+    numlist(1, 100, L1),
+    numlist(101, 200, L2),
+    with_cpu_count(4, concurrent_maplist(plus, L1, L2, L3)),
+    findall(X, (between(1, 100, I), X is 100+2*I), Expected).
+test(fail, fail) :-
+    numlist(1, 1000, L),
+    with_cpu_count(4, concurrent_maplist(>(900), L)).
+test(error, error(evaluation_error(zero_divisor))) :-
+    numlist(0, 1000, L),
+    with_cpu_count(4, concurrent_maplist([X]>>(_ is 1/(X-500)), L)).
+test(nested, Sum == 5050) :-
+    numlist(1, 100, L),
+    with_cpu_count(4,
+                   concurrent_maplist([X,Y]>>( numlist(1, X, L1),
+                                               concurrent_maplist(succ, L0, L1),
+                                               sum_list(L0, S0),
+                                               Y is S0+X-S0
+                                             ), L, Ys)),
+    sum_list(Ys, Sum).
+test(pool, true) :-
+    numlist(1, 100, L),
+    with_cpu_count(4, concurrent_maplist(succ, L, _)),
+    assertion(no_more_threads).
+
+:- end_tests(concurrent_maplist).
+
+:- begin_tests(concurrent_forall).
+
+test(forall, true) :-
+    concurrent_forall(between(1, 1000, X), X > 0, [threads(4)]).
+test(fail, fail) :-
+    concurrent_forall(between(1, 1000, X), X < 900, [threads(4)]).
+test(error, error(evaluation_error(zero_divisor))) :-
+    concurrent_forall(between(0, 1000, X), _ is 1/(X-500), [threads(4)]).
+test(shared, Count == 1000) :-
+    flag(fa_count, _, 0),
+    concurrent_forall(between(1, 1000, _), flag(fa_count, N, N+1),
+                      [threads(4)]),
+    flag(fa_count, Count, 0).
+test(busy_pool, Reply == done) :-
+    message_queue_create(Go),
+    thread_self(Me),
+    thread_create(blocking_forall(Go), A, []),
+    thread_get_message(Go, blocked(2)),
+    thread_create(quick_forall(Me), B, []),
+    (   thread_get_message(Me, quick(Reply), [timeout(20)])
+    ->  true
+    ;   Reply = timeout
+    ),
+    forall(between(1, 2, _), thread_send_message(Go, go)),
+    thread_join(A, true),
+    thread_join(B, _),
+    message_queue_destroy(Go).
+
+:- end_tests(concurrent_forall).
+
+%   Occupy two pool workers until Go receives two `go` messages.
+
+blocking_forall(Go) :-
+    flag(fa_blocked, _, 0),
+    concurrent_forall(between(1, 2, _), block_on(Go), [threads(2)]).
+
+block_on(Go) :-
+    flag(fa_blocked, N, N+1),
+    (   N == 1
+    ->  thread_send_message(Go, blocked(2))
+    ;   true
+    ),
+    thread_get_message(Go, go).
+
+quick_forall(Parent) :-
+    concurrent_forall(between(1, 4, _), true, [threads(2)]),
+    thread_send_message(Parent, quick(done)).
+
+with_cpu_count(Count, Goal) :-
+    current_prolog_flag(cpu_count, Old),
+    setup_call_cleanup(
+        set_prolog_flag(cpu_count, Count),
+        Goal,
+        set_prolog_flag(cpu_count, Old)).
+
 no_more_threads :-
     findall(T, anon_thread(T), Anon),
     Anon == [].
@@ -0,0 +1,104 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+:- module(test_shared_term,
+	  [ test_shared_term/0
+	  ]).
+:- use_module(library(plunit)).
+:- use_module(library(apply)).
+:- use_module(library(lists)).
+
+/** <module> Test share_term/2 and shared_term/2
+*/
+
+test_shared_term :-
+    run_tests([ shared_term
+              ]).
+
+:- begin_tests(shared_term).
+
+test(copy, T == f("str", 3.14, [a,b|c], 1000000000000000000000, 'X y')) :-
+    share_term(f("str", 3.14, [a,b|c], 1000000000000000000000, 'X y'), H),
+    blob(H, shared_term),
+    shared_term(H, T).
+test(unify) :-
+    share_term(point(1,2), H),
+    shared_term(H, point(X,_)),
+    X == 1,
+    \+ shared_term(H, point(2,_)).
+test(nonground, error(instantiation_error)) :-
+    share_term(f(_), _).
+test(type, error(type_error(shared_term, foo))) :-
+    shared_term(foo, _).
+test(threads, Lens == [1000,1000,1000,1000]) :-
+    numlist(1, 1000, L),
+    share_term(data(L), H),
+    length(Ids, 4),
+    maplist(create_reader, Ids),
+    maplist(send(H), Ids),
+    maplist(join_reader, Ids, Lens).
+test(agc, Strings == Expected) :-
+    findall(H,
+            ( findall(A, ( between(1, 100, I),
+                           atom_concat(shared_atom_, I, A)
+                         ), Atoms),
+              share_term(Atoms, H)
+            ), [H]),
+    garbage_collect_atoms,
+    shared_term(H, T),
+    maplist(atom_string, T, Strings),
+    findall(S, ( between(1, 100, I),
+                 format(string(S), 'shared_atom_~d', [I])
+               ), Expected).
+test(release) :-
+    forall(between(1, 1000, I),
+           ( numlist(1, 100, L),
+             share_term(f(I, L), _)
+           )),
+    garbage_collect_atoms.
+
+:- end_tests(shared_term).
+
+create_reader(Id) :-
+    thread_create(reader, Id, []).
+
+reader :-
+    thread_get_message(Handle),
+    shared_term(Handle, data(List)),
+    length(List, Len),
+    thread_exit(Len).
+
+send(Msg, Id) :-
+    thread_send_message(Id, Msg).
+
+join_reader(Id, Len) :-
+    thread_join(Id, exited(Len)).
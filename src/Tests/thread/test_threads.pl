@@ -36,6 +36,8 @@
 :- module(test_threads, [test_threads/0]).
 :- use_module(library(plunit)).
 :- use_module(library(debug)).
+:- use_module(library(aggregate)).
+:- use_module(library(apply)).
 
 /** <module> Test basic threading predicates
 
@@ -51,7 +53,8 @@ test_threads :-
 		    thread_property,
 		    mutex,
 		    mutex_property,
-		    message_queue
+		    message_queue,
+		    heap_cache
 		  ]).
 
 
@@ -264,3 +267,75 @@ test(size_prop, true) :-
 	message_queue_destroy(Queue).
 
 :- end_tests(message_queue).
+
+
+		 /*******************************
+		 *	     HEAP CACHE		*
+		 *******************************/
+
+:- begin_tests(heap_cache, [condition(catch(statistics(heap_cache, _), _, fail))]).
+
+churn(N) :-
+	forall(between(1, N, I),
+	       ( recorda(heap_cache_test, f(I, [a,b]), Ref),
+		 erase(Ref)
+	       )).
+
+hits(Hits) :-
+	statistics(heap_cache, Classes),
+	class_hits(Classes, Hits).
+
+class_hits(Classes, Hits) :-
+	aggregate_all(sum(H), member(size_class(_,H,_,_), Classes), Hits).
+
+% Clauses that are reclaimed by the thread itself reuse the blocks in
+% its cache.
+
+:- dynamic heap_cache_clause/1.
+
+clause_churn(N) :-
+	forall(between(1, N, _),
+	       ( forall(between(1, 20, I), assertz(heap_cache_clause(I))),
+		 retractall(heap_cache_clause(_)),
+		 garbage_collect_clauses
+	       )).
+
+churn_on_request(Parent) :-
+	thread_get_message(churn(N)),
+	clause_churn(N),
+	thread_send_message(Parent, churned),
+	thread_get_message(done).
+
+thread_hits(Id, Hits) :-
+	thread_statistics(Id, heap_cache, Classes),
+	class_hits(Classes, Hits).
+
+test(threads, true) :-
+	hits(Hits0),
+	findall(Id, ( between(1, 4, _),
+		      thread_create(churn(1000), Id, [])
+		    ), Ids),
+	maplist(thread_join, Ids),
+	churn(1000),
+	hits(Hits),
+	assertion(Hits > Hits0).
+test(thread, true) :-
+	thread_self(Me),
+	thread_create(churn_on_request(Me), Id, []),
+	thread_hits(Id, Hits0),
+	thread_send_message(Id, churn(100)),
+	thread_get_message(churned),
+	thread_hits(Id, Hits),
+	thread_send_message(Id, done),
+	thread_join(Id),
+	assertion(Hits - Hits0 >= 1000).
+test(classes, true) :-
+	statistics(heap_cache, Classes),
+	assertion(Classes = [size_class(_,_,_,_)|_]),
+	forall(member(size_class(Size,Hits,Misses,Cached), Classes),
+	       assertion(( integer(Size), Size > 0,
+			   integer(Hits), Hits >= 0,
+			   integer(Misses), Misses >= 0,
+			   integer(Cached), Cached >= 0 ))).
+
+:- end_tests(heap_cache).
@@ -98,6 +98,7 @@
 #cmakedefine HAVE_MACH_O_RLD_H @HAVE_MACH_O_RLD_H@
 #cmakedefine HAVE_MACH_THREAD_ACT_H @HAVE_MACH_THREAD_ACT_H@
 #cmakedefine HAVE_MALLOC_H @HAVE_MALLOC_H@
+#cmakedefine HAVE_MALLOC_USABLE_SIZE @HAVE_MALLOC_USABLE_SIZE@
 #cmakedefine HAVE_MBSCASECOLL @HAVE_MBSCASECOLL@
 #cmakedefine HAVE_MBSCOLL @HAVE_MBSCOLL@
 #cmakedefine HAVE_MBSNRTOWCS @HAVE_MBSNRTOWCS@
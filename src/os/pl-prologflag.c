@@ -923,6 +923,10 @@ set_prolog_flag_unlocked(Module m, atom_t k, term_t value, int flags ARG_LD)
 	    free_alloc_pool(pool);
 	} else
 	  GD->tabling.node_pool->limit = (size_t)i;
+      } else if ( k == ATOM_index_async_threshold )
+      { GD->thread.index.async_threshold = (i > 0 ? (size_t)i : 0);
+      } else if ( k == ATOM_sort_parallel_threshold )
+      { GD->thread.sort.threshold = (i > 0 ? (size_t)i : 0);
       }
 #endif
       else if ( k == ATOM_stack_limit )
@@ -1489,6 +1493,11 @@ initPrologFlags(void)
   setPrologFlag("gc_thread",    FT_BOOL,
 		!GD->options.nothreads &&
 		truePrologFlag(PLFLAG_GCTHREAD), PLFLAG_GCTHREAD);
+  setPrologFlag("index_async_threshold", FT_INTEGER,
+		GD->thread.index.async_threshold);
+  GD->thread.sort.threshold = PARALLEL_SORT_THRESHOLD;
+  setPrologFlag("sort_parallel_threshold", FT_INTEGER,
+		GD->thread.sort.threshold);
 #else
   setPrologFlag("threads",	FT_BOOL|FF_READONLY, FALSE, 0);
   setPrologFlag("gc_thread",    FT_BOOL|FF_READONLY, FALSE, PLFLAG_GCTHREAD);
@@ -1553,6 +1562,7 @@ initPrologFlags(void)
   setPrologFlag("stream_type_check", FT_ATOM, "loose");
   setPrologFlag("occurs_check", FT_ATOM, "false");
   setPrologFlag("shift_check", FT_BOOL, FALSE,  PLFLAG_SHIFT_CHECK);
+  setPrologFlag("index_statistics", FT_BOOL, FALSE, PLFLAG_INDEX_STATISTICS);
   setPrologFlag("access_level", FT_ATOM, "user");
   setPrologFlag("double_quotes", FT_ATOM,
 		GD->options.traditional ? "codes" : "string");
@@ -166,9 +166,363 @@ GC_linger(void *ptr)
 #include <mcheck.h>
 #endif
 
+#ifdef O_ALLOC_CACHE
+
+		 /*******************************
+		 *	  SMALL BLOCK CACHE	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Clause compilation, records, indirect data, trie nodes, etc. allocate and
+free many small blocks through allocHeap() and freeHeap().  With many
+threads this causes contention on the malloc() arenas.  We therefore keep
+a per-thread cache of free blocks, segregated in size classes of
+ALLOC_CACHE_GRANULE bytes up to ALLOC_CACHE_MAX_SIZE.  If a thread's bin
+exceeds 2*ALLOC_CACHE_BATCH blocks, ALLOC_CACHE_BATCH blocks are moved as
+a single chain to a global depot, from where another thread can fetch the
+whole chain at once if its bin is empty.
+
+Blocks in the cache are normal malloc() blocks. freeHeap() determines the
+size class from malloc_usable_size() rather than from the passed size, so
+blocks allocated using malloc() or with an inaccurate size are handled
+safely, as are blocks from allocHeap() that are passed to free().
+
+The per-thread cache is reached through a pthread key, whose destructor
+moves the cached blocks to the depot when the thread terminates.  After
+that, the thread uses plain malloc() and free().  A Prolog thread links
+its LD to the cache of the OS thread that runs it (see attachAllocCache())
+so thread_statistics/3 can report the counts of another thread.  The link
+is protected by alloc_depot_mutex.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define ALLOC_CACHE_GRANULE	16	/* Size class granularity */
+#define ALLOC_CACHE_MAX_SIZE	512	/* Larger blocks use malloc() */
+#define ALLOC_CACHE_CLASSES	(ALLOC_CACHE_MAX_SIZE/ALLOC_CACHE_GRANULE)
+#define ALLOC_CACHE_BATCH	32	/* Blocks moved to/from the depot */
+#define ALLOC_CACHE_DEPOT_MAX	(1024*1024) /* Max bytes per class in depot */
+
+#define size_class(n)	(((n)-1)/ALLOC_CACHE_GRANULE)
+#define class_size(c)	(((c)+1)*ALLOC_CACHE_GRANULE)
+
+typedef struct free_block
+{ struct free_block *next;		/* Next in bin or batch */
+  struct free_block *next_batch;	/* Next batch in the depot */
+} free_block;
+
+typedef struct alloc_bin
+{ free_block   *blocks;			/* Free blocks */
+  size_t	count;			/* # blocks in blocks */
+  size_t	hits;			/* Allocations from the cache */
+  size_t	misses;			/* Allocations from malloc() */
+} alloc_bin;
+
+typedef struct alloc_cache
+{ PL_local_data_t *ld;			/* Prolog thread using the cache */
+  alloc_bin	bins[ALLOC_CACHE_CLASSES];
+} alloc_cache;
+
+typedef struct depot_bin
+{ free_block   *batches;		/* Chains of ALLOC_CACHE_BATCH blocks */
+  size_t	count;			/* # batches */
+  size_t	hits;			/* Folded hits of all threads */
+  size_t	misses;			/* Folded misses of all threads */
+} depot_bin;
+
+static pthread_once_t alloc_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  alloc_cache_key;
+static pthread_mutex_t alloc_depot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static depot_bin alloc_depot[ALLOC_CACHE_CLASSES];
+
+static void
+fold_bin_statistics(alloc_bin *b, depot_bin *d)
+{ d->hits   += b->hits;
+  d->misses += b->misses;
+  b->hits = b->misses = 0;
+}
+
+
+static void
+free_chain(free_block *b)
+{ while(b)
+  { free_block *next = b->next;
+
+    free(b);
+    b = next;
+  }
+}
+
+
+static void
+put_depot(int c, alloc_bin *b, size_t keep)
+{ depot_bin *d = &alloc_depot[c];
+
+  while ( b->count > keep )
+  { free_block *head = b->blocks;
+    free_block *tail = head;
+    size_t n;
+
+    for(n=1; n<ALLOC_CACHE_BATCH && tail->next; n++)
+      tail = tail->next;
+    b->blocks = tail->next;
+    b->count -= n;
+    tail->next = NULL;
+
+    pthread_mutex_lock(&alloc_depot_mutex);
+    fold_bin_statistics(b, d);
+    if ( (d->count+1)*ALLOC_CACHE_BATCH*class_size(c) <=
+	 ALLOC_CACHE_DEPOT_MAX )
+    { head->next_batch = d->batches;
+      d->batches = head;
+      d->count++;
+      head = NULL;
+    }
+    pthread_mutex_unlock(&alloc_depot_mutex);
+
+    free_chain(head);
+  }
+}
+
+
+static int
+get_depot(int c, alloc_bin *b)
+{ depot_bin *d = &alloc_depot[c];
+  free_block *batch;
+
+  if ( !d->batches )			/* unlocked peek */
+    return FALSE;
+
+  pthread_mutex_lock(&alloc_depot_mutex);
+  if ( (batch = d->batches) )
+  { d->batches = batch->next_batch;
+    d->count--;
+  }
+  fold_bin_statistics(b, d);
+  pthread_mutex_unlock(&alloc_depot_mutex);
+
+  if ( batch )
+  { size_t n = 1;
+    free_block *tail;
+
+    for(tail=batch; tail->next; tail = tail->next)
+      n++;
+    tail->next = b->blocks;
+    b->blocks = batch;
+    b->count += n;
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+static void
+release_alloc_cache(void *closure)
+{ alloc_cache *cache = closure;
+  int c;
+
+  pthread_mutex_lock(&alloc_depot_mutex);
+  if ( cache->ld )
+    cache->ld->alloc_cache = NULL;
+  pthread_mutex_unlock(&alloc_depot_mutex);
+
+  for(c=0; c<ALLOC_CACHE_CLASSES; c++)
+  { alloc_bin *b = &cache->bins[c];
+
+    put_depot(c, b, 0);
+    pthread_mutex_lock(&alloc_depot_mutex);
+    fold_bin_statistics(b, &alloc_depot[c]);
+    pthread_mutex_unlock(&alloc_depot_mutex);
+  }
+  free(cache);
+}
+
+
+static void
+alloc_cache_create_key(void)
+{ pthread_key_create(&alloc_cache_key, release_alloc_cache);
+}
+
+
+static alloc_cache *
+thread_alloc_cache(int create)
+{ alloc_cache *cache;
+
+  pthread_once(&alloc_cache_once, alloc_cache_create_key);
+  if ( (cache = pthread_getspecific(alloc_cache_key)) )
+    return cache;
+
+  if ( create && (cache = calloc(1, sizeof(*cache))) )
+  { if ( pthread_setspecific(alloc_cache_key, cache) != 0 )
+    { free(cache);
+      return NULL;
+    }
+  }
+
+  return cache;
+}
+
+
+static void *
+alloc_cached(size_t n)
+{ alloc_cache *cache;
+
+  if ( n > 0 && n <= ALLOC_CACHE_MAX_SIZE &&
+       (cache = thread_alloc_cache(TRUE)) )
+  { int c = size_class(n);
+    alloc_bin *b = &cache->bins[c];
+
+    if ( b->blocks || get_depot(c, b) )
+    { free_block *mem = b->blocks;
+
+      b->blocks = mem->next;
+      b->count--;
+      b->hits++;
+
+      return mem;
+    }
+
+    b->misses++;
+    return malloc(class_size(c));
+  }
+
+  return malloc(n);
+}
+
+
+static void
+free_cached(void *mem)
+{ alloc_cache *cache;
+  size_t size;
+
+  if ( mem &&
+       (size = malloc_usable_size(mem)) >= ALLOC_CACHE_GRANULE &&
+       size < ALLOC_CACHE_MAX_SIZE+ALLOC_CACHE_GRANULE &&
+       (cache = thread_alloc_cache(FALSE)) )
+  { int c = size/ALLOC_CACHE_GRANULE - 1; /* largest class that fits */
+    alloc_bin *b;
+    free_block *fb = mem;
+
+    if ( c >= ALLOC_CACHE_CLASSES )
+      c = ALLOC_CACHE_CLASSES-1;
+    b = &cache->bins[c];
+
+    fb->next = b->blocks;
+    b->blocks = fb;
+    if ( ++b->count > 2*ALLOC_CACHE_BATCH )
+      put_depot(c, b, ALLOC_CACHE_BATCH);
+
+    return;
+  }
+
+  free(mem);
+}
+
+
+/** flushAllocCache() moves the blocks cached by the calling thread to
+ * the global depot, e.g., before the thread becomes idle.
+ */
+
+void
+flushAllocCache(void)
+{ alloc_cache *cache;
+
+  if ( (cache = thread_alloc_cache(FALSE)) )
+  { int c;
+
+    for(c=0; c<ALLOC_CACHE_CLASSES; c++)
+      put_depot(c, &cache->bins[c], 0);
+  }
+}
+
+
+/** attachAllocCache() links `ld` to the cache of the calling OS thread
+ * and detachAllocCache() removes this link before `ld` is discarded.
+ * An OS thread that creates an engine keeps its cache linked to its
+ * own LD.
+ */
+
+void
+attachAllocCache(PL_local_data_t *ld)
+{ alloc_cache *cache;
+
+  if ( (cache = thread_alloc_cache(TRUE)) )
+  { pthread_mutex_lock(&alloc_depot_mutex);
+    if ( !cache->ld )
+    { cache->ld = ld;
+      ld->alloc_cache = cache;
+    }
+    pthread_mutex_unlock(&alloc_depot_mutex);
+  }
+}
+
+
+void
+detachAllocCache(PL_local_data_t *ld)
+{ pthread_mutex_lock(&alloc_depot_mutex);
+  if ( ld->alloc_cache )
+  { ld->alloc_cache->ld = NULL;
+    ld->alloc_cache = NULL;
+  }
+  pthread_mutex_unlock(&alloc_depot_mutex);
+}
+
+
+/** statistics(heap_cache, -Classes)
+ *
+ * Unify Classes with a list size_class(Size, Hits, Misses, Cached),
+ * where Hits and Misses count allocations served from the cache and
+ * malloc() and Cached is the number of blocks in the global depot.
+ * Hits and misses are those of the thread running `ld` plus the counts
+ * other threads added when they exchanged blocks with the depot or
+ * terminated.
+ */
+
+int
+unify_alloc_cache_statistics(term_t t, PL_local_data_t *ld)
+{ GET_LD
+  term_t tail = PL_copy_term_ref(t);
+  term_t head = PL_new_term_ref();
+  int c;
+
+  for(c=0; c<ALLOC_CACHE_CLASSES; c++)
+  { depot_bin *d = &alloc_depot[c];
+    size_t hits, misses, cached;
+
+    pthread_mutex_lock(&alloc_depot_mutex);
+    hits   = d->hits;
+    misses = d->misses;
+    cached = d->count*ALLOC_CACHE_BATCH;
+    if ( ld->alloc_cache )
+    { hits   += ld->alloc_cache->bins[c].hits;
+      misses += ld->alloc_cache->bins[c].misses;
+    }
+    pthread_mutex_unlock(&alloc_depot_mutex);
+
+    if ( !PL_unify_list(tail, head, tail) ||
+	 !PL_unify_term(head,
+			PL_FUNCTOR, FUNCTOR_size_class4,
+			  PL_INT, (int)class_size(c),
+			  PL_INT64, (int64_t)hits,
+			  PL_INT64, (int64_t)misses,
+			  PL_INT64, (int64_t)cached) )
+      return FALSE;
+  }
+
+  return PL_unify_nil(tail);
+}
+
+#else /*O_ALLOC_CACHE*/
+
+#define alloc_cached(n) malloc(n)
+#define free_cached(p)	free(p)
+
+#endif /*O_ALLOC_CACHE*/
+
+
 void *
 allocHeap(size_t n)
-{ void *mem = malloc(n);
+{ void *mem = alloc_cached(n);
 
 #if ALLOC_DEBUG
   if ( mem )
@@ -203,7 +557,7 @@ freeHeap(void *mem, size_t n)
   (void)n;
 #endif
 
-  free(mem);
+  free_cached(mem);
 }
 
 #endif /*PL_ALLOC_DONE*/
@@ -1096,9 +1450,8 @@ valBignum__LD(word w ARG_LD)
 		 *******************************/
 
 int
-equalIndirect(word w1, word w2)
-{ GET_LD
-  Word p1 = addressIndirect(w1);
+equalIndirect__LD(word w1, word w2 ARG_LD)
+{ Word p1 = addressIndirect(w1);
   Word p2 = addressIndirect(w2);
 
   if ( *p1 == *p2 )
@@ -1853,7 +2206,11 @@ PRED_IMPL("thread_idle", 2, thread_idle, PL_FA_TRANSPARENT)
 	 fMallocExtension_MarkThreadBusy )
       fMallocExtension_MarkThreadTemporarilyIdle();
   } else if ( how == ATOM_long )
-  { LD->trim_stack_requested = TRUE;
+  {
+#ifdef O_ALLOC_CACHE
+    flushAllocCache();
+#endif
+    LD->trim_stack_requested = TRUE;
     garbageCollect(GC_USER);
     LD->trim_stack_requested = FALSE;
     if ( fMallocExtension_MarkThreadIdle  &&
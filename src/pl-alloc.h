@@ -69,6 +69,10 @@ COMMON(void) GC_linger(void *ptr);
 #define allocForeignState(size)			allocHeapOrHalt(size)
 #define freeForeignState(ptr, size)		freeHeap(ptr, size)
 
+#if defined(O_PLMT) && defined(HAVE_MALLOC_USABLE_SIZE) && !defined(DMALLOC)
+#define O_ALLOC_CACHE 1			/* Thread-local small block cache */
+#endif
+
 #endif /*HAVE_BOEHM_GC*/
 
 		 /*******************************
@@ -98,6 +102,13 @@ COMMON(void *)		allocHeap(size_t n);
 COMMON(void *)		allocHeapOrHalt(size_t n);
 COMMON(void)		freeHeap(void *mem, size_t n);
 #endif /*DMALLOC*/
+#ifdef O_ALLOC_CACHE
+COMMON(void)		flushAllocCache(void);
+COMMON(void)		attachAllocCache(PL_local_data_t *ld);
+COMMON(void)		detachAllocCache(PL_local_data_t *ld);
+COMMON(int)		unify_alloc_cache_statistics(term_t t,
+						     PL_local_data_t *ld);
+#endif
 COMMON(int)		enableSpareStack(Stack s, int always);
 COMMON(void)		enableSpareStacks(void);
 COMMON(int)		outOfStack(void *stack, stack_overflow_action how);
@@ -118,7 +129,7 @@ COMMON(int)		put_int64(Word p, int64_t i, int flags ARG_LD);
 #if ALIGNOF_INT64_T != ALIGNOF_VOIDP
 COMMON(int64_t)		valBignum__LD(word w ARG_LD);
 #endif
-COMMON(int)		equalIndirect(word r1, word r2);
+COMMON(int)		equalIndirect__LD(word r1, word r2 ARG_LD);
 ALLOC_INLINE(size_t)	gsizeIndirectFromCode(Code PC);
 COMMON(word)		globalIndirectFromCode(Code *PC);
 COMMON(void *)		tmp_malloc(size_t req);
@@ -155,6 +166,7 @@ ALLOC_INLINE(struct word_and_Code)
 #define allocGlobal(n)		allocGlobal__LD(n PASS_LD)
 #define allocGlobalNoShift(n)	allocGlobalNoShift__LD(n PASS_LD)
 #define getCharsString(s, l)	getCharsString__LD(s, l PASS_LD)
+#define equalIndirect(r1, r2)	equalIndirect__LD(r1, r2 PASS_LD)
 #define getCharsWString(s, l)	getCharsWString__LD(s, l PASS_LD)
 
 #endif /*PL_ALLOC_H_INCLUDED*/
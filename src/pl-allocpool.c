@@ -91,3 +91,130 @@ free_to_pool(alloc_pool *pool, void *mem, size_t bytes)
       free(pool);
   }
 }
+
+
+		 /*******************************
+		 *	       ARENAS		*
+		 *******************************/
+
+#ifdef O_PLMT
+#define LOCK_ARENA(a)	simpleMutexLock(&(a)->mutex)
+#define UNLOCK_ARENA(a)	simpleMutexUnlock(&(a)->mutex)
+#else
+#define LOCK_ARENA(a)	(void)0
+#define UNLOCK_ARENA(a)	(void)0
+#endif
+
+#define arena_class(bytes) (((bytes)+ARENA_ALIGN-1)/ARENA_ALIGN - 1)
+#define arena_class_size(c) (((c)+1)*ARENA_ALIGN)
+
+void
+init_alloc_arena(alloc_arena *arena, alloc_pool *pool)
+{ memset(arena, 0, sizeof(*arena));
+  arena->pool = pool;
+#ifdef O_PLMT
+  simpleMutexInit(&arena->mutex);
+#endif
+}
+
+
+void
+destroy_alloc_arena(alloc_arena *arena)
+{ empty_alloc_arena(arena);
+#ifdef O_PLMT
+  simpleMutexDelete(&arena->mutex);
+#endif
+}
+
+
+/** empty_alloc_arena() releases all slabs of the arena, invalidating
+ * all blocks allocated from it.  The caller must ensure none of these
+ * blocks is accessed any longer.
+ */
+
+void
+empty_alloc_arena(alloc_arena *arena)
+{ alloc_slab *slab, *next;
+
+  LOCK_ARENA(arena);
+  slab = arena->slabs;
+  arena->slabs = NULL;
+  arena->top = arena->max = NULL;
+  memset(arena->free, 0, sizeof(arena->free));
+  arena->slab_count = 0;
+  arena->slab_bytes = 0;
+  arena->in_use = 0;
+  arena->discarding = FALSE;
+  UNLOCK_ARENA(arena);
+
+  for(; slab; slab = next)
+  { next = slab->next;
+    free_to_pool(arena->pool, slab, slab->size);
+  }
+}
+
+
+static int
+new_slab(alloc_arena *arena)
+{ size_t size = arena->slabs ? arena->slabs->size*2 : ARENA_MIN_SLAB;
+  alloc_slab *slab;
+
+  if ( size > ARENA_MAX_SLAB )
+    size = ARENA_MAX_SLAB;
+  if ( !(slab = alloc_from_pool(arena->pool, size)) )
+    return FALSE;
+
+  slab->next = arena->slabs;
+  slab->size = size;
+  arena->slabs = slab;
+  arena->top = (char*)(slab+1);
+  arena->max = (char*)slab + size;
+  arena->slab_count++;
+  arena->slab_bytes += size;
+
+  return TRUE;
+}
+
+
+void *
+alloc_from_arena(alloc_arena *arena, size_t bytes)
+{ if ( bytes <= ARENA_MAX_BLOCK )
+  { int c = arena_class(bytes);
+    size_t size = arena_class_size(c);
+    void *mem;
+
+    LOCK_ARENA(arena);
+    if ( (mem = arena->free[c]) )
+    { arena->free[c] = *(void**)mem;
+    } else if ( arena->top+size <= arena->max || new_slab(arena) )
+    { mem = arena->top;
+      arena->top += size;
+    }
+    if ( mem )
+      arena->in_use += size;
+    UNLOCK_ARENA(arena);
+
+    return mem;
+  }
+
+  return alloc_from_pool(arena->pool, bytes);
+}
+
+
+void
+free_to_arena(alloc_arena *arena, void *mem, size_t bytes)
+{ if ( bytes <= ARENA_MAX_BLOCK )
+  { int c = arena_class(bytes);
+
+    if ( arena->discarding )
+      return;
+
+    LOCK_ARENA(arena);
+    *(void**)mem = arena->free[c];
+    arena->free[c] = mem;
+    arena->in_use -= arena_class_size(c);
+    UNLOCK_ARENA(arena);
+  } else
+  { free_to_pool(arena->pool, mem, bytes);
+  }
+}
@@ -44,9 +44,46 @@ typedef struct alloc_pool
   int		freed;				/* Pool is freed */
 } alloc_pool;
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+An alloc_arena  allocates  small  fixed  size  blocks  from  slabs  that
+are allocated from an alloc_pool. Freed blocks are kept in a free list per
+size class and all slabs are released at once by empty_alloc_arena().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define ARENA_ALIGN		sizeof(void*)
+#define ARENA_CLASSES		8	/* Blocks upto 8*ARENA_ALIGN bytes */
+#define ARENA_MAX_BLOCK		(ARENA_CLASSES*ARENA_ALIGN)
+#define ARENA_MIN_SLAB		512	/* Size of first slab */
+#define ARENA_MAX_SLAB		(64*1024) /* Slabs double upto this size */
+
+typedef struct alloc_slab
+{ struct alloc_slab *next;			/* Next slab */
+  size_t	size;				/* Size including header */
+} alloc_slab;
+
+typedef struct alloc_arena
+{ alloc_pool   *pool;				/* Pool for the slabs */
+  alloc_slab   *slabs;				/* List of slabs */
+  char	       *top;				/* Free space in current slab */
+  char	       *max;				/* End of current slab */
+  void	       *free[ARENA_CLASSES];		/* Free lists per class */
+  size_t	slab_count;			/* # slabs */
+  size_t	slab_bytes;			/* Total size of the slabs */
+  size_t	in_use;				/* Bytes in allocated blocks */
+  int		discarding;			/* empty_alloc_arena() is near */
+#ifdef O_PLMT
+  simpleMutex	mutex;				/* Serialize access */
+#endif
+} alloc_arena;
+
 COMMON(alloc_pool*)	new_alloc_pool(const char *name, size_t limit);
 COMMON(void)		free_alloc_pool(alloc_pool *pool);
 COMMON(void *)		alloc_from_pool(alloc_pool *pool, size_t bytes);
 COMMON(void)		free_to_pool(alloc_pool *pool, void *mem, size_t bytes);
+COMMON(void)		init_alloc_arena(alloc_arena *arena, alloc_pool *pool);
+COMMON(void)		destroy_alloc_arena(alloc_arena *arena);
+COMMON(void)		empty_alloc_arena(alloc_arena *arena);
+COMMON(void *)		alloc_from_arena(alloc_arena *arena, size_t bytes);
+COMMON(void)		free_to_arena(alloc_arena *arena, void *mem, size_t bytes);
 
 #endif /*_PL_ALLOCPOOL_H*/
@@ -134,7 +134,6 @@ problem.
 #endif
 
 static int		ar_minus(Number n1, Number n2, Number r);
-static int		mul64(int64_t x, int64_t y, int64_t *r);
 static int		notLessThanZero(const char *f, int a, Number n);
 static int		mustBePositive(const char *f, int a, Number n);
 static int		set_roundtoward(Word p, Number old ARG_LD);
@@ -1405,9 +1404,171 @@ ar_add_ui(Number n, intptr_t add)
 
 #define SAME_SIGN(i1, i2) (((i1) ^ (i2)) >= 0)
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+128-bit integer fast path for +, - and *.  Integers just outside the
+int64 range (64-bit unsigned hashes and IDs, intermediate products)  are
+represented as GMP numbers.  Adding or multiplying them using GMP first
+promotes the V_INTEGER operand to a GMP number and then allocates the
+result.  If both operands fit in 126 bits we compute the result using
+native 128-bit arithmetic.  The result is returned as V_INTEGER if it
+fits.  Otherwise it is a GMP number that is allocated using a single
+mpz_init2() call and whose limbs are filled directly, so no operand is
+promoted and GMP arithmetic is not used.  Limiting operands to 126 bits
+implies that addition and subtraction cannot overflow.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if defined(O_GMP) && defined(__SIZEOF_INT128__) && \
+    GMP_LIMB_BITS == 64 && GMP_NAIL_BITS == 0
+#define O_INT128 1
+
+typedef __int128	   int128_t;
+typedef unsigned __int128 uint128_t;
+
+typedef enum
+{ I128_ADD,
+  I128_SUB,
+  I128_MUL
+} i128_op;
+
+#define I128_MAX_BITS 126
+
+static int
+get_int128(const Number n, int128_t *v)
+{ switch(n->type)
+  { case V_INTEGER:
+      *v = n->value.i;
+      return TRUE;
+    case V_MPZ:
+    { int size = n->value.mpz->_mp_size;
+      const mp_limb_t *d = n->value.mpz->_mp_d;
+      uint128_t m;
+
+      switch(size < 0 ? -size : size)
+      { case 0:
+	  m = 0;
+	  break;
+	case 1:
+	  m = d[0];
+	  break;
+	case 2:
+	  m = ((uint128_t)d[1]<<64) | d[0];
+	  if ( m >> I128_MAX_BITS )
+	    return FALSE;
+	  break;
+	default:
+	  return FALSE;
+      }
+      *v = (size < 0 ? -(int128_t)m : (int128_t)m);
+      return TRUE;
+    }
+    default:
+      return FALSE;
+  }
+}
+
+static void
+put_int128(int128_t v, Number r)
+{ if ( v >= INT64_MIN && v <= INT64_MAX )
+  { r->value.i = (int64_t)v;
+    r->type = V_INTEGER;
+  } else
+  { uint128_t m = (v < 0 ? -(uint128_t)v : (uint128_t)v);
+    int size = (m >> 64) ? 2 : 1;
+
+    r->type = V_MPZ;
+    mpz_init2(r->value.mpz, 128);
+    r->value.mpz->_mp_d[0] = (mp_limb_t)m;
+    r->value.mpz->_mp_d[1] = (mp_limb_t)(m >> 64);
+    r->value.mpz->_mp_size = (v < 0 ? -size : size);
+  }
+}
+
+/* Multiply two magnitudes below 2^126.  Fails if the product does not
+   fit in I128_MAX_BITS.
+*/
+
+static int
+mul_uint128(uint128_t a, uint128_t b, uint128_t *r)
+{ uint64_t ah = (uint64_t)(a >> 64);
+  uint64_t bh = (uint64_t)(b >> 64);
+  uint128_t lo, hi;
+
+  if ( ah && bh )
+    return FALSE;
+  if ( bh )
+  { uint128_t t = a; a = b; b = t;
+    ah = bh;
+  }
+  lo = (uint128_t)(uint64_t)a * (uint64_t)b;
+  hi = (uint128_t)ah * (uint64_t)b;
+  if ( hi >> (I128_MAX_BITS-64) )
+    return FALSE;
+  *r = (hi << 64) + lo;
+
+  return *r >= lo && !(*r >> I128_MAX_BITS);
+}
+
+/* Returns TRUE if the result is in r, -1 if the operation must be
+   done by GMP.
+*/
+
+static int
+ar_int128(i128_op op, Number n1, Number n2, Number r)
+{ int128_t i1, i2, ir;
+
+  if ( !get_int128(n1, &i1) || !get_int128(n2, &i2) )
+    return -1;
+
+  switch(op)
+  { case I128_ADD:
+      ir = i1 + i2;
+      break;
+    case I128_SUB:
+      ir = i1 - i2;
+      break;
+    case I128_MUL:
+    { uint128_t m1 = (i1 < 0 ? -(uint128_t)i1 : (uint128_t)i1);
+      uint128_t m2 = (i2 < 0 ? -(uint128_t)i2 : (uint128_t)i2);
+      uint128_t m;
+
+      if ( !mul_uint128(m1, m2, &m) )
+	return -1;
+      ir = ((i1 < 0) != (i2 < 0) ? -(int128_t)m : (int128_t)m);
+      break;
+    }
+    default:
+      assert(0);
+      return -1;
+  }
+
+  put_int128(ir, r);
+  return TRUE;
+}
+
+#define AR_INT128(op, n1, n2, r) \
+	do \
+	{ int rc128; \
+	  if ( ((n1)->type == V_MPZ || (n2)->type == V_MPZ) && \
+	       (rc128=ar_int128(op, n1, n2, r)) >= 0 ) \
+	    return rc128; \
+	} while(0)
+#define AR_INT128_OVERFLOW(op, n1, n2, r) \
+	do \
+	{ int rc128; \
+	  if ( (rc128=ar_int128(op, n1, n2, r)) >= 0 ) \
+	    return rc128; \
+	} while(0)
+#else
+#define AR_INT128(op, n1, n2, r) (void)0
+#define AR_INT128_OVERFLOW(op, n1, n2, r) (void)0
+#endif /*O_INT128*/
+
+
 int
 pl_ar_add(Number n1, Number n2, Number r)
-{ if ( !same_type_numbers(n1, n2) )
+{ AR_INT128(I128_ADD, n1, n2, r);
+
+  if ( !same_type_numbers(n1, n2) )
     return FALSE;
 
   switch(n1->type)
@@ -1425,6 +1586,7 @@ pl_ar_add(Number n1, Number n2, Number r)
       r->type = V_INTEGER;
       succeed;
     overflow:
+      AR_INT128_OVERFLOW(I128_ADD, n1, n2, r);
       if ( !promoteIntNumber(n1) ||
 	   !promoteIntNumber(n2) )
 	fail;
@@ -1459,7 +1621,9 @@ pl_ar_add(Number n1, Number n2, Number r)
 
 static int
 ar_minus(Number n1, Number n2, Number r)
-{ if ( !same_type_numbers(n1, n2) )
+{ AR_INT128(I128_SUB, n1, n2, r);
+
+  if ( !same_type_numbers(n1, n2) )
     return FALSE;
 
   switch(n1->type)
@@ -1469,6 +1633,7 @@ ar_minus(Number n1, Number n2, Number r)
       if ( (n1->value.i >= 0 && n2->value.i < 0 && r->value.i <= 0) ||
 	   (n1->value.i < 0  && n2->value.i > 0 && r->value.i >= 0) )
       {					/* overflow */
+	AR_INT128_OVERFLOW(I128_SUB, n1, n2, r);
 	if ( !promoteIntNumber(n1) ||
 	     !promoteIntNumber(n2) )
 	  fail;
@@ -3062,7 +3227,7 @@ mul64(int64_t x, int64_t y, int64_t *r)
 #define INT64_MIN (LL(1)<<63)
 #endif
 
-static int
+int
 mul64(int64_t x, int64_t y, int64_t *r)
 { if ( x == LL(0) || y == LL(0) )
   { *r = LL(0);
@@ -3111,7 +3276,9 @@ mul64(int64_t x, int64_t y, int64_t *r)
 
 int
 ar_mul(Number n1, Number n2, Number r)
-{ if ( !same_type_numbers(n1, n2) )
+{ AR_INT128(I128_MUL, n1, n2, r);
+
+  if ( !same_type_numbers(n1, n2) )
     return FALSE;
 
   switch(n1->type)
@@ -3120,6 +3287,7 @@ ar_mul(Number n1, Number n2, Number r)
       { r->type = V_INTEGER;
 	succeed;
       }
+      AR_INT128_OVERFLOW(I128_MUL, n1, n2, r);
       /*FALLTHROUGH*/
 #ifdef O_GMP
       promoteToMPZNumber(n1);
@@ -3160,7 +3328,7 @@ is_min_zero(const Number n)
 { return n->type == V_FLOAT && n->value.f == 0.0 && signbit(n->value.f);
 }
 
-static int
+int
 ar_max(Number n1, Number n2, Number r)
 { int diff = cmpNumbers(n1, n2);
 
@@ -3189,7 +3357,7 @@ ar_max(Number n1, Number n2, Number r)
 }
 
 
-static int
+int
 ar_min(Number n1, Number n2, Number r)
 { int diff = cmpNumbers(n1, n2);
 
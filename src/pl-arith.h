@@ -51,7 +51,10 @@
 COMMON(int)		ar_compare(Number n1, Number n2, int what);
 COMMON(int)		ar_compare_eq(Number n1, Number n2);
 COMMON(int)		pl_ar_add(Number n1, Number n2, Number r);
+COMMON(int)		ar_max(Number n1, Number n2, Number r);
+COMMON(int)		ar_min(Number n1, Number n2, Number r);
 COMMON(int)		ar_mul(Number n1, Number n2, Number r);
+COMMON(int)		mul64(int64_t x, int64_t y, int64_t *r);
 COMMON(word)		pl_current_arithmetic_function(term_t f, control_t h);
 COMMON(void)		initArith(void);
 COMMON(void)		cleanupArith(void);
@@ -39,6 +39,8 @@
 #include "pl-rec.h"
 #include "pl-gc.h"
 #include "pl-fli.h"
+#include "pl-arith.h"
+#include <fenv.h>
 
 #undef LD
 #define LD LOCAL_LD
@@ -111,6 +113,17 @@ alloc_mem_pool(mem_pool *mp, size_t bytes)
   return ptr;
 }
 
+/* Give back the last allocation from alloc_mem_pool() */
+
+static void
+unalloc_mem_pool(mem_pool *mp, void *ptr, size_t bytes)
+{ mem_chunk *c = mp->chunks;
+  size_t used = ROUNDUP(bytes, sizeof(void*));
+
+  if ( (char *)ptr + used == &((char *)(c+1))[c->used] )
+    c->used -= used;
+}
+
 static void
 clear_mem_pool(mem_pool *mp)
 { mem_chunk *c, *p;
@@ -131,6 +144,48 @@ clear_mem_pool(mem_pool *mp)
 
 #define FINDALL_MAGIC	0x37ac78fe
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Answers that are a small integer or an  atom are not compiled to a record
+but their tagged word is stored directly in the `answers` segstack. This
+avoids compiling and copying a record  for   the  most  common answers of
+findall/3.  Such answers are distinguished   from  record pointers (which
+are at least 4-byte aligned) by the low bit: TAG_INTEGER and TAG_ATOM are
+both odd.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if !(TAG_INTEGER&0x1) || !(TAG_ATOM&0x1)
+#error "Inline findall answers require odd TAG_INTEGER and TAG_ATOM"
+#endif
+
+#define isInlineAnswer(r)	((uintptr_t)(r) & 0x1)
+#define inlineAnswerWord(r)	((word)(uintptr_t)(r))
+#define wordToInlineAnswer(w)	((Record)(uintptr_t)(w))
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A bag may be created  for  aggregate_all/3   from  library(aggregate).
+Instead of storing the answers, the   numeric  operations only maintain
+the aggregated value and thus run in  constant space. The value is kept
+in `value` if it is an int64 or float.  Other numbers (big integers and
+rationals) are kept as a record as their  GMP memory is released by the
+arithmetic context that created them.  The witness for max(X,W) and
+min(X,W) is kept as a record that locks its atoms.
+
+AGGR_SET bags store answers as normal  findall/3 bags, but skip ground
+answers that are already in the bag. The caller sorts the collected list
+to obtain the final set.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef enum
+{ AGGR_NONE = 0,			/* Plain findall/3 bag */
+  AGGR_COUNT,				/* count */
+  AGGR_SUM,				/* sum(X) */
+  AGGR_MAX,				/* max(X) */
+  AGGR_MIN,				/* min(X) */
+  AGGR_MAX_WITNESS,			/* max(X,W) */
+  AGGR_MIN_WITNESS,			/* min(X,W) */
+  AGGR_SET				/* set(X) */
+} aggr_op;
+
 typedef struct findall_bag
 { struct findall_bag *parent;		/* parent bag */
   int		magic;			/* FINDALL_MAGIC */
@@ -140,14 +195,21 @@ typedef struct findall_bag
   size_t	gsize;			/* required size on stack */
   mem_pool	records;		/* stored records */
   segstack	answers;		/* list of answers */
+  aggr_op	aggregate;		/* aggregate_all/3 operation */
+  int		has_value;		/* value or big_value is valid */
+  number	value;			/* int64 or float aggregate */
+  Record	big_value;		/* other numbers */
+  Record	witness;		/* witness of min/max */
+  Record       *set;			/* AGGR_SET: ground answers */
+  size_t	set_size;		/* # slots in set (power of 2) */
+  size_t	set_count;		/* # used slots in set */
   Record	answer_buf[64];		/* tmp space */
 } findall_bag;
 
 
-static
-PRED_IMPL("$new_findall_bag", 0, new_findall_bag, 0)
-{ PRED_LD
-  findall_bag *bag;
+static int
+new_bag(aggr_op aggregate ARG_LD)
+{ findall_bag *bag;
 
   if ( !LD->bags.bags )			/* outer one */
   { if ( !LD->bags.default_bag )
@@ -171,6 +233,15 @@ PRED_IMPL("$new_findall_bag", 0, new_findall_bag, 0)
   bag->solutions	   = 0;
   bag->gsize		   = 0;
   bag->parent		   = LD->bags.bags;
+  bag->aggregate	   = aggregate;
+  bag->has_value	   = FALSE;
+  bag->value.type	   = V_INTEGER;
+  bag->value.value.i	   = 0;
+  bag->big_value	   = NULL;
+  bag->witness		   = NULL;
+  bag->set		   = NULL;
+  bag->set_size		   = 0;
+  bag->set_count	   = 0;
   init_mem_pool(&bag->records);
   initSegStack(&bag->answers, sizeof(Record),
 	       sizeof(bag->answer_buf), bag->answer_buf);
@@ -181,6 +252,14 @@ PRED_IMPL("$new_findall_bag", 0, new_findall_bag, 0)
 }
 
 
+static
+PRED_IMPL("$new_findall_bag", 0, new_findall_bag, 0)
+{ PRED_LD
+
+  return new_bag(AGGR_NONE PASS_LD);
+}
+
+
 static void *
 alloc_record(void *ctx, size_t bytes)
 { findall_bag *bag = ctx;
@@ -202,10 +281,96 @@ current_bag(ARG1_LD)
 }
 
 
+static int
+no_bag_error(term_t term)
+{ static atom_t cbag;
+
+  if ( !cbag )
+    cbag = PL_new_atom("findall-bag");
+
+  return PL_error(NULL, 0, "continuation in findall/3 generator?",
+		  ERR_PERMISSION, ATOM_append, cbag, term);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+add_set() adds a ground answer to the   hash  table  of an AGGR_SET bag.
+Returns FALSE if an identical answer is already in the bag.  Identical
+ground terms compile to identical records.   If we cannot grow the table
+we simply stop removing duplicates; sort/2 will do so afterwards.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static unsigned int
+answer_hash(Record r)
+{ if ( isInlineAnswer(r) )
+  { word w = inlineAnswerWord(r);
+
+    return MurmurHashAligned2(&w, sizeof(w), MURMUR_SEED);
+  }
+
+  return MurmurHashAligned2(r, r->size, MURMUR_SEED);
+}
+
+
+static int
+same_answer(Record r1, Record r2)
+{ if ( isInlineAnswer(r1) || isInlineAnswer(r2) )
+    return r1 == r2;
+
+  return r1->size == r2->size && memcmp(r1, r2, r1->size) == 0;
+}
+
+
+static void
+set_insert(Record *set, size_t size, Record r, unsigned int key)
+{ size_t i;
+
+  for(i = key&(size-1); set[i]; i = (i+1)&(size-1))
+    ;
+  set[i] = r;
+}
+
+
+static int
+add_set(findall_bag *bag, Record r)
+{ unsigned int key = answer_hash(r);
+  size_t i;
+
+  if ( (bag->set_count+1)*2 > bag->set_size )
+  { size_t newsize = bag->set_size ? bag->set_size*2 : 256;
+    Record *new;
+
+    if ( (new = calloc(newsize, sizeof(*new))) )
+    { for(i=0; i<bag->set_size; i++)
+      { Record r2 = bag->set[i];
+
+	if ( r2 )
+	  set_insert(new, newsize, r2, answer_hash(r2));
+      }
+      free(bag->set);
+      bag->set = new;
+      bag->set_size = newsize;
+    } else if ( bag->set_count+1 >= bag->set_size )
+    { return TRUE;
+    }
+  }
+
+  for(i = key&(bag->set_size-1); bag->set[i]; i = (i+1)&(bag->set_size-1))
+  { if ( same_answer(bag->set[i], r) )
+      return FALSE;
+  }
+  bag->set[i] = r;
+  bag->set_count++;
+
+  return TRUE;
+}
+
+
 static foreign_t
 add_findall_bag(term_t term, term_t count ARG_LD)
 { findall_bag *bag = current_bag(PASS_LD1);
   Record r;
+  Word p;
 
   DEBUG(MSG_NSOLS, { Sdprintf("Adding to %p: ", bag);
 		     PL_write_term(Serror, term, 1200,
@@ -215,20 +380,26 @@ add_findall_bag(term_t term, term_t count ARG_LD)
 		   });
 
   if ( !bag )
-  { static atom_t cbag;
-
-    if ( !cbag )
-      cbag = PL_new_atom("findall-bag");
+    return no_bag_error(term);
 
-    return PL_error(NULL, 0, "continuation in findall/3 generator?",
-		    ERR_PERMISSION, ATOM_append, cbag, term);
+  p = valTermRef(term);
+  deRef(p);
+  if ( isTaggedInt(*p) || isAtom(*p) )
+  { r = wordToInlineAnswer(*p);
+    if ( bag->aggregate == AGGR_SET && !add_set(bag, r) )
+      return FALSE;
+  } else
+  { if ( !(r = compileTermToHeap__LD(term, alloc_record, bag,
+				     R_NOLOCK PASS_LD)) )
+      return PL_no_memory();
+    if ( bag->aggregate == AGGR_SET && r->nvars == 0 && !add_set(bag, r) )
+    { unalloc_mem_pool(&bag->records, r, r->size);
+      return FALSE;
+    }
+    bag->gsize += r->gsize;
   }
-
-  if ( !(r = compileTermToHeap__LD(term, alloc_record, bag, R_NOLOCK PASS_LD)) )
-    return PL_no_memory();
   if ( !pushRecordSegStack(&bag->answers, r) )
     return PL_no_memory();
-  bag->gsize += r->gsize;
   bag->solutions++;
 
   if ( bag->gsize + bag->solutions*3 > globalStackLimit()/sizeof(word) )
@@ -275,9 +446,17 @@ PRED_IMPL("$collect_findall_bag", 2, collect_findall_bag, 0)
     while ( (rp=topOfSegStack(&bag->answers)) )
     { Record r = *rp;
       DEBUG(MSG_NSOLS, Sdprintf("Retrieving answer\n"));
-      copyRecordToGlobal(answer, r, ALLOW_GC PASS_LD);
-      if (GD->atoms.gc_active)
-        markAtomsRecord(r);
+      if ( isInlineAnswer(r) )
+      { word w = inlineAnswerWord(r);
+
+	*valTermRef(answer) = w;
+	if ( GD->atoms.gc_active && isAtom(w) )
+	  markAtom(w);
+      } else
+      { copyRecordToGlobal(answer, r, ALLOW_GC PASS_LD);
+	if (GD->atoms.gc_active)
+	  markAtomsRecord(r);
+      }
       PL_cons_list(list, answer, list);
 #ifdef O_ATOMGC
 		/* see comment with scanSegStack() for synchronization details */
@@ -297,6 +476,286 @@ PRED_IMPL("$collect_findall_bag", 2, collect_findall_bag, 0)
     return PL_unify(A1, A2);
 }
 
+
+		 /*******************************
+		 *	   AGGREGATE_ALL/3	*
+		 *******************************/
+
+static int
+get_aggregate_op(term_t t, aggr_op *op ARG_LD)
+{ atom_t a;
+
+  *op = AGGR_NONE;
+  if ( PL_get_atom_ex(t, &a) )
+  { if      ( a == ATOM_count )       *op = AGGR_COUNT;
+    else if ( a == ATOM_sum )         *op = AGGR_SUM;
+    else if ( a == ATOM_max )         *op = AGGR_MAX;
+    else if ( a == ATOM_min )         *op = AGGR_MIN;
+    else if ( a == ATOM_max_witness ) *op = AGGR_MAX_WITNESS;
+    else if ( a == ATOM_min_witness ) *op = AGGR_MIN_WITNESS;
+    else if ( a == ATOM_set )         *op = AGGR_SET;
+    else
+      return PL_domain_error("aggregate_operation", t);
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+/** '$new_aggregate_bag'(+Operation)
+
+Create a bag for aggregate_all/3.  Operation is one of `count`, `sum`,
+`max`, `min`, `max_witness`, `min_witness` or `set`.  The bag must be
+destroyed using '$destroy_findall_bag'/0.
+*/
+
+static
+PRED_IMPL("$new_aggregate_bag", 1, new_aggregate_bag, 0)
+{ PRED_LD
+  aggr_op op;
+
+  if ( !get_aggregate_op(A1, &op PASS_LD) )
+    return FALSE;
+
+  return new_bag(op PASS_LD);
+}
+
+
+static findall_bag *
+current_aggregate_bag(term_t t ARG_LD)
+{ findall_bag *bag = current_bag(PASS_LD1);
+
+  if ( !bag )
+  { no_bag_error(t);
+    return NULL;
+  }
+
+  return bag;
+}
+
+
+/* Put the current aggregated number into t */
+
+static int
+put_aggregate(term_t t, findall_bag *bag ARG_LD)
+{ if ( bag->big_value )
+    return copyRecordToGlobal(t, bag->big_value, ALLOW_GC PASS_LD) == TRUE;
+  else
+    return PL_put_number(t, &bag->value);
+}
+
+
+/* Store n as the new aggregated value. Must be called inside an
+   arithmetic context.
+*/
+
+static int
+set_aggregate(findall_bag *bag, Number n ARG_LD)
+{ if ( n->type == V_INTEGER || n->type == V_FLOAT )
+  { if ( bag->big_value )
+    { freeRecord(bag->big_value);
+      bag->big_value = NULL;
+    }
+    bag->value = *n;
+  } else
+  { term_t t;
+    Record r;
+
+    if ( !(t=PL_new_term_ref()) ||
+	 !PL_put_number(t, n) )
+      return FALSE;
+    if ( !(r = compileTermToHeap(t, R_NOLOCK)) )
+      return PL_no_memory();
+    PL_reset_term_refs(t);
+    if ( bag->big_value )
+      freeRecord(bag->big_value);
+    bag->big_value = r;
+  }
+  bag->has_value = TRUE;
+
+  return TRUE;
+}
+
+
+static int
+add_aggregate(findall_bag *bag, term_t x, term_t w ARG_LD)
+{ term_t acc = 0;
+  number n, v, r;
+  int rc;
+  AR_CTX;
+
+  if ( bag->has_value && bag->big_value )
+  { if ( !(acc = PL_new_term_ref()) ||
+	 !put_aggregate(acc, bag PASS_LD) )
+      return FALSE;
+  }
+  AR_BEGIN();
+  if ( !valueExpression(x, &n PASS_LD) )
+  { AR_CLEANUP();
+    return FALSE;
+  }
+  if ( acc )
+    rc = PL_get_number(acc, &v);	/* no GC after valueExpression() */
+  else
+    v = bag->value;
+
+  if ( !bag->has_value )
+  { if ( bag->aggregate == AGGR_SUM )
+    { v.type = V_INTEGER;
+      v.value.i = 0;
+      rc = pl_ar_add(&v, &n, &r);
+    } else
+    { cpNumber(&r, &n);
+      rc = TRUE;
+    }
+  } else
+  { switch(bag->aggregate)
+    { case AGGR_SUM:
+	rc = pl_ar_add(&v, &n, &r);
+	break;
+      case AGGR_MAX:
+	rc = ar_max(&v, &n, &r);
+	break;
+      case AGGR_MIN:
+	rc = ar_min(&v, &n, &r);
+	break;
+      case AGGR_MAX_WITNESS:
+      case AGGR_MIN_WITNESS:
+	if ( !ar_compare(&n, &v,
+			 bag->aggregate == AGGR_MAX_WITNESS ? GT : LT) )
+	{ clearNumber(&n);
+	  AR_END();
+	  return FALSE;			/* no change */
+	}
+	cpNumber(&r, &n);
+	rc = TRUE;
+	break;
+      default:
+	assert(0);
+	rc = FALSE;
+    }
+  }
+  clearNumber(&n);
+
+  if ( rc && (rc=set_aggregate(bag, &r PASS_LD)) && w )
+  { Record wr;
+
+    if ( (wr = compileTermToHeap(w, 0)) )
+    { if ( bag->witness )
+	freeRecord(bag->witness);
+      bag->witness = wr;
+    } else
+      rc = PL_no_memory();
+  }
+
+  if ( rc )
+  { clearNumber(&r);
+    AR_END();
+  } else
+  { AR_CLEANUP();
+  }
+
+  return FALSE;				/* drive the failure loop */
+}
+
+
+/** '$add_aggregate_bag'(+X)
+    '$add_aggregate_bag'(+X, +Witness)
+
+Add an answer to the current aggregate bag.  Always fails, unless an
+error is raised, such that aggregate_all/3 runs as a failure driven loop
+in constant space.
+*/
+
+static
+PRED_IMPL("$add_aggregate_bag", 1, add_aggregate_bag, 0)
+{ PRED_LD
+  findall_bag *bag;
+
+  if ( !(bag=current_aggregate_bag(A1 PASS_LD)) )
+    return FALSE;
+
+  switch(bag->aggregate)
+  { case AGGR_COUNT:
+      bag->solutions++;
+      return FALSE;
+    case AGGR_SUM:
+    case AGGR_MAX:
+    case AGGR_MIN:
+      return add_aggregate(bag, A1, 0 PASS_LD);
+    default:
+      return PL_permission_error("add", "aggregate_bag", A1);
+  }
+}
+
+
+static
+PRED_IMPL("$add_aggregate_bag", 2, add_aggregate_bag, 0)
+{ PRED_LD
+  findall_bag *bag;
+
+  if ( !(bag=current_aggregate_bag(A1 PASS_LD)) )
+    return FALSE;
+
+  if ( bag->aggregate == AGGR_MAX_WITNESS ||
+       bag->aggregate == AGGR_MIN_WITNESS )
+    return add_aggregate(bag, A1, A2 PASS_LD);
+
+  return PL_permission_error("add", "aggregate_bag", A1);
+}
+
+
+/** '$collect_aggregate_bag'(-Value)
+    '$collect_aggregate_bag'(-Value, -Witness)
+
+Unify the result of the current aggregate bag.  Fails for min and max
+if there are no answers.
+*/
+
+static
+PRED_IMPL("$collect_aggregate_bag", 1, collect_aggregate_bag, 0)
+{ PRED_LD
+  findall_bag *bag = current_bag(PASS_LD1);
+  term_t t;
+
+  switch(bag->aggregate)
+  { case AGGR_COUNT:
+      return PL_unify_int64(A1, bag->solutions);
+    case AGGR_SUM:
+      if ( !bag->has_value )
+	return PL_unify_integer(A1, 0);
+      /*FALLTHROUGH*/
+    case AGGR_MAX:
+    case AGGR_MIN:
+      if ( !bag->has_value )
+	return FALSE;
+      return ( (t=PL_new_term_ref()) &&
+	       put_aggregate(t, bag PASS_LD) &&
+	       PL_unify(A1, t) );
+    default:
+      return PL_permission_error("collect", "aggregate_bag", A1);
+  }
+}
+
+
+static
+PRED_IMPL("$collect_aggregate_bag", 2, collect_aggregate_bag, 0)
+{ PRED_LD
+  findall_bag *bag = current_bag(PASS_LD1);
+  term_t t;
+
+  if ( !bag->has_value )
+    return FALSE;
+
+  return ( (t=PL_new_term_ref()) &&
+	   put_aggregate(t, bag PASS_LD) &&
+	   PL_unify(A1, t) &&
+	   copyRecordToGlobal(t, bag->witness, ALLOW_GC PASS_LD) == TRUE &&
+	   PL_unify(A2, t) );
+}
+
 /** '$suspend_findall_bag'
 
 Used by findnsols/4,5. It is called after a complete chunk is delivered.
@@ -361,6 +820,12 @@ PRED_IMPL("$destroy_findall_bag", 0, destroy_findall_bag, 0)
 #endif
 
   bag->magic = 0;
+  if ( bag->big_value )
+    freeRecord(bag->big_value);
+  if ( bag->witness )
+    freeRecord(bag->witness);
+  if ( bag->set )
+    free(bag->set);
   clearSegStack(&bag->answers);
   clear_mem_pool(&bag->records);
   if ( bag != LD->bags.default_bag )
@@ -378,7 +843,13 @@ static void
 markAtomsAnswers(void *data)
 { Record r = *((Record*)data);
 
-  markAtomsRecord(r);
+  if ( isInlineAnswer(r) )
+  { word w = inlineAnswerWord(r);
+
+    if ( isAtom(w) )
+      markAtom(w);
+  } else
+    markAtomsRecord(r);
 }
 
 
@@ -405,6 +876,11 @@ BeginPredDefs(bag)
   PRED_DEF("$add_findall_bag",     1, add_findall_bag,     0)
   PRED_DEF("$add_findall_bag",     2, add_findall_bag,     0)
   PRED_DEF("$collect_findall_bag", 2, collect_findall_bag, 0)
+  PRED_DEF("$new_aggregate_bag",   1, new_aggregate_bag,   0)
+  PRED_DEF("$add_aggregate_bag",   1, add_aggregate_bag,   0)
+  PRED_DEF("$add_aggregate_bag",   2, add_aggregate_bag,   0)
+  PRED_DEF("$collect_aggregate_bag", 1, collect_aggregate_bag, 0)
+  PRED_DEF("$collect_aggregate_bag", 2, collect_aggregate_bag, 0)
   PRED_DEF("$destroy_findall_bag", 0, destroy_findall_bag, 0)
   PRED_DEF("$suspend_findall_bag", 0, suspend_findall_bag, PL_FA_NONDETERMINISTIC)
 EndPredDefs
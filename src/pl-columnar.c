@@ -0,0 +1,1247 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pl-incl.h"
+#include "pl-columnar.h"
+#include "pl-supervisor.h"
+#include "pl-proc.h"
+#include "pl-fli.h"
+#include "pl-hash.h"
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Columnar predicates store ground facts  whose   arguments  are  atoms,
+integers or floats in typed column  arrays   rather  than as compiled
+clauses.  A predicate is turned into a columnar predicate using
+
+    :- columnar(fact(atom, integer, atom)).
+
+after which it behaves as a  non-deterministic   foreign  predicate that
+enumerates the matching rows. Rows  are   added  using assertz/1 and
+removed using retractall/1. Each column stores one 64-bit cell per row:
+an atom handle, an int64_t or the bit pattern of a double.  The table is
+not part of the clause generation   system,  so modifications inside a
+transaction raise a permission error.
+
+Columns are indexed just-in-time, similar to clause indexing: a call with
+at least one bound argument on a  table   with  at least COL_INDEX_MIN
+rows creates a hash index for the bound  column that is expected to be
+most selective.  An index maps each  distinct   value  to the first and
+last row holding it.  Rows with the same value are chained in order of
+insertion through the next[] array of the index, so adding a row never
+reorganises existing chains.
+
+Concurrency is handled with a  mutex  per   table.  All  access to the
+column arrays, including unification against  the   caller's  goal, is
+done while holding the mutex.  lookup_table() returns the table with an
+additional reference that must be   released using release_table().  A
+table that is detached from its predicate   (abolish/1,  re-declaration)
+is freed when the last reference is released.  Enumerations  keep   a  row  number and
+the number of rows that existed when the   call was started, providing
+the logical update view for added rows.   For removed rows the table has
+its own generation counter, which is   incremented by each retractall/1.
+Removed rows are stamped with this  generation   in  erased_gen[] and an
+enumeration only skips rows erased at or  before the generation at which
+it started.  The erased_gen[] array is   only allocated after the first
+removal.  The table is compacted if more  than half its rows is erased
+and no enumeration is active.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define COL_NO_ROW	((uint32_t)-1)	/* End of chain/no match */
+#define COL_MAX_ROWS	((size_t)UINT32_MAX-1)
+#define COL_INDEX_MIN	16		/* Min rows to create an index */
+#define COL_SAMPLE	256		/* Rows sampled to assess a column */
+#define COL_MAX_ARITY	1024		/* Max # columns */
+#define COL_LOCAL	16		/* Columns handled without malloc() */
+
+typedef enum
+{ COL_ATOM = 0,
+  COL_INTEGER,
+  COL_FLOAT
+} col_type;
+
+typedef struct col_key
+{ uint64_t	key;			/* Value of the column */
+  uint32_t	head;			/* First row holding key */
+  uint32_t	tail;			/* Last row holding key */
+} col_key;
+
+typedef struct col_index
+{ size_t	size;			/* # entries (power of 2) */
+  size_t	keys;			/* # distinct values */
+  col_key      *entries;		/* Open addressing hash table */
+  uint32_t     *next;			/* Next row with the same value */
+} col_index;
+
+typedef struct column
+{ col_type	type;			/* Type of the cells */
+  unsigned	assessed : 1;		/* Selectivity is known */
+  float		speedup;		/* Estimated speedup of an index */
+  size_t	assessed_rows;		/* # rows when assessed */
+  uint64_t     *values;			/* Cell per row */
+  col_index    *index;			/* Hash index or NULL */
+} column;
+
+typedef struct col_table
+{ Definition	predicate;		/* Predicate we implement */
+#ifdef O_PLMT
+  simpleMutex	mutex;			/* Guards the table */
+#endif
+  size_t	rows;			/* # rows, including erased ones */
+  size_t	capacity;		/* Allocated rows */
+  size_t	erased;			/* # erased rows */
+  gen_t		generation;		/* Current removal generation */
+  gen_t	       *erased_gen;		/* Generation a row was erased */
+  int		enumerators;		/* # active enumerations */
+  int		references;		/* # lookup_table() references */
+  unsigned	detached : 1;		/* Predicate no longer uses us */
+  unsigned int	arity;			/* # columns */
+  column	columns[1];		/* The columns */
+} col_table;
+
+typedef struct col_enum
+{ col_table    *table;			/* Table we enumerate */
+  uint32_t	row;			/* Next candidate row */
+  uint32_t	limit;			/* Rows when enumeration started */
+  gen_t		generation;		/* Generation when started */
+  int		column;			/* Indexed column or -1 */
+} col_enum;
+
+#ifdef O_PLMT
+#define LOCK_TABLE(t)	simpleMutexLock(&(t)->mutex)
+#define UNLOCK_TABLE(t)	simpleMutexUnlock(&(t)->mutex)
+#else
+#define LOCK_TABLE(t)	(void)0
+#define UNLOCK_TABLE(t)	(void)0
+#endif
+
+#define IS_ERASED(t, r, gen) \
+	((t)->erased_gen && (t)->erased_gen[r] && (t)->erased_gen[r] <= (gen))
+
+static foreign_t columnar_call(term_t A1, int arity, control_t ctx);
+
+
+		 /*******************************
+		 *	       CELLS		*
+		 *******************************/
+
+static atom_t
+col_type_name(col_type type)
+{ switch(type)
+  { case COL_ATOM:	return ATOM_atom;
+    case COL_INTEGER:	return ATOM_integer;
+    case COL_FLOAT:	return ATOM_float;
+    default:		assert(0); return NULL_ATOM;
+  }
+}
+
+
+/* get_cell() translates a bound argument of a call into a cell value.  It
+   fails silently if the argument cannot appear in the column.
+*/
+
+static int
+get_cell(term_t t, col_type type, uint64_t *cell ARG_LD)
+{ switch(type)
+  { case COL_ATOM:
+    { atom_t a;
+
+      if ( PL_get_atom(t, &a) )
+      { *cell = (uint64_t)a;
+	return TRUE;
+      }
+      return FALSE;
+    }
+    case COL_INTEGER:
+    { int64_t i;
+
+      if ( PL_is_integer(t) && PL_get_int64(t, &i) )
+      { *cell = (uint64_t)i;
+	return TRUE;
+      }
+      return FALSE;
+    }
+    case COL_FLOAT:
+    { double f;
+
+      if ( PL_is_float(t) && PL_get_float(t, &f) )
+      { memcpy(cell, &f, sizeof(*cell));
+	return TRUE;
+      }
+      return FALSE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+/* get_cell_ex() is used for adding a row and raises an error if the
+   argument does not fit the column.
+*/
+
+static int
+get_cell_ex(term_t t, col_type type, uint64_t *cell ARG_LD)
+{ if ( get_cell(t, type, cell PASS_LD) )
+    return TRUE;
+
+  switch(type)
+  { case COL_ATOM:
+    { atom_t a;
+
+      return PL_get_atom_ex(t, &a);
+    }
+    case COL_INTEGER:
+    { int64_t i;
+
+      return PL_get_int64_ex(t, &i);
+    }
+    case COL_FLOAT:
+      if ( PL_is_variable(t) )
+	return PL_error(NULL, 0, NULL, ERR_INSTANTIATION);
+      return PL_error(NULL, 0, NULL, ERR_TYPE, ATOM_float, t);
+  }
+
+  return FALSE;
+}
+
+
+static int
+unify_cell(term_t t, col_type type, uint64_t cell ARG_LD)
+{ switch(type)
+  { case COL_ATOM:
+      return PL_unify_atom(t, (atom_t)cell);
+    case COL_INTEGER:
+      return PL_unify_int64(t, (int64_t)cell);
+    case COL_FLOAT:
+    { double f;
+
+      memcpy(&f, &cell, sizeof(f));
+      return PL_unify_float(t, f);
+    }
+  }
+
+  return FALSE;
+}
+
+
+		 /*******************************
+		 *	      INDEXES		*
+		 *******************************/
+
+static inline size_t
+key_slot(const col_index *ix, uint64_t key)
+{ return MurmurHashAligned2(&key, sizeof(key), MURMUR_SEED) & (ix->size-1);
+}
+
+
+static col_key *
+index_lookup(const col_index *ix, uint64_t key)
+{ size_t i = key_slot(ix, key);
+
+  for(;;)
+  { col_key *k = &ix->entries[i];
+
+    if ( k->head == COL_NO_ROW )
+      return NULL;
+    if ( k->key == key )
+      return k;
+    i = (i+1) & (ix->size-1);
+  }
+}
+
+
+static void
+index_resize(col_index *ix, size_t size)
+{ col_key *old = ix->entries;
+  size_t osize = ix->size;
+  size_t i;
+
+  ix->size = size;
+  ix->entries = allocHeapOrHalt(size*sizeof(*ix->entries));
+  for(i=0; i<size; i++)
+    ix->entries[i].head = COL_NO_ROW;
+
+  if ( old )
+  { for(i=0; i<osize; i++)
+    { if ( old[i].head != COL_NO_ROW )
+      { size_t s = key_slot(ix, old[i].key);
+
+	while(ix->entries[s].head != COL_NO_ROW)
+	  s = (s+1) & (size-1);
+	ix->entries[s] = old[i];
+      }
+    }
+    freeHeap(old, osize*sizeof(*old));
+  }
+}
+
+
+static void
+index_add(col_index *ix, uint64_t key, uint32_t row)
+{ size_t i;
+
+  if ( (ix->keys+1)*4 > ix->size*3 )
+    index_resize(ix, ix->size*2);
+
+  ix->next[row] = COL_NO_ROW;
+  for(i = key_slot(ix, key);; i = (i+1) & (ix->size-1))
+  { col_key *k = &ix->entries[i];
+
+    if ( k->head == COL_NO_ROW )
+    { k->key  = key;
+      k->head = row;
+      k->tail = row;
+      ix->keys++;
+      return;
+    }
+    if ( k->key == key )
+    { ix->next[k->tail] = row;
+      k->tail = row;
+      return;
+    }
+  }
+}
+
+
+static void
+free_index(col_table *t, column *c)
+{ col_index *ix;
+
+  if ( (ix=c->index) )
+  { c->index = NULL;
+    freeHeap(ix->entries, ix->size*sizeof(*ix->entries));
+    freeHeap(ix->next, t->capacity*sizeof(*ix->next));
+    freeHeap(ix, sizeof(*ix));
+  }
+  c->assessed = FALSE;
+}
+
+
+static void
+create_index(col_table *t, column *c)
+{ col_index *ix = allocHeapOrHalt(sizeof(*ix));
+  size_t r;
+
+  memset(ix, 0, sizeof(*ix));
+  ix->next = allocHeapOrHalt(t->capacity*sizeof(*ix->next));
+  index_resize(ix, 64);
+  for(r=0; r<t->rows; r++)
+    index_add(ix, c->values[r], (uint32_t)r);
+
+  c->index = ix;
+}
+
+
+static int
+cmp_cells(const void *p1, const void *p2)
+{ uint64_t c1 = *(const uint64_t*)p1;
+  uint64_t c2 = *(const uint64_t*)p2;
+
+  return c1 < c2 ? -1 : c1 > c2 ? 1 : 0;
+}
+
+
+/* assess_column() estimates the speedup of an index on a column as the
+   number of distinct values in a sample of at most COL_SAMPLE rows.
+*/
+
+static void
+assess_column(col_table *t, column *c)
+{ uint64_t sample[COL_SAMPLE];
+  size_t n = (t->rows < COL_SAMPLE ? t->rows : COL_SAMPLE);
+  size_t step = t->rows/n;
+  size_t i, distinct = 0;
+
+  for(i=0; i<n; i++)
+    sample[i] = c->values[i*step];
+  qsort(sample, n, sizeof(*sample), cmp_cells);
+  for(i=0; i<n; i++)
+  { if ( i == 0 || sample[i] != sample[i-1] )
+      distinct++;
+  }
+
+  c->speedup       = (float)distinct;
+  c->assessed      = TRUE;
+  c->assessed_rows = t->rows;
+}
+
+
+/* select_column() returns the column to use for finding candidates or
+   -1 to scan the table.  An index is created for the most selective
+   bound column if no index exists or the best existing index is less
+   selective.
+*/
+
+static int
+select_column(col_table *t, const char *bound)
+{ int best_indexed = -1;
+  int best_other = -1;
+  float speedup_indexed = 0.0;
+  float speedup_other = 0.0;
+  unsigned int i;
+
+  for(i=0; i<t->arity; i++)
+  { column *c = &t->columns[i];
+
+    if ( !bound[i] )
+      continue;
+    if ( c->index )
+    { float s = (float)(c->index->keys < COL_SAMPLE ? c->index->keys
+						     : COL_SAMPLE);
+
+      if ( s > speedup_indexed )
+      { speedup_indexed = s;
+	best_indexed = i;
+      }
+    } else if ( t->rows >= COL_INDEX_MIN )
+    { if ( !c->assessed || t->rows > c->assessed_rows*2 )
+	assess_column(t, c);
+      if ( c->speedup > speedup_other )
+      { speedup_other = c->speedup;
+	best_other = i;
+      }
+    }
+  }
+
+  if ( best_other >= 0 &&
+       speedup_other > 1.0 &&
+       speedup_other > speedup_indexed*2 )
+  { create_index(t, &t->columns[best_other]);
+    return best_other;
+  }
+
+  return best_indexed;
+}
+
+
+		 /*******************************
+		 *	       TABLES		*
+		 *******************************/
+
+/* lookup_table() returns the table of def with an extra reference or
+   NULL.  The registry and the reference counts are guarded by L_MISC
+   such that detach_table() cannot free a table between the lookup and
+   acquiring the reference.
+*/
+
+static col_table *
+lookup_table(Definition def)
+{ GET_LD
+  col_table *t = NULL;
+
+  PL_LOCK(L_MISC);
+  if ( GD->columnar.tables &&
+       (t=lookupHTable(GD->columnar.tables, def)) )
+    t->references++;
+  PL_UNLOCK(L_MISC);
+
+  return t;
+}
+
+
+int
+isColumnarDefinition(Definition def)
+{ return ( true(def, P_FOREIGN) &&
+	   def->impl.foreign.function == (Func)columnar_call );
+}
+
+
+static col_table *
+new_table(Definition def, const col_type *types, unsigned int arity)
+{ size_t bytes = sizeof(col_table) + (arity-1)*sizeof(column);
+  col_table *t = allocHeapOrHalt(bytes);
+  unsigned int i;
+
+  memset(t, 0, bytes);
+  t->predicate = def;
+  t->arity     = arity;
+#ifdef O_PLMT
+  simpleMutexInit(&t->mutex);
+#endif
+  for(i=0; i<arity; i++)
+    t->columns[i].type = types[i];
+
+  return t;
+}
+
+
+static void
+release_rows(col_table *t, size_t from, size_t to)
+{ unsigned int i;
+
+  for(i=0; i<t->arity; i++)
+  { column *c = &t->columns[i];
+
+    if ( c->type == COL_ATOM )
+    { size_t r;
+
+      for(r=from; r<to; r++)
+	PL_unregister_atom((atom_t)c->values[r]);
+    }
+  }
+}
+
+
+static void
+free_table(col_table *t)
+{ unsigned int i;
+
+  release_rows(t, 0, t->rows);
+  for(i=0; i<t->arity; i++)
+  { column *c = &t->columns[i];
+
+    free_index(t, c);
+    if ( c->values )
+      freeHeap(c->values, t->capacity*sizeof(*c->values));
+  }
+  if ( t->erased_gen )
+    freeHeap(t->erased_gen, t->capacity*sizeof(*t->erased_gen));
+#ifdef O_PLMT
+  simpleMutexDelete(&t->mutex);
+#endif
+  freeHeap(t, sizeof(col_table) + (t->arity-1)*sizeof(column));
+}
+
+
+static void
+release_table(col_table *t)
+{ int unused;
+
+  PL_LOCK(L_MISC);
+  unused = ( --t->references == 0 && t->detached );
+  PL_UNLOCK(L_MISC);
+  if ( unused )
+    free_table(t);
+}
+
+
+/* detach_table() removes the table of def from the table registry.  It
+   is freed immediately if nobody references it or by release_table()
+   after the last reference is released.
+*/
+
+static void
+detach_table(Definition def)
+{ GET_LD
+  col_table *t = NULL;
+  int unused = FALSE;
+
+  PL_LOCK(L_MISC);
+  if ( GD->columnar.tables &&
+       (t=lookupHTable(GD->columnar.tables, def)) )
+  { deleteHTable(GD->columnar.tables, def);
+    t->detached = TRUE;
+    unused = ( t->references == 0 );
+  }
+  PL_UNLOCK(L_MISC);
+  if ( unused )
+    free_table(t);
+}
+
+
+/* freeColumnarDefinition() is called if a columnar predicate is
+   abolished or destroyed.
+*/
+
+void
+freeColumnarDefinition(Definition def)
+{ if ( isColumnarDefinition(def) )
+    detach_table(def);
+}
+
+
+static void *
+realloc_array(void *old, size_t osize, size_t nsize)
+{ void *new = allocHeapOrHalt(nsize);
+
+  if ( old )
+  { memcpy(new, old, osize);
+    freeHeap(old, osize);
+  }
+
+  return new;
+}
+
+
+static int
+grow_table(col_table *t)
+{ size_t ocap = t->capacity;
+  size_t ncap = (ocap ? ocap*2 : 256);
+  unsigned int i;
+
+  if ( ncap > COL_MAX_ROWS )
+    ncap = COL_MAX_ROWS;
+  if ( ncap <= ocap )
+    return FALSE;
+
+  for(i=0; i<t->arity; i++)
+  { column *c = &t->columns[i];
+
+    c->values = realloc_array(c->values,
+			      ocap*sizeof(*c->values),
+			      ncap*sizeof(*c->values));
+    if ( c->index )
+      c->index->next = realloc_array(c->index->next,
+				     ocap*sizeof(*c->index->next),
+				     ncap*sizeof(*c->index->next));
+  }
+  if ( t->erased_gen )
+  { t->erased_gen = realloc_array(t->erased_gen,
+				  ocap*sizeof(*t->erased_gen),
+				  ncap*sizeof(*t->erased_gen));
+    memset(&t->erased_gen[ocap], 0, (ncap-ocap)*sizeof(*t->erased_gen));
+  }
+  t->capacity = ncap;
+
+  return TRUE;
+}
+
+
+/* compact_table() removes the erased rows.  This renumbers the rows and
+   may thus only be called if there are no active enumerations.  The
+   indexes are dropped and recreated on demand.
+*/
+
+static void
+compact_table(col_table *t)
+{ size_t r, to = 0;
+  unsigned int i;
+
+  assert(t->enumerators == 0);
+
+  for(i=0; i<t->arity; i++)
+    free_index(t, &t->columns[i]);
+
+  for(r=0; r<t->rows; r++)
+  { if ( IS_ERASED(t, r, t->generation) )
+    { for(i=0; i<t->arity; i++)
+      { column *c = &t->columns[i];
+
+	if ( c->type == COL_ATOM )
+	  PL_unregister_atom((atom_t)c->values[r]);
+      }
+    } else
+    { if ( to != r )
+      { for(i=0; i<t->arity; i++)
+	  t->columns[i].values[to] = t->columns[i].values[r];
+      }
+      to++;
+    }
+  }
+
+  memset(t->erased_gen, 0, t->capacity*sizeof(*t->erased_gen));
+  t->rows   = to;
+  t->erased = 0;
+}
+
+
+static void
+consider_compaction(col_table *t)
+{ if ( t->enumerators == 0 && t->erased > 0 && t->erased*2 > t->rows )
+    compact_table(t);
+}
+
+
+		 /*******************************
+		 *	      MATCHING		*
+		 *******************************/
+
+/* get_keys() fills bound[] and keys[] from the arguments of a goal.  It
+   returns FALSE if some argument cannot match any row.
+*/
+
+static int
+get_keys(col_table *t, term_t av, char *bound, uint64_t *keys ARG_LD)
+{ unsigned int i;
+
+  for(i=0; i<t->arity; i++)
+  { term_t a = av+i;
+
+    if ( PL_is_variable(a) )
+    { bound[i] = FALSE;
+    } else
+    { if ( !get_cell(a, t->columns[i].type, &keys[i] PASS_LD) )
+	return FALSE;
+      bound[i] = TRUE;
+    }
+  }
+
+  return TRUE;
+}
+
+
+static int
+row_matches(const col_table *t, size_t r, gen_t gen, const char *bound,
+	    const uint64_t *keys)
+{ unsigned int i;
+
+  if ( IS_ERASED(t, r, gen) )
+    return FALSE;
+  for(i=0; i<t->arity; i++)
+  { if ( bound[i] && t->columns[i].values[r] != keys[i] )
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+static uint32_t
+first_candidate(const col_table *t, int col, const uint64_t *keys)
+{ if ( col >= 0 )
+  { col_key *k = index_lookup(t->columns[col].index, keys[col]);
+
+    return k ? k->head : COL_NO_ROW;
+  }
+
+  return t->rows > 0 ? 0 : COL_NO_ROW;
+}
+
+
+static uint32_t
+next_candidate(const col_table *t, int col, uint32_t r)
+{ if ( col >= 0 )
+    return t->columns[col].index->next[r];
+
+  return r+1 < t->rows ? r+1 : COL_NO_ROW;
+}
+
+
+/* find_match() returns the first matching row at or after r that is
+   visible in generation gen.  Rows are chained in ascending order, so
+   we can stop at limit.
+*/
+
+static uint32_t
+find_match(const col_table *t, int col, uint32_t r, uint32_t limit,
+	   gen_t gen, const char *bound, const uint64_t *keys)
+{ for(; r != COL_NO_ROW && r < limit; r = next_candidate(t, col, r))
+  { if ( row_matches(t, r, gen, bound, keys) )
+      return r;
+  }
+
+  return COL_NO_ROW;
+}
+
+
+static int
+unify_row(const col_table *t, term_t av, uint32_t r ARG_LD)
+{ unsigned int i;
+
+  for(i=0; i<t->arity; i++)
+  { const column *c = &t->columns[i];
+
+    if ( !unify_cell(av+i, c->type, c->values[r] PASS_LD) )
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+		 /*******************************
+		 *	    ENUMERATION		*
+		 *******************************/
+
+/* free_enum() ends an enumeration.  The enumeration owns the reference
+   obtained by lookup_table() in the first call.
+*/
+
+static void
+free_enum(col_enum *e)
+{ col_table *t = e->table;
+
+  LOCK_TABLE(t);
+  t->enumerators--;
+  UNLOCK_TABLE(t);
+  freeHeap(e, sizeof(*e));
+  release_table(t);
+}
+
+
+static foreign_t
+columnar_call(term_t A1, int arity, control_t ctx)
+{ GET_LD
+  col_enum *e = NULL;
+  col_table *t;
+  char bound_buf[COL_LOCAL];
+  uint64_t keys_buf[COL_LOCAL];
+  char *bound = bound_buf;
+  uint64_t *keys = keys_buf;
+  uint32_t row, next, limit;
+  gen_t gen;
+  int col;
+  fid_t fid;
+  int rc = FALSE;
+
+  switch( ForeignControl(ctx) )
+  { case FRG_FIRST_CALL:
+      if ( !(t=lookup_table(ctx->predicate)) )
+	return FALSE;
+      break;
+    case FRG_REDO:
+      e = ForeignContextPtr(ctx);
+      t = e->table;
+      break;
+    case FRG_CUTTED:
+      free_enum(ForeignContextPtr(ctx));
+      return TRUE;
+    default:
+      assert(0);
+      return FALSE;
+  }
+
+  if ( t->arity > COL_LOCAL )
+  { bound = malloc(t->arity*sizeof(*bound));
+    keys  = malloc(t->arity*sizeof(*keys));
+    if ( !bound || !keys )
+    { rc = PL_no_memory();
+      goto out_nolock;
+    }
+  }
+  if ( !get_keys(t, A1, bound, keys PASS_LD) ||
+       !(fid = PL_open_foreign_frame()) )
+    goto out_nolock;
+
+  LOCK_TABLE(t);
+  if ( !e )
+  { col   = select_column(t, bound);
+    row   = first_candidate(t, col, keys);
+    limit = (uint32_t)t->rows;
+    gen   = t->generation;
+  } else
+  { col   = e->column;
+    row   = e->row;
+    limit = e->limit;
+    gen   = e->generation;
+  }
+
+  for(row = find_match(t, col, row, limit, gen, bound, keys);
+      row != COL_NO_ROW;
+      row = next)
+  { next = find_match(t, col, next_candidate(t, col, row), limit, gen,
+		      bound, keys);
+
+    if ( unify_row(t, A1, row PASS_LD) )
+    { if ( next == COL_NO_ROW )
+      { rc = TRUE;
+	break;
+      }
+      if ( !e )
+      { e = allocHeapOrHalt(sizeof(*e));
+	e->table  = t;
+	e->column = col;
+	e->limit  = limit;
+	e->generation = gen;
+	t->enumerators++;
+      }
+      e->row = next;
+      UNLOCK_TABLE(t);
+      PL_close_foreign_frame(fid);
+      if ( bound != bound_buf )
+      { free(bound);
+	free(keys);
+      }
+      ForeignRedoPtr(e);
+    }
+    if ( PL_exception(0) )
+      break;
+    PL_rewind_foreign_frame(fid);
+  }
+  UNLOCK_TABLE(t);
+  PL_close_foreign_frame(fid);
+
+out_nolock:
+  if ( e )
+    free_enum(e);
+  else
+    release_table(t);
+  if ( bound != bound_buf )
+  { free(bound);
+    free(keys);
+  }
+
+  return rc;
+}
+
+
+		 /*******************************
+		 *	     MODIFICATION	*
+		 *******************************/
+
+static int
+no_transaction(Procedure proc)
+{ GET_LD
+
+  if ( LD->transaction.generation )
+    return PL_error(NULL, 0, "columnar predicates are not transactional",
+		    ERR_PERMISSION_PROC, ATOM_modify,
+		    ATOM_columnar_procedure, proc);
+
+  return TRUE;
+}
+
+
+int
+columnarAssert(Procedure proc, term_t head, term_t body)
+{ GET_LD
+  Definition def = proc->definition;
+  col_table *t;
+  uint64_t cells_buf[COL_LOCAL];
+  uint64_t *cells = cells_buf;
+  term_t av = PL_new_term_ref();
+  unsigned int i;
+  atom_t b;
+  int rc = TRUE;
+
+  if ( !PL_get_atom(body, &b) || b != ATOM_true )
+    return PL_error(NULL, 0, "columnar predicates only store facts",
+		    ERR_PERMISSION_PROC, ATOM_modify,
+		    ATOM_columnar_procedure, proc);
+  if ( !no_transaction(proc) )
+    return FALSE;
+  if ( !(t=lookup_table(def)) )
+    return FALSE;
+
+  if ( t->arity > COL_LOCAL &&
+       !(cells = malloc(t->arity*sizeof(*cells))) )
+  { release_table(t);
+    return PL_no_memory();
+  }
+
+  for(i=0; i<t->arity; i++)
+  { _PL_get_arg(i+1, head, av);
+    if ( !get_cell_ex(av, t->columns[i].type, &cells[i] PASS_LD) )
+    { rc = FALSE;
+      goto out;
+    }
+  }
+
+  LOCK_TABLE(t);
+  consider_compaction(t);
+  if ( t->rows == t->capacity && !grow_table(t) )
+  { UNLOCK_TABLE(t);
+    rc = PL_error(NULL, 0, NULL, ERR_RESOURCE, ATOM_memory);
+    goto out;
+  }
+  for(i=0; i<t->arity; i++)
+  { column *c = &t->columns[i];
+
+    if ( c->type == COL_ATOM )
+      PL_register_atom((atom_t)cells[i]);
+    c->values[t->rows] = cells[i];
+    if ( c->index )
+      index_add(c->index, cells[i], (uint32_t)t->rows);
+  }
+  t->rows++;
+  UNLOCK_TABLE(t);
+
+out:
+  if ( cells != cells_buf )
+    free(cells);
+  release_table(t);
+
+  return rc;
+}
+
+
+int
+columnarRetractAll(Procedure proc, term_t head)
+{ GET_LD
+  Definition def = proc->definition;
+  col_table *t;
+  char bound_buf[COL_LOCAL];
+  uint64_t keys_buf[COL_LOCAL];
+  char *bound = bound_buf;
+  uint64_t *keys = keys_buf;
+  term_t av = PL_new_term_refs(def->functor->arity);
+  unsigned int i;
+  int rc = TRUE;
+
+  if ( !no_transaction(proc) )
+    return FALSE;
+  if ( !(t=lookup_table(def)) )
+    return TRUE;
+  if ( t->arity > COL_LOCAL )
+  { bound = malloc(t->arity*sizeof(*bound));
+    keys  = malloc(t->arity*sizeof(*keys));
+    if ( !bound || !keys )
+    { rc = PL_no_memory();
+      goto out;
+    }
+  }
+
+  for(i=0; i<t->arity; i++)
+    _PL_get_arg(i+1, head, av+i);
+
+  if ( get_keys(t, av, bound, keys PASS_LD) )
+  { uint32_t r;
+    gen_t gen;
+    int col;
+
+    LOCK_TABLE(t);
+    gen = t->generation;
+    col = select_column(t, bound);
+    for(r = find_match(t, col, first_candidate(t, col, keys),
+		       (uint32_t)t->rows, gen, bound, keys);
+	r != COL_NO_ROW;
+	r = find_match(t, col, next_candidate(t, col, r),
+		       (uint32_t)t->rows, gen, bound, keys))
+    { if ( !t->erased_gen )
+      { t->erased_gen = allocHeapOrHalt(t->capacity*sizeof(*t->erased_gen));
+	memset(t->erased_gen, 0, t->capacity*sizeof(*t->erased_gen));
+      }
+      t->erased_gen[r] = gen+1;
+      t->erased++;
+    }
+    t->generation = gen+1;
+    consider_compaction(t);
+    UNLOCK_TABLE(t);
+  }
+
+out:
+  if ( bound != bound_buf )
+  { free(bound);
+    free(keys);
+  }
+  release_table(t);
+
+  return rc;
+}
+
+
+		 /*******************************
+		 *	     PROPERTIES		*
+		 *******************************/
+
+int
+unify_columnar_spec(Definition def, term_t spec)
+{ GET_LD
+  col_table *t;
+  term_t a;
+  unsigned int i;
+  int rc = FALSE;
+
+  if ( !isColumnarDefinition(def) || !(t=lookup_table(def)) )
+    return FALSE;
+
+  if ( (a=PL_new_term_ref()) &&
+       PL_unify_functor(spec, def->functor->functor) )
+  { for(i=0; i<t->arity; i++)
+    { _PL_get_arg(i+1, spec, a);
+      if ( !PL_unify_atom(a, col_type_name(t->columns[i].type)) )
+	break;
+    }
+    rc = ( i == t->arity );
+  }
+  release_table(t);
+
+  return rc;
+}
+
+
+size_t
+columnar_rows(Definition def)
+{ col_table *t;
+  size_t rows = 0;
+
+  if ( (t=lookup_table(def)) )
+  { LOCK_TABLE(t);
+    rows = t->rows - t->erased;
+    UNLOCK_TABLE(t);
+    release_table(t);
+  }
+
+  return rows;
+}
+
+
+size_t
+sizeof_columnar(Definition def)
+{ col_table *t;
+  size_t size = 0;
+
+  if ( (t=lookup_table(def)) )
+  { unsigned int i;
+
+    LOCK_TABLE(t);
+    size += sizeof(col_table) + (t->arity-1)*sizeof(column);
+    if ( t->erased_gen )
+      size += t->capacity*sizeof(*t->erased_gen);
+    for(i=0; i<t->arity; i++)
+    { column *c = &t->columns[i];
+
+      size += t->capacity*sizeof(*c->values);
+      if ( c->index )
+      { size += sizeof(*c->index);
+	size += c->index->size*sizeof(*c->index->entries);
+	size += t->capacity*sizeof(*c->index->next);
+      }
+    }
+    UNLOCK_TABLE(t);
+    release_table(t);
+  }
+
+  return size;
+}
+
+
+		 /*******************************
+		 *	    DECLARATION		*
+		 *******************************/
+
+static int
+get_col_types(term_t spec, col_type *types, unsigned int arity ARG_LD)
+{ term_t a = PL_new_term_ref();
+  unsigned int i;
+
+  for(i=0; i<arity; i++)
+  { atom_t name;
+
+    _PL_get_arg(i+1, spec, a);
+    if ( !PL_get_atom_ex(a, &name) )
+      return FALSE;
+    if ( name == ATOM_atom )
+      types[i] = COL_ATOM;
+    else if ( name == ATOM_integer )
+      types[i] = COL_INTEGER;
+    else if ( name == ATOM_float )
+      types[i] = COL_FLOAT;
+    else
+      return PL_domain_error("column_type", a);
+  }
+
+  return TRUE;
+}
+
+
+static int
+same_types(const col_table *t, const col_type *types, unsigned int arity)
+{ unsigned int i;
+
+  if ( t->arity != arity )
+    return FALSE;
+  for(i=0; i<arity; i++)
+  { if ( t->columns[i].type != types[i] )
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+/** columnar(:Spec) is det.
+ *
+ * Declare the predicate described by Spec, e.g., fact(atom,integer,atom),
+ * as a columnar predicate.  Re-declaring a columnar predicate with the
+ * same column types is a no-op.
+ */
+
+static
+PRED_IMPL("columnar", 1, columnar, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Module m = NULL;
+  term_t spec = PL_new_term_ref();
+  functor_t fd;
+  unsigned int arity;
+  Procedure proc;
+  Definition def;
+  col_type types_buf[COL_LOCAL];
+  col_type *types = types_buf;
+  col_table *t;
+  int rc = FALSE;
+
+  if ( !PL_strip_module_ex(A1, &m, spec) ||
+       !PL_get_functor(spec, &fd) )
+    return PL_type_error("callable", A1);
+  arity = (unsigned int)arityFunctor(fd);
+  if ( arity == 0 || arity > COL_MAX_ARITY )
+    return PL_domain_error("columnar_arity", A1);
+  if ( arity > COL_LOCAL &&
+       !(types = malloc(arity*sizeof(*types))) )
+    return PL_no_memory();
+  if ( !get_col_types(spec, types, arity PASS_LD) )
+    goto out;
+  if ( !(proc = lookupProcedureToDefine(fd, m)) )
+    goto out;
+  def = proc->definition;
+
+  if ( isColumnarDefinition(def) )
+  { if ( (t=lookup_table(def)) )
+    { rc = same_types(t, types, arity);
+      release_table(t);
+    }
+    if ( !rc )
+      rc = PL_error(NULL, 0, "column types differ",
+		    ERR_PERMISSION_PROC, ATOM_modify,
+		    ATOM_columnar_procedure, proc);
+    goto out;
+  }
+  if ( isDefinedProcedure(proc) &&
+       (true(def, P_FOREIGN) || def->impl.clauses.number_of_clauses > 0) )
+  { rc = PL_error(NULL, 0, "predicate is already defined",
+		  ERR_PERMISSION_PROC, ATOM_modify,
+		  ATOM_static_procedure, proc);
+    goto out;
+  }
+
+  LOCKDEF(def);
+  if ( !GD->columnar.tables )
+    GD->columnar.tables = newHTable(16);
+  detach_table(def);			/* stale table, if any */
+  t = new_table(def, types, arity);
+  addNewHTable(GD->columnar.tables, def, t);
+  if ( def->impl.any.defined )
+    PL_linger(def->impl.any.defined);
+  def->impl.foreign.function = (Func)columnar_call;
+  clear(def, P_DYNAMIC|P_THREAD_LOCAL|P_TRANSPARENT);
+  set(def, P_FOREIGN|P_NONDET|P_VARARG|TRACE_ME);
+  createForeignSupervisor(def, (Func)columnar_call);
+  UNLOCKDEF(def);
+  rc = TRUE;
+
+out:
+  if ( types != types_buf )
+    free(types);
+
+  return rc;
+}
+
+
+		 /*******************************
+		 *      PUBLISH PREDICATES	*
+		 *******************************/
+
+BeginPredDefs(columnar)
+  PRED_DEF("columnar", 1, columnar, PL_FA_TRANSPARENT)
+EndPredDefs
@@ -59,6 +59,8 @@
 #include "pl-gc.h"
 #include "pl-index.h"
 #include "pl-setup.h"
+#include "pl-columnar.h"
+#include "pl-shard.h"
 #include <limits.h>
 #ifdef HAVE_DLADDR
 #include <dlfcn.h>
@@ -395,8 +397,12 @@ typedef struct
   c_warning    *warnings;
   tmp_buffer	branch_varbuf;		/* Store for branch_vars */
   tmp_buffer	codes;			/* scratch code table */
+  uint64_t	float_vars;		/* Vars tested by float/1 (hint) */
+  int		arith_float;		/* Last arithmetic argument is float */
 } compileInfo, *CompileInfo;
 
+#define FLOAT_VAR_HINTS 64		/* Max var index in float_vars */
+
 
 static int link_local_var(Word v, int iv, CompileInfo ci ARG_LD);
 
@@ -1569,6 +1575,7 @@ in: X, Y, Z --> X, YZ --> XYZ.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static vmi_merge *merge_def[I_HIGHEST];
+static vmi_merge *fuse_def[I_HIGHEST];
 
 static size_t
 mergeCount(vmi_merge *m)
@@ -1581,17 +1588,17 @@ mergeCount(vmi_merge *m)
 }
 
 static void
-addMerge(vmi c, vmi_merge *m)
-{ if ( merge_def[c] )
-  { size_t n = mergeCount(merge_def[c]);
+addMerge(vmi_merge **table, vmi c, vmi_merge *m)
+{ if ( table[c] )
+  { size_t n = mergeCount(table[c]);
 
-    merge_def[c] = realloc(merge_def[c], sizeof(*m)*(n+2));
-    merge_def[c][n] = *m;
-    merge_def[c][n+1].code = I_HIGHEST;
+    table[c] = realloc(table[c], sizeof(*m)*(n+2));
+    table[c][n] = *m;
+    table[c][n+1].code = I_HIGHEST;
   } else
-  { merge_def[c] = malloc(sizeof(*m)*2);
-    merge_def[c][0] = *m;
-    merge_def[c][1].code = I_HIGHEST;
+  { table[c] = malloc(sizeof(*m)*2);
+    table[c][0] = *m;
+    table[c][1].code = I_HIGHEST;
   }
 }
 
@@ -1611,7 +1618,7 @@ mergeSeq(vmi c1, vmi c2, vmi op, int ac, ...)
     m.merge_av[i] = va_arg(args, code);
   va_end(args);
 
-  addMerge(c1, &m);
+  addMerge(merge_def, c1, &m);
 }
 
 static void
@@ -1622,8 +1629,33 @@ mergeStep(vmi c1, vmi c2)
   m.code = c2;
   m.how  = VMI_STEP_ARGUMENT;
 
-  addMerge(c1, &m);
+  addMerge(merge_def, c1, &m);
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+mergeFuse() declares that if c1 is followed by c2, c1 may be replaced by
+the superinstruction op.  c2 may itself be a superinstruction, so longer
+sequences are defined incrementally.  op has the same arguments as c1 and
+is decoded as c1.  See fuseInstructions() and SUPERINSTRUCTIONS in
+pl-vmi.c.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if VMCODE_IS_ADDRESS
+static void
+mergeFuse(vmi c1, vmi c2, vmi op)
+{ vmi_merge m;
+
+  assert(codeTable[op].arguments == codeTable[c1].arguments);
+
+  memset(&m, 0, sizeof(m));
+  m.code     = c2;
+  m.how      = VMI_FUSE;
+  m.merge_op = op;
+
+  addMerge(fuse_def, c1, &m);
+  dewam_table[wam_table[op]-dewam_table_offset] = (unsigned char)c1;
 }
+#endif
 
 
 static void
@@ -1641,6 +1673,78 @@ initVMIMerge(void)
   mergeSeq(H_VOID_N, I_SSU_CHOICE, I_SSU_CHOICE, 0);
   mergeSeq(H_VOID,   H_POP,	   H_POP,	 0);
   mergeSeq(H_VOID_N, H_POP,	   H_POP,	 0);
+
+#if VMCODE_IS_ADDRESS
+  mergeFuse(H_ATOM,     I_EXITFACT,   H_ATOM_EXITFACT);
+  mergeFuse(H_FIRSTVAR, H_POP,	      H_FIRSTVAR_POP);
+  mergeFuse(H_POP,      I_ENTER,      H_POP_ENTER);
+  mergeFuse(I_ENTER,    L_NOLCO,      I_ENTER_NOLCO);
+  mergeFuse(B_VAR0,     I_CALL,	      B_VAR0_CALL);
+  mergeFuse(B_VAR1,     I_CALL,	      B_VAR1_CALL);
+  mergeFuse(B_VAR,      I_CALL,	      B_VAR_CALL);
+  mergeFuse(B_NEQ_VV,   I_EXIT,	      B_NEQ_VV_EXIT);
+  mergeFuse(L_VAR,      I_TCALL,      L_VAR_TCALL);
+					/* triples */
+  mergeFuse(I_ENTER,    B_VAR0_CALL,  I_ENTER_VAR0_CALL);
+  mergeFuse(B_VAR1,     B_VAR_CALL,   B_VAR1_VAR_CALL);
+  mergeFuse(B_VAR2,     B_VAR_CALL,   B_VAR2_VAR_CALL);
+  mergeFuse(L_VAR,      L_VAR_TCALL,  L_VAR_VAR_TCALL);
+#endif
+}
+
+
+static vmi
+fusedInstruction(vmi c1, vmi c2)
+{ const vmi_merge *m;
+
+  if ( (m=fuse_def[c1]) )
+  { for(; m->code != I_HIGHEST; m++)
+    { if ( m->code == c2 )
+	return m->merge_op;
+    }
+  }
+
+  return I_HIGHEST;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+fuseInstructions() replaces  the  opcode  of  instructions  that  are
+followed by an instruction they can be fused with (see mergeFuse()) by
+the superinstruction.  This is done as a final pass  over  the  code,
+such that the compiler and code walkers never see superinstructions.
+The layout of the code does not change, so jumps into a sequence remain
+valid.
+
+We do not replace the opcode of an instruction that is the target of a
+superinstruction, as that would make NEXT_FUSED() of  the  preceding
+instruction fall back to a normal dispatch.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+void
+fuseInstructions(Code PC, size_t size)
+{ Code end = PC+size;
+  Code p1 = NULL, p2 = NULL;		/* previous two instructions */
+  int t1 = FALSE, t2 = FALSE;		/* p1/p2 is target of a fused one */
+
+  for(; PC < end; PC = stepPC(PC))
+  { vmi c = decode(*PC);
+    vmi s, t;
+
+    if ( p1 && !t1 && (s=fusedInstruction(decode(*p1), c)) != I_HIGHEST )
+    { if ( p2 && !t2 &&
+	   (t=fusedInstruction(decode(*p2), s)) != I_HIGHEST )
+      { *p2 = encode(t);
+	t1 = TRUE;
+      }
+      *p1 = encode(s);
+      p2 = p1; t2 = t1;
+      p1 = PC; t1 = TRUE;
+    } else
+    { p2 = p1; t2 = t1;
+      p1 = PC; t1 = FALSE;
+    }
+  }
 }
 
 
@@ -1674,6 +1778,8 @@ mergeInstructions(CompileInfo ci, const vmi_merge *m, vmi c)
 	  OpCode(ci, ci->mstate.merge_pos+1)++;
 	  return TRUE;
 	}
+	case VMI_FUSE:			/* only in fuse_def */
+	  assert(0);
       }
       break;
     }
@@ -1818,6 +1924,7 @@ compileClause(Clause *cp, Word head, Word body,
 #endif
   ci.warning_list    = warnings;
   ci.warnings        = NULL;
+  ci.float_vars      = 0;
 
   if ( (rc=analyse_variables(head, body, &ci PASS_LD)) < 0 )
   { switch ( rc )
@@ -1948,6 +2055,7 @@ that have an I_CONTEXT because we need to reset the context.
 Finish up the clause.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
   clause.code_size = entriesBuffer(&ci.codes, code);
+  fuseInstructions(baseBuffer(&ci.codes, code), clause.code_size);
 
   if ( head )
   { size_t size  = sizeofClause(clause.code_size);
@@ -2356,6 +2464,10 @@ try_fast_condition(CompileInfo ci, size_t tc_or)
       case A_FUNC:
       case A_ADD:
       case A_MUL:
+      case A_ADD_F:
+      case A_SUB_F:
+      case A_MUL_F:
+      case A_DIV_F:
       case A_LT:
       case A_LE:
       case A_GT:
@@ -3300,6 +3412,7 @@ compileArithArgument(Word arg, compileInfo *ci ARG_LD)
   int rc;
 
   deRef(arg);
+  ci->arith_float = FALSE;
 
   if ( isRational(*arg) )
   { if ( storage(*arg) == STG_INLINE )
@@ -3344,11 +3457,14 @@ compileArithArgument(Word arg, compileInfo *ci ARG_LD)
   { Word p = valIndirectP(*arg);
 
     Output_n(ci, A_DOUBLE, p, WORDS_PER_DOUBLE);
+    ci->arith_float = TRUE;
     succeed;
   }
 
   if ( (rc=arithVarOffset(arg, ci, &index PASS_LD)) == TRUE )
-  { if ( index < 3 )
+  { if ( index < FLOAT_VAR_HINTS )
+      ci->arith_float = !!(ci->float_vars & ((uint64_t)1<<index));
+    if ( index < 3 )
       Output_0(ci, A_VAR0 + index);
     else
       Output_1(ci, A_VAR, VAROFFSET(index));
@@ -3362,6 +3478,7 @@ compileArithArgument(Word arg, compileInfo *ci ARG_LD)
   { functor_t fdef;
     size_t n, ar;
     Word a;
+    int isfloat = FALSE;
 
     if ( isTextAtom(*arg) )
     { fdef = lookupFunctorDef(*arg, 0);
@@ -3422,9 +3539,25 @@ compileArithArgument(Word arg, compileInfo *ci ARG_LD)
     { for(a+=ar-1, n=ar; n-- > 0; a--)
       { if ( !compileArithArgument(a, ci PASS_LD) )
 	  return FALSE;
+	isfloat |= ci->arith_float;
       }
     }
 
+    if ( isfloat &&
+	 ( fdef == FUNCTOR_plus2  || fdef == FUNCTOR_minus2 ||
+	   fdef == FUNCTOR_star2  || fdef == FUNCTOR_divide2 ) )
+    { code op = ( fdef == FUNCTOR_plus2  ? A_ADD_F :
+		  fdef == FUNCTOR_minus2 ? A_SUB_F :
+		  fdef == FUNCTOR_star2  ? A_MUL_F : A_DIV_F );
+
+      Output_1(ci, op, index);
+      ci->arith_float = TRUE;
+      succeed;
+    }
+    ci->arith_float = ( (isfloat && fdef == FUNCTOR_minus1) ||
+			fdef == FUNCTOR_float1 ||
+			fdef == FUNCTOR_pi0 || fdef == FUNCTOR_e0 );
+
     if ( fdef == FUNCTOR_plus2 )
     { Output_0(ci, A_ADD);
       succeed;
@@ -3958,8 +4091,21 @@ compileBodyTypeTest(functor_t functor, Word arg, compileInfo *ci ARG_LD)
 
   for(tt = type_tests; tt->functor; tt++)
   { if ( functor == tt->functor )
-      return compileTypeTest(arg, tt->instruction, tt->name, tt->test,
-			     ci PASS_LD);
+    { int rc = compileTypeTest(arg, tt->instruction, tt->name, tt->test,
+			       ci PASS_LD);
+
+      if ( rc == TRUE && tt->instruction == I_FLOAT )
+      { Word a1 = argTermP(*arg, 0);
+	int i1;
+
+	deRef(a1);
+	if ( (i1 = isIndexedVarTerm(*a1 PASS_LD)) >= 0 &&
+	     i1 < FLOAT_VAR_HINTS )
+	  ci->float_vars |= (uint64_t)1<<i1;
+      }
+
+      return rc;
+    }
   }
 
   return FALSE;
@@ -4125,6 +4271,22 @@ assert_term(term_t term, Module module, ClauseRef where,
     if ( !proc )
       return NULL;
   }
+  if ( isColumnarDefinition(proc->definition) )
+  { if ( (flags&ASSERT_COLUMNAR) && where == CL_END && !loc )
+      return columnarAssert(proc, head, body) ? COLUMNAR_ROW : NULL;
+    PL_error(NULL, 0, "columnar predicates only support assertz/1",
+	     ERR_PERMISSION_PROC, ATOM_modify, ATOM_columnar_procedure, proc);
+    return NULL;
+  }
+  if ( isShardedDefinition(proc->definition) )
+  { if ( loc )
+    { PL_error(NULL, 0, "sharded predicates cannot be loaded from source",
+	       ERR_PERMISSION_PROC, ATOM_modify, ATOM_sharded_procedure, proc);
+      return NULL;
+    }
+    if ( !(proc = shardProcedure(proc->definition, head)) )
+      return NULL;
+  }
   if ( flags && !isDefinedProcedure(proc) )
   { if ( (flags&PL_CREATE_INCREMENTAL) )
       tbl_set_incremental_predicate(proc->definition, TRUE);
@@ -4277,7 +4439,8 @@ static
 PRED_IMPL("assertz", 1, assertz1, PL_FA_TRANSPARENT)
 { PRED_LD
 
-  return assert_term(A1, NULL, CL_END, NULL_ATOM, NULL, 0 PASS_LD) != NULL;
+  return assert_term(A1, NULL, CL_END, NULL_ATOM, NULL,
+		     ASSERT_COLUMNAR PASS_LD) != NULL;
 }
 
 
@@ -4289,6 +4452,145 @@ PRED_IMPL("asserta", 1, asserta1, PL_FA_TRANSPARENT)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+assert_all() implements assertz_all/1 and  PL_assert_all(). It compiles a
+list of clauses and adds each  run  of   clauses  for  the same predicate
+using  assertDefinitionBulk(),  i.e.,  under  a    single  lock  and  a
+single generation.  If an  error  occurs,   runs  that  were  already
+flushed remain asserted; the clauses of the current run are discarded.
+Columnar predicates are handled row-by-row by assert_term().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct assert_batch
+{ Procedure	proc;			/* Procedure we are collecting for */
+  tmp_buffer	clauses;		/* Compiled clauses */
+} assert_batch;
+
+static int
+flush_assert_batch(assert_batch *batch ARG_LD)
+{ size_t count = entriesBuffer(&batch->clauses, Clause);
+  int rc = TRUE;
+
+  if ( count > 0 )
+  { Definition def = getProcDefinition(batch->proc);
+    Clause *clauses = baseBuffer(&batch->clauses, Clause);
+
+    rc = ( assertDefinitionBulk(def, clauses, count PASS_LD) == count );
+    seekBuffer(&batch->clauses, 0, Clause);
+  }
+
+  return rc;
+}
+
+static void
+discard_assert_batch(assert_batch *batch)
+{ size_t i, count = entriesBuffer(&batch->clauses, Clause);
+  Clause *clauses = baseBuffer(&batch->clauses, Clause);
+
+  for(i=0; i<count; i++)
+    freeClause(clauses[i]);
+  discardBuffer(&batch->clauses);
+}
+
+static int
+assert_all(term_t list, Module module, int flags ARG_LD)
+{ term_t tmp   = PL_new_term_refs(5);
+  term_t head  = tmp+1;
+  term_t body  = tmp+2;
+  term_t tail  = tmp+3;
+  term_t cl    = tmp+4;
+  assert_batch batch;
+
+  if ( !PL_strip_module_ex(list, &module, tail) )
+    return FALSE;
+
+  batch.proc = NULL;
+  initBuffer(&batch.clauses);
+
+  while( PL_get_list(tail, cl, tail) )
+  { Module m = module;
+    Module mhead;
+    Procedure proc;
+    functor_t fdef;
+    Clause clause;
+    int hflags = 0;
+    Word h, b;
+
+    if ( !PL_strip_module_ex(cl, &m, tmp) )
+      goto error;
+    mhead = m;
+    if ( !get_head_and_body_clause(tmp, head, body, &mhead, &hflags PASS_LD) ||
+	 !get_head_functor(head, &fdef, 0 PASS_LD) )
+      goto error;
+    if ( !(proc = isCurrentProcedure(fdef, mhead)) )
+    { if ( checkModifySystemProc(fdef) )
+	proc = lookupProcedure(fdef, mhead);
+      if ( !proc )
+	goto error;
+    }
+    if ( isShardedDefinition(proc->definition) &&
+	 !(proc = shardProcedure(proc->definition, head)) )
+      goto error;
+
+    if ( proc != batch.proc )
+    { Definition def = proc->definition;
+
+      if ( !flush_assert_batch(&batch PASS_LD) )
+	goto error;
+      batch.proc = proc;
+
+      if ( isColumnarDefinition(def) )
+      { if ( !columnarAssert(proc, head, body) )
+	  goto error;
+	batch.proc = NULL;
+	continue;
+      }
+      if ( flags && !isDefinedProcedure(proc) )
+      { if ( (flags&PL_CREATE_INCREMENTAL) )
+	  tbl_set_incremental_predicate(def, TRUE);
+	if ( (flags&PL_CREATE_THREAD_LOCAL) )
+	  setAttrDefinition(def, P_THREAD_LOCAL, TRUE);
+      }
+      if ( false(def, P_DYNAMIC) )
+      { if ( isDefinedProcedure(proc) )
+	{ PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
+	  goto error;
+	}
+	if ( !setDynamicDefinition(def, TRUE) )
+	  goto error;
+      }
+    }
+
+    h = valTermRef(head);
+    b = valTermRef(body);
+    deRef(h);
+    deRef(b);
+    if ( compileClause(&clause, h, b, proc, m, 0, hflags PASS_LD) != TRUE )
+      goto error;
+    addBuffer(&batch.clauses, clause, Clause);
+  }
+
+  if ( !PL_get_nil_ex(tail) ||
+       !flush_assert_batch(&batch PASS_LD) )
+    goto error;
+
+  discardBuffer(&batch.clauses);
+  return TRUE;
+
+error:
+  discard_assert_batch(&batch);
+  return FALSE;
+}
+
+
+static
+PRED_IMPL("assertz_all", 1, assertz_all, PL_FA_TRANSPARENT)
+{ PRED_LD
+
+  return assert_all(A1, NULL, 0 PASS_LD);
+}
+
+
 static int
 mustBeVar(term_t t ARG_LD)
 { if ( !PL_is_variable(t) )
@@ -5803,6 +6105,10 @@ decompileBodyNoShift(decompileInfo *di, code end, Code until ARG_LD)
       case A_FUNC0:
       case A_FUNC1:
       case A_FUNC2:
+      case A_ADD_F:
+      case A_SUB_F:
+      case A_MUL_F:
+      case A_DIV_F:
 			    BUILD_TERM_REV(functorArithFunction((int)*PC++));
 			    continue;
       case A_FUNC:
@@ -6452,6 +6758,12 @@ protected_predicate(Definition def ARG_LD)
 #define IS_CLAUSE 0x1
 #define IS_RULE   0x2
 
+typedef struct clause_state
+{ struct clause_choice chp;		/* Clause enumeration state */
+  Definition def;			/* Predicate or shard we walk */
+  int	     all_shards;		/* Walking all shards */
+} clause_state;
+
 
 static foreign_t
 clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
@@ -6459,8 +6771,10 @@ clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
 { PRED_LD
   Procedure proc;
   Definition def;
-  struct clause_choice chp_buf;
+  clause_state state_buf;
+  clause_state *state;
   ClauseChoice chp;
+  int all_shards = FALSE;
   ClauseRef cref;
   Word argv;
   Module module = NULL;
@@ -6521,19 +6835,19 @@ clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
       if ( !(dref=pushPredicateAccessObj(def PASS_LD)) )
 	return FALSE;
 
-      chp = NULL;
+      state = NULL;
       setGenerationFrameVal(environment_frame, dref->generation);
       break;
     }
     case FRG_REDO:
-      chp = CTX_PTR;
-      def = chp->cref->value.clause->predicate;
+      state = CTX_PTR;
+      def = state->def;
+      all_shards = state->all_shards;
       break;
     case FRG_CUTTED:
-      chp = CTX_PTR;
-      def = chp->cref->value.clause->predicate;
-      popPredicateAccess(def);
-      freeForeignState(chp, sizeof(*chp));
+      state = CTX_PTR;
+      popPredicateAccess(state->def);
+      freeForeignState(state, sizeof(*state));
       succeed;
     default:
       assert(0);
@@ -6551,12 +6865,29 @@ clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
   } else
     argv = NULL;
 
-  if ( !chp )
-  { chp = &chp_buf;
+  if ( !state )
+  { state = &state_buf;
+    chp = &state->chp;
+    if ( isShardedDefinition(def) )
+    { Definition shard = shardDefinition(def, argv PASS_LD);
+      definition_ref *dref;
+
+      popPredicateAccess(def);
+      if ( (all_shards = (shard == def->shards->all)) )
+	def = firstShard(def);
+      else
+	def = shard;
+      if ( !(dref=pushPredicateAccessObj(def PASS_LD)) )
+	return FALSE;
+      setGenerationFrameVal(environment_frame, dref->generation);
+    }
     cref = firstClause(argv, environment_frame, def, chp PASS_LD);
   } else
-  { cref = nextClause(chp, argv, environment_frame, def);
+  { chp = &state->chp;
+    cref = chp->cref ? nextClause(chp, argv, environment_frame, def) : NULL;
   }
+  if ( !cref && all_shards )
+    cref = nextShardClause(&def, argv, environment_frame, chp PASS_LD);
 
   if ( !(fid = PL_open_foreign_frame()) )
     goto out;
@@ -6581,17 +6912,19 @@ clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
 	rc2 = PL_unify_clref(ref, clause);
 
       if ( rc2 )
-      { if ( !chp->cref )
+      { if ( !chp->cref && !(all_shards && !isLastShard(def)) )
 	{ rc = TRUE;
 	  goto out;
 	}
-	if ( chp == &chp_buf )
-	{ chp = allocForeignState(sizeof(*chp));
-	  *chp = chp_buf;
+	if ( state == &state_buf )
+	{ state = allocForeignState(sizeof(*state));
+	  *state = state_buf;
 	}
+	state->def = def;
+	state->all_shards = all_shards;
 
 	PL_close_foreign_frame(fid);
-	ForeignRedoPtr(chp);
+	ForeignRedoPtr(state);
       } else
       { PL_put_variable(h);		/* otherwise they point into */
 	PL_put_variable(b);		/* term, which is removed */
@@ -6606,14 +6939,16 @@ clause(term_t head, term_t body, term_t ref, term_t bindings, int flags,
       deRef(argv);
       argv = argTermP(*argv, 0);
     }
-    cref = nextClause(chp, argv, environment_frame, def);
+    cref = chp->cref ? nextClause(chp, argv, environment_frame, def) : NULL;
+    if ( !cref && all_shards )
+      cref = nextShardClause(&def, argv, environment_frame, chp PASS_LD);
   }
 
 out:
   if ( fid )
     PL_close_foreign_frame(fid);
-  if ( chp != &chp_buf )
-    freeForeignState(chp, sizeof(*chp));
+  if ( state != &state_buf )
+    freeForeignState(state, sizeof(*state));
   popPredicateAccess(def);
   return rc;
 }
@@ -8318,6 +8653,16 @@ PL_assert(term_t term, module_t module, int flags)
 }
 
 
+int
+PL_assert_all(term_t clauses, module_t module, int flags)
+{ GET_LD
+
+  flags &= (PL_CREATE_THREAD_LOCAL|PL_CREATE_INCREMENTAL);
+
+  return assert_all(clauses, module, flags PASS_LD);
+}
+
+
 		 /*******************************
 		 *      PUBLISH PREDICATES	*
 		 *******************************/
@@ -8332,6 +8677,7 @@ BeginPredDefs(comp)
   PRED_DEF("$end_aux", 2, end_aux, 0)
   PRED_DEF("assert",  1, assertz1, META)
   PRED_DEF("assertz", 1, assertz1, META|PL_FA_ISO)
+  PRED_DEF("assertz_all", 1, assertz_all, META)
   PRED_DEF("asserta", 1, asserta1, META|PL_FA_ISO)
   PRED_DEF("assert",  2, assertz2, META)
   PRED_DEF("assertz", 2, assertz2, META)
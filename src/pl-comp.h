@@ -68,6 +68,7 @@ COMMON(code)		replacedBreakUnlocked(Code PC);
 COMMON(int)		clearBreakPointsClause(Clause clause) WUNUSED;
 COMMON(int)		unify_functor(term_t t, functor_t fd, int how);
 COMMON(void)		vm_list(Code code, Code end);
+COMMON(void)		fuseInstructions(Code PC, size_t size);
 COMMON(Module)		clauseBodyContext(const Clause cl);
 
 static inline code
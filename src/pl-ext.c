@@ -52,6 +52,7 @@
 #include "pl-supervisor.h"
 #include "pl-fli.h"
 #include "pl-nt.h"
+#include "pl-wam.h"
 #include "os/pl-ctype.h"
 #include "os/pl-fmt.h"
 #include "os/pl-prologflag.h"
@@ -157,6 +158,7 @@ static const PL_extension foreigns[] = {
 
 #if COUNTING
   FRG("$count",			0, pl_count,			0),
+  FRG("$count_reset",		0, pl_count_reset,		0),
 #endif /* COUNTING */
 
   FRG("prolog_current_frame",	1, pl_prolog_current_frame,	0),
@@ -374,12 +376,14 @@ DECL_PLIST(alloc);
 DECL_PLIST(atom);
 DECL_PLIST(arith);
 DECL_PLIST(bag);
+DECL_PLIST(columnar);
 DECL_PLIST(comp);
 DECL_PLIST(flag);
 DECL_PLIST(index);
 DECL_PLIST(init);
 DECL_PLIST(list);
 DECL_PLIST(module);
+DECL_PLIST(narray);
 DECL_PLIST(prims);
 DECL_PLIST(strings);
 DECL_PLIST(variant);
@@ -439,12 +443,14 @@ initBuildIns(void)
   REG_PLIST(atom);
   REG_PLIST(arith);
   REG_PLIST(bag);
+  REG_PLIST(columnar);
   REG_PLIST(comp);
   REG_PLIST(flag);
   REG_PLIST(index);
   REG_PLIST(init);
   REG_PLIST(list);
   REG_PLIST(module);
+  REG_PLIST(narray);
   REG_PLIST(prims);
   REG_PLIST(strings);
   REG_PLIST(variant);
@@ -541,6 +547,7 @@ initBuildIns(void)
   PL_meta_predicate(PL_predicate("assertz",          2, "system"), ":-");
   PL_meta_predicate(PL_predicate("retract",          1, "system"), ":");
   PL_meta_predicate(PL_predicate("retractall",       1, "system"), ":");
+  PL_meta_predicate(PL_predicate("columnar",         1, "system"), ":");
   PL_meta_predicate(PL_predicate("clause",           2, "system"), ":?");
 
   PL_meta_predicate(PL_predicate("format",           2, "system"), "+:");
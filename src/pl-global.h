@@ -36,8 +36,8 @@
 
 #ifndef PL_GLOBAL_H_INCLUDED
 #define PL_GLOBAL_H_INCLUDED
-#include "pl-allocpool.h"
 #include "pl-mutex.h"
+#include "pl-allocpool.h"
 #include "pl-thread.h"
 #include "pl-gmp.h"
 
@@ -80,6 +80,7 @@ typedef struct
     code staticp[3];			/* S_STATIC */
     code wrapper[3];			/* S_WRAP */
     code trie_gen[3];			/* S_TRIE_GEN */
+    code shard[3];			/* S_SHARD */
   } supervisors;
 } PL_code_data_t;
 
@@ -152,6 +153,8 @@ struct PL_global_data
     struct
     { int	created;		/* # created hash tables */
       int	destroyed;		/* # destroyed hash tables */
+      int	built_async;		/* # tables built by index builder */
+      double	build_time;		/* Wall time spent filling tables */
     } indexes;
 #ifdef O_PLMT
     int		threads_created;	/* # threads created */
@@ -197,6 +200,10 @@ struct PL_global_data
   { Table	record_lists;		/* Available record lists */
   } recorded_db;
 
+  struct
+  { Table	tables;			/* Definition --> columnar table */
+  } columnar;
+
   struct
   { ArithF     *functions;		/* index --> function */
     size_t	functions_allocated;	/* Size of above array */
@@ -339,6 +346,7 @@ struct PL_global_data
     Procedure	trie_gen_compiled3;
 
     int		static_dirty;		/* #static dirty procedures */
+    unsigned int resolve_epoch;		/* See procedureResolutionChanged() */
 #ifdef O_CLAUSEGC
     Table	dirty;			/* Table of dirty procedures */
 #endif
@@ -401,7 +409,15 @@ struct PL_global_data
     struct
     { pthread_mutex_t	mutex;
       pthread_cond_t	cond;
+      struct index_job *jobs;		/* Indexes to build in the background */
+      struct index_job *jobs_tail;	/* Last queued job */
+      struct index_job *running;	/* Job being built or aborted */
+      size_t		async_threshold; /* Build async above #clauses */
+      int		stop;		/* Ask index builder to stop */
     } index;
+    struct
+    { size_t		threshold;	/* Sort in parallel above #elements */
+    } sort;
   } thread;
 #endif /*O_PLMT*/
 
@@ -530,6 +546,15 @@ struct PL_local_data
     int		warnings;		/* Printed warning messages */
   } statistics;
 
+  struct
+  { unsigned int lookups;		/* Hash index lookups */
+    struct
+    { ClauseIndex index;		/* Sampled index */
+      unsigned int samples;		/* # sampled lookups */
+      unsigned int misses;		/* # sampled lookups without clause */
+    } slots[4];				/* Direct mapped on index address */
+  } key_filter;				/* Sampling for auto Bloom filter */
+
 #ifdef O_GMP
   struct
   { int		persistent;		/* do persistent operations */
@@ -704,6 +729,7 @@ struct PL_local_data
   pl_shift_status_t shift_status;	/* Stack shifter status */
   pl_debugstatus_t _debugstatus;	/* status of the debugger */
   struct btrace *btrace_store;		/* C-backtraces */
+  struct alloc_cache *alloc_cache;	/* Small block cache of our thread */
 #if O_DEBUG
   pl_internaldebugstatus_t internal_debug; /* status of C-level debug flags */
 #endif
@@ -752,6 +778,12 @@ struct PL_local_data
     int		nesting;		/* reload nesting */
   } reload;
 
+  struct
+  { call_cache_entry entries[CALL_CACHE_SETS][CALL_CACHE_WAYS];
+    int64_t	hits;			/* Call site found in the cache */
+    int64_t	misses;			/* Call site not in the cache */
+  } call_cache;
+
   struct
   { DefinitionChain nesting;		/* Nesting chain in the autoloader */
     Definition	loop;			/* We are looping on this def */
@@ -519,6 +519,7 @@ them.  Descriptions:
 #define OP_MAXPRIORITY		1200	/* maximum operator priority */
 #define SMALLSTACK		32 * 1024 /* GC policy */
 #define MAX_PORTRAY_NESTING	100	/* Max recursion in portray */
+#define PARALLEL_SORT_THRESHOLD 100000	/* Default sort_parallel_threshold */
 
 #define LOCAL_MARGIN ((size_t)argFrameP((LocalFrame)NULL, MAXARITY) + \
 		      sizeof(struct choice))
@@ -749,6 +750,9 @@ typedef struct definition_chain *DefinitionChain; /* linked list of defs */
 typedef struct clause *		Clause;		/* compiled clause */
 typedef struct clause_ref *	ClauseRef;      /* reference to a clause */
 typedef struct clause_index *	ClauseIndex;    /* Clause indexing table */
+typedef struct clause_keys *	ClauseKeys;	/* Packed first argument keys */
+typedef struct key_filter *	KeyFilter;	/* Bloom filter on first argument */
+typedef struct shard_info *	ShardInfo;	/* Sharded dynamic predicate */
 typedef struct clause_bucket *	ClauseBucket;   /* Bucked in clause-index table */
 typedef struct operator *	Operator;	/* see pl-op.c, pl-read.c */
 typedef struct record *		Record;		/* recorda/3, etc. */
@@ -1486,7 +1490,8 @@ enum code_arg_types {
 
 typedef enum
 { VMI_REPLACE,
-  VMI_STEP_ARGUMENT
+  VMI_STEP_ARGUMENT,
+  VMI_FUSE
 } vmi_merge_type;
 
 typedef struct
@@ -1529,6 +1534,13 @@ struct clause_bucket
 
 typedef unsigned char iarg_t;		/* index argument */
 
+typedef struct index_stats
+{ uint64_t	 lookups;		/* # lookups using this index */
+  uint64_t	 hits;			/* # lookups that found a clause */
+  uint64_t	 scanned;		/* # clause references scanned */
+  uint64_t	 choicepoints;		/* # lookups leaving a choice */
+} index_stats;
+
 struct clause_index
 { unsigned int	 buckets;		/* # entries */
   unsigned int	 size;			/* # clauses */
@@ -1538,10 +1550,12 @@ struct clause_index
   unsigned	 is_list : 1;		/* Index with lists */
   unsigned	 incomplete : 1;	/* Index is incomplete */
   unsigned	 invalid : 1;		/* Index is invalid */
+  unsigned	 async : 1;		/* Index is filled by index builder */
   iarg_t	 args[MAX_MULTI_INDEX];	/* Indexed arguments */
   iarg_t	 position[MAXINDEXDEPTH+1]; /* Deep index position */
   float		 speedup;		/* Estimated speedup */
   ClauseBucket	 entries;		/* chains holding the clauses */
+  index_stats	 stats;			/* Usage statistics */
 };
 
 #define MAX_BLOCKS 20			/* allows for 2M threads */
@@ -1565,6 +1579,10 @@ struct definition
   unsigned int  flags;			/* booleans (P_*) */
   unsigned int  shared;			/* #procedures sharing this def */
   struct linger_list  *lingering;	/* Assocated lingering objects */
+  ClauseKeys	clause_keys;		/* Packed keys for linear scan */
+  KeyFilter	key_filter;		/* Bloom filter on first argument */
+  ShardInfo	shards;			/* Sharded predicate and its shards */
+  counting_mutex *mutex;		/* Private LOCKDEF() mutex (shards) */
   gen_t		last_modified;		/* Generation I was last modified */
   struct event_list  *events;		/* Forward update events */
   struct table_props *tabling;		/* Extended properties for tabling */
@@ -1574,6 +1592,8 @@ struct definition
 #endif
 };
 
+#define NO_KEY_FILTER ((KeyFilter)1)	/* def->key_filter: disabled */
+
 struct definition_chain
 { Definition		definition;	/* chain on definition */
   DefinitionChain	next;		/* next in chain */
@@ -1609,6 +1629,22 @@ struct procedure
   unsigned int	source_no;		/* Source I'm assigned to */
 };
 
+/* Per-thread cache of meta-call sites (I_USERCALL0, I_USERCALLN).  See
+   resolveCallSite() in pl-wam.c
+*/
+
+#define CALL_CACHE_SETS		64	/* # sets (must be power of 2) */
+#define CALL_CACHE_WAYS		2	/* # entries per set */
+
+typedef struct call_cache_entry
+{ Code		pc;			/* Call site */
+  word		goal;			/* Functor or atom of the goal */
+  Module	module;			/* Module the goal is called in */
+  Procedure	procedure;		/* Resolved procedure */
+  unsigned int	epoch;			/* GD->procedures.resolve_epoch */
+  unsigned int	callargs;		/* Extra arguments of call/N */
+} call_cache_entry;
+
 struct localFrame
 { Code		programPointer;		/* pointer into program */
   LocalFrame	parent;			/* parent local frame */
@@ -2518,7 +2554,8 @@ typedef enum plflag
   PLFLAG_RATIONAL,			/* Natural rational numbers */
   PLFLAG_DEBUG_ON_INTERRUPT,		/* Debug on Control-C */
   PLFLAG_OPTIMISE_UNIFY,		/* Move unifications in clauses */
-  PLFLAG_SHIFT_CHECK			/* Check suspicious shifts */
+  PLFLAG_SHIFT_CHECK,			/* Check suspicious shifts */
+  PLFLAG_INDEX_STATISTICS		/* Maintain clause index statistics */
 } plflag;
 
 typedef struct
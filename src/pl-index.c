@@ -40,7 +40,12 @@
 #include "pl-proc.h"
 #include "pl-fli.h"
 #include "pl-wam.h"
+#include "pl-thread.h"
 #include <math.h>
+#if defined(__SSE2__) && SIZEOF_VOIDP == 8
+#include <immintrin.h>
+#define O_SIMD_KEYS 1
+#endif
 
 		 /*******************************
 		 *	     PARAMETERS		*
@@ -57,11 +62,32 @@
   - MAX_VAR_FRAC
     Do not create an index if the fraction of clauses with a variable
     in the target position exceeds this threshold.
+  - MIN_KEY_ARRAY
+  - MAX_KEY_ARRAY
+    Range for the number of clauses of a predicate for which we
+    maintain a packed array of first argument keys for linear scans.
+    Below the minimum, walking the clause list is as fast.
+  - KEY_FILTER_MIN_CLAUSES
+  - KEY_FILTER_SAMPLE
+  - KEY_FILTER_CHECK
+  - KEY_FILTER_MISS_RATIO
+    A dynamic predicate with at least KEY_FILTER_MIN_CLAUSES clauses
+    automatically gets a Bloom filter on its first argument if more
+    than KEY_FILTER_MISS_RATIO of the lookups on its first argument
+    index find no clause.  Each thread samples one in KEY_FILTER_SAMPLE
+    of its hash lookups in thread-local counters and this is checked
+    every KEY_FILTER_CHECK samples of an index.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #define MAX_LOOKAHEAD  100
 #define MIN_SPEEDUP    1.5
 #define MAX_VAR_FRAC   0.1
+#define MIN_KEY_ARRAY  8
+#define MAX_KEY_ARRAY  1024
+#define KEY_FILTER_MIN_CLAUSES 1000
+#define KEY_FILTER_SAMPLE      16
+#define KEY_FILTER_CHECK       64
+#define KEY_FILTER_MISS_RATIO  0.5
 
 
 		 /*******************************
@@ -78,6 +104,24 @@ typedef struct hash_hints
   unsigned	list : 1;		/* Use a list per key */
 } hash_hints;
 
+struct clause_keys
+{ size_t	count;			/* # clause references */
+  size_t	capacity;		/* # allocated entries */
+  ClauseRef    *crefs;			/* Clause references (after keys) */
+  word		keys[];			/* First argument keys */
+};
+
+struct key_filter
+{ unsigned int	ln_bits;		/* Lg2 of #bits */
+  unsigned int	keys;			/* # keys added */
+  unsigned int	deleted;		/* # clauses deleted since built */
+  unsigned int	var_keys;		/* # clauses without a key */
+  uint64_t	lookups;		/* # calls tested */
+  uint64_t	rejected;		/* # calls failed by the filter */
+  uint64_t	false_positives;	/* # passed calls without a clause */
+  uint64_t	bits[];			/* The filter */
+};
+
 typedef struct index_context
 { gen_t		generation;		/* Current generation */
   Definition	predicate;		/* Current predicate */
@@ -108,7 +152,9 @@ static ClauseRef first_clause_guarded(Word argv, size_t argc, ClauseList clist,
 static Code	skipToTerm(Clause clause, const iarg_t *position);
 static void	unalloc_index_array(void *p);
 static void	wait_for_index(const ClauseIndex ci);
-static void	completed_index(ClauseIndex ci);
+static void	completed_index(ClauseIndex ci, double start);
+static void	sample_key_filter(ClauseIndex ci, ClauseRef cref,
+				  IndexContext ctx ARG_LD);
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Compute the index in the hash-array from   a machine word and the number
@@ -196,6 +242,12 @@ getIndexOfTerm(term_t t)
 }
 
 
+word
+getIndexOfWord(word w ARG_LD)
+{ return indexOfWord(w PASS_LD);
+}
+
+
 static inline ClauseRef
 nextClauseArg1(ClauseChoice chp, gen_t generation ARG_LD)
 { ClauseRef cref = chp->cref;
@@ -229,8 +281,235 @@ nextClauseArg1(ClauseChoice chp, gen_t generation ARG_LD)
 }
 
 
+		 /*******************************
+		 *	  PACKED KEY SCAN	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Linear scanning of the clause list of  small or unindexable predicates
+chases a pointer for each clause.  We therefore keep the first argument
+keys of the clause list of such predicates in  a packed array, together
+with the clause references in the same order.  The array includes erased
+clauses, so visibility is still decided by  the generation of the caller,
+just as for the clause list.
+
+The entries of the array are never changed.  A clause added at the end
+of the clause list is appended  if  there   is  space,  which  is made
+visible by incrementing `count` after  writing   the  entry.  Any other
+change to the clause list (asserta/1,  unlinking   a  clause reference)
+drops the array.  All changes are made   holding  LOCKDEF().  A dropped
+array lingers until no thread can be scanning it and a new one is built
+lazily by the next call.  For dynamic  predicates   we  allocate twice
+the required size, such that assertz/1 does   not  drop the array and
+retract/1 only drops it when clause GC  unlinks the erased clauses.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+unalloc_clause_keys(void *p)
+{ ClauseKeys ck = p;
+
+  freeHeap(ck, sizeof(*ck) + ck->capacity*(sizeof(word)+sizeof(ClauseRef)));
+}
+
+
+/* Must be called with LOCKDEF() held after changing the clause list */
+
+void
+invalidateClauseKeys(Definition def)
+{ ClauseKeys ck;
+
+  if ( (ck=def->clause_keys) )
+  { def->clause_keys = NULL;
+    MEMORY_BARRIER();
+    linger(&def->lingering, unalloc_clause_keys, ck);
+  }
+}
+
+
+/* Must be called with LOCKDEF() held after adding cref to the clause
+   list.
+*/
+
+void
+addClauseKeys(Definition def, ClauseRef cref)
+{ ClauseKeys ck;
+
+  if ( (ck=def->clause_keys) )
+  { if ( cref == def->impl.clauses.last_clause && ck->count < ck->capacity )
+    { ck->keys[ck->count]  = cref->d.key;
+      ck->crefs[ck->count] = cref;
+      MEMORY_BARRIER();
+      ck->count++;
+    } else
+    { invalidateClauseKeys(def);
+    }
+  }
+}
+
+
+void
+freeClauseKeys(Definition def)
+{ ClauseKeys ck;
+
+  if ( (ck=def->clause_keys) )
+  { def->clause_keys = NULL;
+    unalloc_clause_keys(ck);
+  }
+}
+
+
+static ClauseKeys
+getClauseKeys(Definition def)
+{ ClauseKeys ck;
+
+  if ( true(def, P_FOREIGN) ||
+       def->impl.clauses.number_of_clauses +
+       def->impl.clauses.erased_clauses > MAX_KEY_ARRAY )
+    return NULL;
+
+  LOCKDEF(def);
+  if ( !(ck=def->clause_keys) )
+  { ClauseRef cref;
+    size_t count = 0;
+
+    for(cref=def->impl.clauses.first_clause; cref; cref=cref->next)
+      count++;
+
+    if ( count > 0 && count <= MAX_KEY_ARRAY )
+    { size_t capacity = true(def, P_DYNAMIC) ? count*2 : count;
+      size_t i;
+
+      ck = allocHeapOrHalt(sizeof(*ck) +
+			   capacity*(sizeof(word)+sizeof(ClauseRef)));
+      ck->count    = count;
+      ck->capacity = capacity;
+      ck->crefs    = (ClauseRef*)&ck->keys[capacity];
+      for(i=0, cref=def->impl.clauses.first_clause; cref; cref=cref->next, i++)
+      { ck->keys[i]  = cref->d.key;
+	ck->crefs[i] = cref;
+      }
+      MEMORY_BARRIER();
+      def->clause_keys = ck;
+    }
+  }
+  UNLOCKDEF(def);
+
+  return ck;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+scan_keys() returns the index of the first key  at  or  after  `i`  that
+matches `key`, i.e., is equal to it or is 0 (variable).  If  there  is  no
+such key it returns `n`.  We compare two (SSE2) or four  (AVX2)  keys  at
+a time.  As SSE2 lacks a 64-bit compare, we compare the  32-bit  halves
+and combine them.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static inline size_t
+scan_keys(const word *keys, size_t i, size_t n, word key)
+{
+#ifdef O_SIMD_KEYS
+#ifdef __AVX2__
+  const __m256i k4 = _mm256_set1_epi64x((int64_t)key);
+  const __m256i z4 = _mm256_setzero_si256();
+
+  for(; i+4 <= n; i += 4)
+  { __m256i v = _mm256_loadu_si256((const __m256i*)&keys[i]);
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi64(v, k4),
+				_mm256_cmpeq_epi64(v, z4));
+    int bits = _mm256_movemask_pd(_mm256_castsi256_pd(m));
+
+    if ( bits )
+      return i + __builtin_ctz(bits);
+  }
+#endif
+  const __m128i k2 = _mm_set1_epi64x((int64_t)key);
+  const __m128i z2 = _mm_setzero_si128();
+
+  for(; i+2 <= n; i += 2)
+  { __m128i v = _mm_loadu_si128((const __m128i*)&keys[i]);
+    __m128i e = _mm_cmpeq_epi32(v, k2);
+    __m128i z = _mm_cmpeq_epi32(v, z2);
+    __m128i m;
+    int bits;
+
+    e = _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2,3,0,1)));
+    z = _mm_and_si128(z, _mm_shuffle_epi32(z, _MM_SHUFFLE(2,3,0,1)));
+    m = _mm_or_si128(e, z);
+    if ( (bits = _mm_movemask_pd(_mm_castsi128_pd(m))) )
+      return i + ((bits&1) ? 0 : 1);
+  }
+#endif
+
+  for(; i<n; i++)
+  { if ( !keys[i] || keys[i] == key )
+      return i;
+  }
+
+  return n;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+firstClauseFromKeys() is the packed array version  of  nextClauseArg1()
+starting  at  the  first  clause.  The  lookahead  for  determinism  is
+bounded by MAX_LOOKAHEAD clause references, as in nextClauseArg1().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static inline ClauseRef
+firstClauseFromKeys(ClauseKeys ck, ClauseChoice chp, gen_t generation ARG_LD)
+{ const word key = chp->key;
+  const size_t n = ck->count;
+  size_t i;
+
+  for(i=0; (i=scan_keys(ck->keys, i, n, key)) < n; i++)
+  { ClauseRef result = ck->crefs[i];
+
+    if ( visibleClauseCNT(result->value.clause, generation) )
+    { size_t end = i+1+MAX_LOOKAHEAD;
+      size_t j;
+
+      if ( end > n )
+	end = n;
+      for(j=i+1; (j=scan_keys(ck->keys, j, end, key)) < end; j++)
+      { if ( visibleClauseCNT(ck->crefs[j]->value.clause, generation) )
+	{ chp->cref = ck->crefs[j];
+	  return result;
+	}
+      }
+      for(chp->cref = NULL; j < n; j++)
+      { if ( visibleClauseCNT(ck->crefs[j]->value.clause, generation) )
+	{ chp->cref = ck->crefs[j];
+	  break;
+	}
+      }
+
+      return result;
+    }
+  }
+
+  return NULL;
+}
+
+
+static inline ClauseRef
+firstClauseArg1(ClauseList clist, IndexContext ctx ARG_LD)
+{ ClauseKeys ck;
+
+  if ( clist->number_of_clauses >= MIN_KEY_ARRAY &&
+       clist == &ctx->predicate->impl.clauses && !LD->reload.generation &&
+       ((ck=ctx->predicate->clause_keys) ||
+	(ck=getClauseKeys(ctx->predicate))) )
+    return firstClauseFromKeys(ck, ctx->chp, ctx->generation PASS_LD);
+
+  ctx->chp->cref = clist->first_clause;
+  return nextClauseArg1(ctx->chp, ctx->generation PASS_LD);
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-nextClauseFromBucket()
+findClauseInBucket()
 
 If we search for a functor there  are   two  options: we have a list for
 this functor, in which case we can use   this or we don't. In the latter
@@ -247,7 +526,8 @@ TBD: Keep a flag telling whether there are non-indexable clauses.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static ClauseRef
-nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
+findClauseInBucket(ClauseIndex ci, Word argv, IndexContext ctx,
+		   size_t *scanned ARG_LD)
 { ClauseRef cref;
   word key = ctx->chp->key;
 
@@ -258,7 +538,8 @@ nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
 
   non_indexed:
     for(cref = ctx->chp->cref; cref; cref = cref->next)
-    { if ( cref->d.key == key )
+    { (*scanned)++;
+      if ( cref->d.key == key )
       { ClauseList cl = &cref->value.clauses;
 	ClauseRef cr;
 
@@ -287,7 +568,8 @@ nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
 
 	ctx->chp->key = 0;		/* See (*) */
 	for(cr=cl->first_clause; cr; cr=cr->next)
-	{ if ( visibleClauseCNT(cr->value.clause, ctx->generation) )
+	{ (*scanned)++;
+	  if ( visibleClauseCNT(cr->value.clause, ctx->generation) )
 	  { setClauseChoice(ctx->chp, cr->next, ctx->generation PASS_LD);
 	    return cr;
 	  }
@@ -309,13 +591,15 @@ nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
   }
 
   for(cref = ctx->chp->cref; cref; cref = cref->next)
-  { if ( (!cref->d.key || key == cref->d.key) &&
+  { (*scanned)++;
+    if ( (!cref->d.key || key == cref->d.key) &&
 	 visibleClauseCNT(cref->value.clause, ctx->generation))
     { ClauseRef result = cref;
       int maxsearch = MAX_LOOKAHEAD;
 
       for( cref = cref->next; cref; cref = cref->next )
-      { if ( ((!cref->d.key || key == cref->d.key) &&
+      { (*scanned)++;
+	if ( ((!cref->d.key || key == cref->d.key) &&
 	      visibleClauseCNT(cref->value.clause, ctx->generation)) ||
 	     --maxsearch == 0 )
 	{ setClauseChoice(ctx->chp, cref, ctx->generation PASS_LD);
@@ -332,6 +616,38 @@ nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
   return NULL;
 }
 
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+nextClauseFromBucket() looks up the  clause  using  a  hash  index.  The
+counters in the index are shared by all threads  using  it.  Updating
+them on every lookup makes these threads contend for the cache line and
+therefore the usage statistics are only maintained if the thread-local
+flag `index_statistics` is set.  They  are  updated  without
+synchronization and are thus approximate under concurrent use.  The
+miss ratio used to decide on a key filter  is  based  on  a  sample
+kept in thread-local counters (see sample_key_filter()).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static ClauseRef
+nextClauseFromBucket(ClauseIndex ci, Word argv, IndexContext ctx ARG_LD)
+{ size_t scanned = 0;
+  ClauseRef cref = findClauseInBucket(ci, argv, ctx, &scanned PASS_LD);
+
+  if ( truePrologFlag(PLFLAG_INDEX_STATISTICS) )
+  { ci->stats.lookups++;
+    ci->stats.scanned += scanned;
+    if ( cref )
+    { ci->stats.hits++;
+      if ( ctx->chp->cref )
+	ci->stats.choicepoints++;
+    }
+  }
+  if ( unlikely(++LD->key_filter.lookups % KEY_FILTER_SAMPLE == 0) )
+    sample_key_filter(ci, cref, ctx PASS_LD);
+
+  return cref;
+}
+
 /* Make sure the ClauseChoice contains a pointer to a clause that
    is still visible in generation.  This garantees that the clause will
    not be destroyed. Note that we do not have to perform the full
@@ -417,6 +733,7 @@ first_clause_guarded(Word argv, size_t argc, ClauseList clist,
   ClauseIndex *cip;
   hash_hints hints;
   ClauseChoice chp = ctx->chp;
+  int pending;				/* async index is being filled */
 
 #define STATIC_RELOADING() (LD->reload.generation && false(ctx->predicate, P_DYNAMIC))
 
@@ -426,6 +743,7 @@ first_clause_guarded(Word argv, size_t argc, ClauseList clist,
     argc = MAXINDEXARG;
 
 retry:
+  pending = FALSE;
   if ( (cip=clist->clause_indexes) )
   { ClauseIndex best_index = NULL;
 
@@ -435,6 +753,10 @@ retry:
 
       if ( ISDEADCI(ci) )
 	continue;
+      if ( ci->async && ci->incomplete )
+      { pending = TRUE;
+	continue;
+      }
 
       if ( (k=indexKeyFromArgv(ci, argv PASS_LD)) )
       { best_index = ci;
@@ -448,7 +770,7 @@ retry:
 
       if ( clist->number_of_clauses > 10 &&
 	   (float)clist->number_of_clauses/best_index->speedup > 10 &&
-	   !STATIC_RELOADING() )
+	   !STATIC_RELOADING() && !pending )
       { DEBUG(MSG_JIT_POOR,
 	      Sdprintf("Poor index %s of %s (trying to find better)\n",
 		       iargsName(best_index->args, NULL),
@@ -463,9 +785,11 @@ retry:
 				  iargsName(hints.args, NULL)));
 
 	  if ( (ci=hashDefinition(clist, &hints, ctx)) )
-	  { chp->key = indexKeyFromArgv(ci, argv PASS_LD);
-	    assert(chp->key);
-	    best_index = ci;
+	  { if ( !(ci->async && ci->incomplete) )
+	    { chp->key = indexKeyFromArgv(ci, argv PASS_LD);
+	      assert(chp->key);
+	      best_index = ci;
+	    }				/* else keep using the current one */
 	  } else
 	  { goto retry;
 	  }
@@ -488,9 +812,7 @@ retry:
 
   if ( (chp->key = indexOfWord(argv[0] PASS_LD)) &&
        (clist->number_of_clauses <= 10 || STATIC_RELOADING()) )
-  { chp->cref = clist->first_clause;
-
-    cref = nextClauseArg1(chp, ctx->generation PASS_LD);
+  { cref = firstClauseArg1(clist, ctx PASS_LD);
     if ( !cref ||
 	 !(chp->cref && chp->cref->d.key == chp->key &&
 	   cref->d.key == chp->key) )
@@ -499,13 +821,15 @@ retry:
     /* TBD: Avoid trying this every goal */
   }
 
-  if ( !STATIC_RELOADING() &&
+  if ( !STATIC_RELOADING() && !pending &&
        bestHash(argv, argc, clist, 0.0, &hints, ctx PASS_LD) )
   { ClauseIndex ci;
 
     if ( (ci=hashDefinition(clist, &hints, ctx)) )
     { int hi;
 
+      if ( ci->async && ci->incomplete )
+	goto linear;			/* scan while the builder works */
       while ( ci->incomplete )
 	wait_for_index(ci);
       if ( ci->invalid )
@@ -521,10 +845,9 @@ retry:
     }
   }
 
+linear:
   if ( chp->key )
-  { chp->cref = clist->first_clause;
-    return nextClauseArg1(chp, ctx->generation PASS_LD);
-  }
+    return firstClauseArg1(clist, ctx PASS_LD);
 
 simple:
   for(cref = clist->first_clause; cref; cref = cref->next)
@@ -538,6 +861,301 @@ simple:
   return cref;
 }
 
+		 /*******************************
+		 *	 BLOOM KEY FILTER	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A predicate may have a Bloom filter  on  the  first  argument  keys  of
+its clauses.  If the first argument of a call is bound and  its  key  is
+not in the filter, firstClause() fails without using the clause indexes.
+This speeds up membership tests that fail on large predicates.
+
+Keys are added to the filter by addClauseToIndexes() before the  clause
+becomes visible.  Deleting a clause does not clear bits:  the  clause  may
+still be visible to  running  goals.   Instead  we  count  deleted  clauses
+and rebuild the filter from the clause  list,  including  erased  clauses
+that are not yet reclaimed,  if  too  many  clauses  were  deleted  or  the
+filter gets too full.  All updates are made holding LOCKDEF() by the
+thread that modifies the predicate, so calls only read the filter.  A
+replaced filter lingers until no thread can be using it.  The usage
+counters of the filter are only updated if the thread-local flag
+`index_statistics` is set (see nextClauseFromBucket()).
+
+If there are clauses without a key (variable first argument) the filter
+cannot reject any call and is ignored.
+
+def->key_filter is NULL if the predicate has no filter,  NO_KEY_FILTER if
+a filter is disabled using dynamic/2 option bloom(false) or  a  pointer  to
+the filter.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define KF_PROBES 3			/* # hash functions */
+#define KF_BITS_PER_KEY 16		/* initial bits per key */
+
+static inline uint64_t
+kf_hash(word key)
+{ uint64_t k = (uint64_t)key;
+
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+
+  return k;
+}
+
+static inline void
+kf_add(KeyFilter kf, word key)
+{ uint64_t h = kf_hash(key);
+  uint64_t h1 = h&0xffffffff, h2 = (h>>32)|1;
+  uint64_t mask = ((uint64_t)1<<kf->ln_bits)-1;
+  int i;
+
+  for(i=0; i<KF_PROBES; i++)
+  { uint64_t b = (h1+i*h2)&mask;
+
+    kf->bits[b/64] |= (uint64_t)1<<(b%64);
+  }
+}
+
+static inline int
+kf_test(const KeyFilter kf, word key)
+{ uint64_t h = kf_hash(key);
+  uint64_t h1 = h&0xffffffff, h2 = (h>>32)|1;
+  uint64_t mask = ((uint64_t)1<<kf->ln_bits)-1;
+  int i;
+
+  for(i=0; i<KF_PROBES; i++)
+  { uint64_t b = (h1+i*h2)&mask;
+
+    if ( !(kf->bits[b/64] & ((uint64_t)1<<(b%64))) )
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static inline size_t
+kf_bytes(unsigned int ln_bits)
+{ return sizeof(struct key_filter) + ((size_t)1<<ln_bits)/8;
+}
+
+static void
+unalloc_key_filter(void *p)
+{ KeyFilter kf = p;
+
+  freeHeap(kf, kf_bytes(kf->ln_bits));
+}
+
+static inline int
+kf_stale(const KeyFilter kf)
+{ return ( kf->deleted > kf->keys/2 ||
+	   (size_t)kf->keys*(KF_BITS_PER_KEY/2) > ((size_t)1<<kf->ln_bits) );
+}
+
+/* Must be called with LOCKDEF() held.  Creates or refreshes the filter */
+
+static KeyFilter
+buildKeyFilter(Definition def)
+{ KeyFilter old = def->key_filter;
+  KeyFilter kf;
+  ClauseRef cref;
+  size_t count = 0;
+  unsigned int ln_bits = 14;		/* 16K bits minimum */
+  size_t bytes;
+
+  if ( old == NO_KEY_FILTER )
+    return NULL;
+  if ( old && !kf_stale(old) )
+    return old;
+
+  for(cref=def->impl.clauses.first_clause; cref; cref=cref->next)
+    count++;
+  while( ((size_t)1<<ln_bits) < count*KF_BITS_PER_KEY && ln_bits < 40 )
+    ln_bits++;
+
+  bytes = kf_bytes(ln_bits);
+  kf = allocHeapOrHalt(bytes);
+  memset(kf, 0, bytes);
+  kf->ln_bits = ln_bits;
+  if ( old )
+  { kf->lookups         = old->lookups;
+    kf->rejected        = old->rejected;
+    kf->false_positives = old->false_positives;
+  }
+
+  for(cref=def->impl.clauses.first_clause; cref; cref=cref->next)
+  { if ( cref->d.key )
+    { kf_add(kf, cref->d.key);
+      kf->keys++;
+    } else
+    { kf->var_keys++;
+    }
+  }
+
+  MEMORY_BARRIER();
+  def->key_filter = kf;
+  if ( old )
+    linger(&def->lingering, unalloc_key_filter, old);
+
+  DEBUG(MSG_JIT, Sdprintf("Bloom filter for %s: %d keys, 2^%d bits\n",
+			  predicateName(def), kf->keys, ln_bits));
+
+  return kf;
+}
+
+
+static void
+refreshKeyFilter(Definition def)
+{ LOCKDEF(def);
+  buildKeyFilter(def);
+  UNLOCKDEF(def);
+}
+
+
+/* sample_key_filter() records a sampled lookup on ci.  The samples are
+   kept per thread in a small table that is indexed on the address of
+   the index, so threads do not write to the shared ClauseIndex.  A slot
+   that is taken by another index is reset.  Every KEY_FILTER_CHECK
+   samples we decide on creating a filter and restart the sample.
+*/
+
+static void
+sample_key_filter(ClauseIndex ci, ClauseRef cref, IndexContext ctx ARG_LD)
+{ Definition def = ctx->predicate;
+  size_t nslots = sizeof(LD->key_filter.slots)/sizeof(LD->key_filter.slots[0]);
+  size_t i = ((uintptr_t)ci/sizeof(struct clause_index)) % nslots;
+  unsigned int samples, misses;
+
+  if ( LD->key_filter.slots[i].index != ci )
+  { LD->key_filter.slots[i].index   = ci;
+    LD->key_filter.slots[i].samples = 0;
+    LD->key_filter.slots[i].misses  = 0;
+  }
+  if ( !cref )
+    LD->key_filter.slots[i].misses++;
+  if ( ++LD->key_filter.slots[i].samples < KEY_FILTER_CHECK )
+    return;
+
+  samples = LD->key_filter.slots[i].samples;
+  misses  = LD->key_filter.slots[i].misses;
+  LD->key_filter.slots[i].samples = 0;
+  LD->key_filter.slots[i].misses  = 0;
+
+  if ( ctx->depth == 0 &&
+       ci->args[0] == 1 && ci->args[1] == 0 &&
+       !def->key_filter &&
+       true(def, P_DYNAMIC) &&
+       def->impl.clauses.number_of_clauses >= KEY_FILTER_MIN_CLAUSES &&
+       (double)misses > (double)samples*KEY_FILTER_MISS_RATIO )
+  { DEBUG(MSG_JIT, Sdprintf("High miss ratio for %s: creating filter\n",
+			    predicateName(def)));
+    refreshKeyFilter(def);
+  }
+}
+
+
+/* Called from addClauseToIndexes() with LOCKDEF() held.  A filter that
+   became stale is rebuilt here, such that calls never have to.
+*/
+
+static void
+addClauseToKeyFilter(Definition def, Clause cl)
+{ KeyFilter kf;
+
+  if ( (kf=def->key_filter) && kf != NO_KEY_FILTER )
+  { word key;
+
+    argKey(cl->codes, 0, &key);
+    if ( key )
+    { kf_add(kf, key);
+      kf->keys++;
+    } else
+    { kf->var_keys++;
+    }
+    if ( kf_stale(kf) )
+      buildKeyFilter(def);
+  }
+}
+
+
+static void
+delClauseFromKeyFilter(Definition def)
+{ KeyFilter kf;
+
+  if ( (kf=def->key_filter) && kf != NO_KEY_FILTER )
+  { kf->deleted++;
+    if ( kf_stale(kf) )
+      buildKeyFilter(def);
+  }
+}
+
+
+/** setKeyFilterDefinition() implements the bloom(Bool) option of
+ * dynamic/2.  Enabling creates the filter immediately.
+ */
+
+int
+setKeyFilterDefinition(Definition def, int val)
+{ KeyFilter old;
+
+  LOCKDEF(def);
+  old = def->key_filter;
+  if ( val )
+  { if ( old == NO_KEY_FILTER )
+      def->key_filter = NULL;
+    buildKeyFilter(def);
+  } else if ( old != NO_KEY_FILTER )
+  { def->key_filter = NO_KEY_FILTER;
+    if ( old )
+      linger(&def->lingering, unalloc_key_filter, old);
+  }
+  UNLOCKDEF(def);
+
+  return TRUE;
+}
+
+
+void
+freeKeyFilter(Definition def)
+{ KeyFilter kf = def->key_filter;
+
+  def->key_filter = NULL;
+  if ( kf && kf != NO_KEY_FILTER )
+    unalloc_key_filter(kf);
+}
+
+
+/** unify_key_filter() unifies t with
+ *
+ *	bloom(Bits, Keys, Lookups, Rejected, FalsePositives)
+ *
+ * Fails if the predicate has no filter.
+ */
+
+int
+unify_key_filter(Definition def, term_t t)
+{ GET_LD
+  KeyFilter kf;
+  int rc = FALSE;
+
+  acquire_def(def);
+  if ( (kf=def->key_filter) && kf != NO_KEY_FILTER )
+    rc = PL_unify_term(t,
+		       PL_FUNCTOR, FUNCTOR_bloom5,
+			 PL_INT64, (int64_t)1<<kf->ln_bits,
+			 PL_INT64, (int64_t)kf->keys,
+			 PL_INT64, (int64_t)kf->lookups,
+			 PL_INT64, (int64_t)kf->rejected,
+			 PL_INT64, (int64_t)kf->false_positives);
+  release_def(def);
+
+  return rc;
+}
+
+
 int acquired = 0;
 
 ClauseRef
@@ -553,11 +1171,39 @@ firstClause(Word argv, LocalFrame fr, Definition def, ClauseChoice chp ARG_LD)
 
   MEMORY_ACQUIRE();			/* sync with retract_clause() */
   acquire_def(def);
+  if ( unlikely(def->key_filter != NULL) && def->functor->arity > 0 )
+  { KeyFilter kf = def->key_filter;
+    word key;
+
+    if ( kf != NO_KEY_FILTER &&
+	 kf->var_keys == 0 &&
+	 (key = indexOfWord(argv[0] PASS_LD)) )
+    { int stats = truePrologFlag(PLFLAG_INDEX_STATISTICS);
+
+      if ( stats )
+	kf->lookups++;
+      if ( !kf_test(kf, key) )
+      { if ( stats )
+	  kf->rejected++;
+	release_def(def);
+	return NULL;
+      }
+      cref = first_clause_guarded(argv,
+				  def->functor->arity,
+				  &def->impl.clauses,
+				  &ctx
+				  PASS_LD);
+      if ( !cref && stats )
+	kf->false_positives++;
+      goto out;
+    }
+  }
   cref = first_clause_guarded(argv,
 			      def->functor->arity,
 			      &def->impl.clauses,
 			      &ctx
 			      PASS_LD);
+out:
 #define CHK_STATIC_RELOADING() (LD->reload.generation && false(def, P_DYNAMIC))
   DEBUG(CHK_SECURE, assert(!cref || !chp->cref ||
 			   visibleClause(chp->cref->value.clause,
@@ -1403,6 +2049,7 @@ deleteActiveClauseFromIndexes(Definition def, Clause cl)
 { ClauseIndex *cip;
 
   shrunkpow2(def);
+  delClauseFromKeyFilter(def);
 
   if ( (cip=def->impl.clauses.clause_indexes) )
   { for(; *cip; cip++)
@@ -1533,6 +2180,7 @@ the definition locked.
 int
 addClauseToIndexes(Definition def, Clause clause, ClauseRef where)
 { addClauseToListIndexes(def, &def->impl.clauses, clause, where);
+  addClauseToKeyFilter(def, clause);
   reconsider_index(def);
 
   DEBUG(CHK_SECURE, checkDefinition(def));
@@ -1551,6 +2199,7 @@ delClauseFromIndex(Definition def, Clause cl)
 { ClauseIndex *cip;
 
   shrunkpow2(def);
+  delClauseFromKeyFilter(def);
 
   for(cip=def->impl.clauses.clause_indexes; *cip; cip++)
   { ClauseIndex ci = *cip;
@@ -1593,91 +2242,311 @@ wait_for_index(const ClauseIndex ci)
 
 
 static void
-completed_index(ClauseIndex ci)
-{
+completed_index(ClauseIndex ci, double start)
+{ double time = WallTime() - start;
+
 #ifdef O_PLMT
   pthread_mutex_lock(&GD->thread.index.mutex);
   ci->incomplete = FALSE;
+  GD->statistics.indexes.build_time += time;
   pthread_cond_broadcast(&GD->thread.index.cond);
   pthread_mutex_unlock(&GD->thread.index.mutex);
-  DEBUG(MSG_JIT, Sdprintf("[%d] index %p completed\n",
-			  PL_thread_self(), ci));
+  DEBUG(MSG_JIT, Sdprintf("[%d] index %p completed in %.3f sec\n",
+			  PL_thread_self(), ci, time));
 #else
   ci->incomplete = FALSE;
+  GD->statistics.indexes.build_time += time;
 #endif
 }
 
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Create a hash-index on def  for  arg.   We  compute  the  hash unlocked,
-checking at the end that nobody  messed   with  the clause list. If that
-happened anyway, we retry. At the end,   we  lock the definition and add
-the new index to the indexes of the predicate.
+Fill a newly created index with  the  clauses   of  clist.  This is done
+without holding the predicate  lock.  Threads   that  want  to modify the
+clause list wait for the index  to   become  complete.  Returns FALSE if
+some clause cannot be added,  in  which  case   the  index  is marked as
+invalid and deleted.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-static ClauseIndex
-hashDefinition(ClauseList clist, hash_hints *hints, IndexContext ctx)
+static int
+fillClauseIndex(Definition def, ClauseList clist, ClauseIndex ci)
 { ClauseRef cref;
-  ClauseIndex ci;
-  ClauseIndex *cip;
+  double start = WallTime();
 
-  DEBUG(MSG_JIT, Sdprintf("[%d] hashDefinition(%s, %s, %d) (%s)\n",
-			  PL_thread_self(),
-			  predicateName(ctx->predicate),
-			  iargsName(hints->args, NULL), 2<<hints->ln_buckets,
-			  hints->list ? "lists" : "clauses"));
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Adding a pause here creates  a window where other threads may mark clauses
+as erased (CL_ERASED).  This prevents them being added to the just-created
+index.
 
-#if defined(O_PLMT) && !defined(NDEBUG)
-{ GET_LD
-  assert(LD->thread.info->access.predicate == ctx->predicate);
-}
-#endif
+See the test_cgc_1 test case in src/Tests/GC/test_cgc_1.pl
 
-  canonicalHap(hints->args);
-  LOCKDEF(ctx->predicate);
-  if ( (cip=clist->clause_indexes) )
-  { for(; *cip; cip++)
-    { ClauseIndex cio = *cip;
+  usleep(1000);
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-      if ( ISDEADCI(cio) )
-	continue;
-
-      if ( memcmp(cio->args, hints->args, sizeof(cio->args)) == 0 )
-      { UNLOCKDEF(ctx->predicate);
-	DEBUG(MSG_JIT, Sdprintf("[%d] already created\n", PL_thread_self()));
-	return cio;
+  for(cref = clist->first_clause; cref; cref = cref->next)
+  { if ( false(cref->value.clause, CL_ERASED) )
+    { if ( !addClauseToIndex(ci, cref->value.clause, CL_END) )
+      { ci->invalid = TRUE;
+	completed_index(ci, start);
+	deleteIndex(def, clist, ci);
+	return FALSE;
       }
     }
   }
-  ci = newClauseIndexTable(hints->args, hints, ctx);
-  insertIndex(ctx->predicate, clist, ci);
-  UNLOCKDEF(ctx->predicate);
+
+  ci->resize_above = ci->size*2;
+  ci->resize_below = ci->size/4;
+
+  completed_index(ci, start);
+
+  return TRUE;
+}
+
+
+		 /*******************************
+		 *	  ASYNC INDEXING	*
+		 *******************************/
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Adding a pause here creates  a window where other threads may mark clauses
-as erased (CL_ERASED).  This prevents them being added to the just-created
-index.
+If the Prolog flag  `index_async_threshold`  is   non-zero,  new  primary
+indexes for predicates with at  least   this  many clauses are filled by
+the index builder thread rather  than  by   the  thread  that decided the
+index is needed. Until the index is  complete, first_clause_guarded()
+ignores it and uses the  existing  indexes   or  a  linear scan. Threads
+modifying the predicate still wait for  the index, as they do for indexes
+being filled synchronously by another thread.
+
+We do not use  this  for  deep  indexes  as  these  are typically small
+and for thread-local predicates as the   clause list may disappear with
+the thread.
+
+A job references its predicate from   queueIndexJob() until the index is
+completed or aborted.  acquire_def() only   protects  a predicate for the
+calling thread.  Queued  jobs  and  the   running  job  are  therefore
+reported by predicates_in_use() and indexJobPredicate(), such that clause
+GC neither frees the clause references, the lingering (deleted) index
+nor the erased predicate while the job may access them.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-See the test_cgc_1 test case in src/Tests/GC/test_cgc_1.pl
+static int
+async_index(ClauseList clist, IndexContext ctx)
+{
+#ifdef O_PLMT
+  size_t threshold = GD->thread.index.async_threshold;
 
-  usleep(1000);
+  return ( threshold > 0 &&
+	   ctx->depth == 0 &&
+	   clist == &ctx->predicate->impl.clauses &&
+	   clist->number_of_clauses >= threshold &&
+	   false(ctx->predicate, P_THREAD_LOCAL) );
+#else
+  return FALSE;
+#endif
+}
+
+
+static int
+queueIndexJob(Definition def, ClauseList clist, ClauseIndex ci)
+{
+#ifdef O_PLMT
+  index_job *job;
+
+  if ( !startIndexBuilder() )
+    return FALSE;
+
+  job = allocHeapOrHalt(sizeof(*job));	/* references def until done */
+  job->next  = NULL;
+  job->def   = def;
+  job->clist = clist;
+  job->ci    = ci;
+
+  pthread_mutex_lock(&GD->thread.index.mutex);
+  if ( GD->thread.index.jobs_tail )
+    GD->thread.index.jobs_tail->next = job;
+  else
+    GD->thread.index.jobs = job;
+  GD->thread.index.jobs_tail = job;
+  pthread_cond_broadcast(&GD->thread.index.cond);
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+
+  DEBUG(MSG_JIT, Sdprintf("[%d] queued index %s for %s\n",
+			  PL_thread_self(),
+			  iargsName(ci->args, NULL), predicateName(def)));
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+
+#ifdef O_PLMT
+/* Move the first job from the queue to GD->thread.index.running.  If
+   `wait` is TRUE, wait for a job until the builder is asked to stop.
+*/
+
+static index_job *
+next_index_job(int wait)
+{ index_job *job;
+
+  pthread_mutex_lock(&GD->thread.index.mutex);
+  while ( !(job=GD->thread.index.jobs) && wait && !GD->thread.index.stop )
+    pthread_cond_wait(&GD->thread.index.cond, &GD->thread.index.mutex);
+  if ( job && !(GD->thread.index.jobs = job->next) )
+    GD->thread.index.jobs_tail = NULL;
+  GD->thread.index.running = job;
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+
+  return job;
+}
+
+/* Release the predicate of the running job and free the job */
+
+static void
+done_index_job(index_job *job)
+{ pthread_mutex_lock(&GD->thread.index.mutex);
+  GD->thread.index.running = NULL;
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+  freeHeap(job, sizeof(*job));
+}
+#endif
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+runIndexJobs() is the main loop of   the  index builder thread (see
+pl-thread.c). It returns after the builder is   asked  to stop and the
+queue is empty.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-  for(cref = clist->first_clause; cref; cref = cref->next)
-  { if ( false(cref->value.clause, CL_ERASED) )
-    { if ( !addClauseToIndex(ci, cref->value.clause, CL_END) )
-      { ci->invalid = TRUE;
-	completed_index(ci);
-	deleteIndex(ctx->predicate, clist, ci);
-	return NULL;
+void
+runIndexJobs(void)
+{
+#ifdef O_PLMT
+  index_job *job;
+
+  while( (job=next_index_job(TRUE)) )
+  { if ( fillClauseIndex(job->def, job->clist, job->ci) )
+      ATOMIC_INC(&GD->statistics.indexes.built_async);
+    done_index_job(job);
+  }
+#endif
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+abortIndexJobs() is called if the index  builder thread could not attach
+a Prolog engine. It empties the queue,  deleting   the  indexes that are
+still incomplete and waking the threads  waiting   for  them. As with a
+failed fillClauseIndex(), these threads see the   index  is invalid and
+retry, creating a new index.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+void
+abortIndexJobs(void)
+{
+#ifdef O_PLMT
+  index_job *job;
+
+  while( (job=next_index_job(FALSE)) )
+  { ClauseIndex ci = job->ci;
+
+    DEBUG(MSG_JIT, Sdprintf("Aborted index %s for %s\n",
+			    iargsName(ci->args, NULL),
+			    predicateName(job->def)));
+    LOCKDEF(job->def);
+    ci->invalid = TRUE;
+    deleteIndex(job->def, job->clist, ci);
+    UNLOCKDEF(job->def);
+    completed_index(ci, WallTime());
+    done_index_job(job);
+  }
+#endif
+}
+
+
+/* indexJobPredicate() is TRUE if def is referenced by a queued or
+   running index job.
+*/
+
+int
+indexJobPredicate(Definition def)
+{
+#ifdef O_PLMT
+  index_job *job;
+  int rc = FALSE;
+
+  pthread_mutex_lock(&GD->thread.index.mutex);
+  if ( (job=GD->thread.index.running) && job->def == def )
+    rc = TRUE;
+  for(job=GD->thread.index.jobs; job && !rc; job=job->next)
+  { if ( job->def == def )
+      rc = TRUE;
+  }
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+
+  return rc;
+#else
+  return FALSE;
+#endif
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Create a hash-index on def  for  arg.   We  compute  the  hash unlocked,
+checking at the end that nobody  messed   with  the clause list. If that
+happened anyway, we retry. At the end,   we  lock the definition and add
+the new index to the indexes of the predicate.
+
+If the index is filled asynchronously,  the   returned  index is still
+incomplete.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static ClauseIndex
+hashDefinition(ClauseList clist, hash_hints *hints, IndexContext ctx)
+{ ClauseIndex ci;
+  ClauseIndex *cip;
+
+  DEBUG(MSG_JIT, Sdprintf("[%d] hashDefinition(%s, %s, %d) (%s)\n",
+			  PL_thread_self(),
+			  predicateName(ctx->predicate),
+			  iargsName(hints->args, NULL), 2<<hints->ln_buckets,
+			  hints->list ? "lists" : "clauses"));
+
+#if defined(O_PLMT) && !defined(NDEBUG)
+{ GET_LD
+  assert(LD->thread.info->access.predicate == ctx->predicate);
+}
+#endif
+
+  canonicalHap(hints->args);
+  LOCKDEF(ctx->predicate);
+  if ( (cip=clist->clause_indexes) )
+  { for(; *cip; cip++)
+    { ClauseIndex cio = *cip;
+
+      if ( ISDEADCI(cio) )
+	continue;
+
+      if ( memcmp(cio->args, hints->args, sizeof(cio->args)) == 0 )
+      { UNLOCKDEF(ctx->predicate);
+	DEBUG(MSG_JIT, Sdprintf("[%d] already created\n", PL_thread_self()));
+	return cio;
       }
     }
   }
+  ci = newClauseIndexTable(hints->args, hints, ctx);
+  ci->async = async_index(clist, ctx);
+  insertIndex(ctx->predicate, clist, ci);
+  UNLOCKDEF(ctx->predicate);
 
-  ci->resize_above = ci->size*2;
-  ci->resize_below = ci->size/4;
+  if ( ci->async )
+  { if ( queueIndexJob(ctx->predicate, clist, ci) )
+      return ci;
+    ci->async = FALSE;
+  }
 
-  completed_index(ci);
+  if ( !fillClauseIndex(ctx->predicate, clist, ci) )
+    return NULL;
 
   return ci;
 }
@@ -2737,12 +3606,61 @@ sizeofClauseIndexes(Definition def)
 }
 
 
+#define INDEX_PATTERN	0		/* Args-hash(...) */
+#define INDEX_STATS	1		/* Args-index_stats(...) */
+#define INDEX_BUCKETS	2		/* Args-Histogram */
+
+static int
+unify_bucket_histogram(term_t t, ClauseIndex ci)
+{ GET_LD
+  size_t i, max = 0;
+  size_t *counts;
+  term_t tail = PL_copy_term_ref(t);
+  term_t head = PL_new_term_ref();
+  int rc = TRUE;
+
+  for(i=0; i<ci->buckets; i++)
+  { ClauseRef cref;
+    size_t len = 0;
+
+    for(cref = ci->entries[i].head; cref; cref = cref->next)
+      len++;
+    if ( len > max )
+      max = len;
+  }
+
+  if ( !(counts = malloc((max+1)*sizeof(*counts))) )
+    return PL_no_memory();
+  memset(counts, 0, (max+1)*sizeof(*counts));
+
+  for(i=0; i<ci->buckets; i++)
+  { ClauseRef cref;
+    size_t len = 0;
+
+    for(cref = ci->entries[i].head; cref; cref = cref->next)
+      len++;
+    counts[len]++;
+  }
+
+  for(i=0; i<=max && rc; i++)
+  { if ( counts[i] )
+      rc = ( PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head,
+			   PL_FUNCTOR, FUNCTOR_minus2,
+			     PL_INT64, (int64_t)i,
+			     PL_INT64, (int64_t)counts[i]) );
+  }
+  free(counts);
+
+  return rc && PL_unify_nil(tail);
+}
+
+
 static int
-unify_clause_index(term_t t, ClauseIndex ci)
+unify_clause_index(term_t t, ClauseIndex ci, int what)
 { GET_LD
   term_t where = PL_new_term_ref();
   term_t tmp  = PL_new_term_ref();
-
   if ( !(where=PL_new_term_ref()) ||
        !(tmp =PL_new_term_ref()) )
     return FALSE;
@@ -2787,6 +3705,28 @@ unify_clause_index(term_t t, ClauseIndex ci)
       return FALSE;
   }
 
+  switch(what)
+  { case INDEX_STATS:
+      return PL_unify_term(t,
+			   PL_FUNCTOR, FUNCTOR_minus2,
+			     PL_TERM, where,
+			     PL_FUNCTOR, FUNCTOR_index_stats4,
+			       PL_INT64, (int64_t)ci->stats.lookups,
+			       PL_INT64, (int64_t)ci->stats.hits,
+			       PL_INT64, (int64_t)ci->stats.scanned,
+			       PL_INT64, (int64_t)ci->stats.choicepoints);
+    case INDEX_BUCKETS:
+    { term_t hist;
+
+      return ( (hist=PL_new_term_ref()) &&
+	       unify_bucket_histogram(hist, ci) &&
+	       PL_unify_term(t,
+			     PL_FUNCTOR, FUNCTOR_minus2,
+			       PL_TERM, where,
+			       PL_TERM, hist) );
+    }
+  }
+
   return PL_unify_term(t,
 		       PL_FUNCTOR, FUNCTOR_minus2,
 			 PL_TERM, where,
@@ -2799,7 +3739,7 @@ unify_clause_index(term_t t, ClauseIndex ci)
 
 
 static int
-add_deep_indexes(ClauseIndex ci, term_t head, term_t tail ARG_LD)
+add_deep_indexes(ClauseIndex ci, term_t head, term_t tail, int what ARG_LD)
 { size_t i;
 
   for(i=0; i<ci->buckets; i++)
@@ -2818,10 +3758,10 @@ add_deep_indexes(ClauseIndex ci, term_t head, term_t tail ARG_LD)
 	      continue;
 
 	    if ( !PL_unify_list(tail, head, tail) ||
-		 !unify_clause_index(head, ci) )
+		 !unify_clause_index(head, ci, what) )
 	      return FALSE;
 	    if ( ci->is_list &&
-		 !add_deep_indexes(ci, head, tail PASS_LD) )
+		 !add_deep_indexes(ci, head, tail, what PASS_LD) )
 	      return FALSE;
 	  }
 	}
@@ -2833,20 +3773,23 @@ add_deep_indexes(ClauseIndex ci, term_t head, term_t tail ARG_LD)
 }
 
 
-bool
-unify_index_pattern(Procedure proc, term_t value)
-{ GET_LD
-  Definition def = getProcDefinition__LD(proc->definition PASS_LD);
-  ClauseIndex *cip;
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+unify_indexes() unifies value with a list holding  a  description  of  all
+indexes of def, including the deep indexes.  For INDEX_PATTERN it  fails
+if there are no indexes as required by predicate_property/2.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+unify_indexes(Definition def, term_t value, int what ARG_LD)
+{ ClauseIndex *cip;
+  term_t tail = PL_copy_term_ref(value);
+  term_t head = PL_new_term_ref();
   int rc = FALSE;
   int found = 0;
 
   acquire_def(def);
   if ( (cip=def->impl.clauses.clause_indexes) )
-  { term_t tail = PL_copy_term_ref(value);
-    term_t head = PL_new_term_ref();
-
-    for(; *cip; cip++)
+  { for(; *cip; cip++)
     { ClauseIndex ci = *cip;
 
       if ( ISDEADCI(ci) )
@@ -2854,16 +3797,16 @@ unify_index_pattern(Procedure proc, term_t value)
 
       found++;
       if ( !PL_unify_list(tail, head, tail) ||
-	   !unify_clause_index(head, ci) )
+	   !unify_clause_index(head, ci, what) )
 	goto out;
       if ( ci->is_list )
-      { if ( !add_deep_indexes(ci, head, tail PASS_LD) )
+      { if ( !add_deep_indexes(ci, head, tail, what PASS_LD) )
 	  goto out;
       }
     }
-
-    rc = found && PL_unify_nil(tail);
   }
+
+  rc = (found || what != INDEX_PATTERN) && PL_unify_nil(tail);
 out:
   release_def(def);
 
@@ -2871,9 +3814,259 @@ out:
 }
 
 
+bool
+unify_index_pattern(Procedure proc, term_t value)
+{ GET_LD
+  Definition def = getProcDefinition__LD(proc->definition PASS_LD);
+
+  return unify_indexes(def, value, INDEX_PATTERN PASS_LD);
+}
+
+
+		 /*******************************
+		 *	    INDEX HINTS		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Index hints describe the primary hash indexes  that the JIT indexer has
+created for a predicate as a list of terms
+
+    hash(Args, Buckets, Speedup, IsList)
+
+where Args is a list of  1-based   argument  positions. They are used to
+carry the indexes learned  by  a  process   over  to  .qlf  files, saved
+states and other processes, such that the  index is created immediately
+after loading rather than on the first call that needs it.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+get_hint_procedure(term_t pi, Definition *defp ARG_LD)
+{ Procedure proc;
+  Definition def;
+
+  if ( !get_procedure(pi, &proc, 0, GP_FINDHERE|GP_NAMEARITY) )
+    return FALSE;
+  def = getProcDefinition__LD(proc->definition PASS_LD);
+  if ( true(def, P_FOREIGN) )
+    return FALSE;
+
+  *defp = def;
+  return TRUE;
+}
+
+
+static int
+unify_index_hint(term_t t, ClauseIndex ci ARG_LD)
+{ term_t args = PL_new_term_ref();
+  term_t tmp  = PL_new_term_ref();
+  int i;
+
+  if ( !args || !tmp )
+    return FALSE;
+
+  PL_put_nil(args);
+  for(i=MAX_MULTI_INDEX-1; i>= 0; i--)
+  { if ( ci->args[i] )
+    { if ( !PL_put_integer(tmp, ci->args[i]) ||
+	   !PL_cons_list(args, tmp, args) )
+	return FALSE;
+    }
+  }
+
+  return PL_unify_term(t,
+		       PL_FUNCTOR, FUNCTOR_hash4,
+			 PL_TERM, args,
+			 PL_INT, (int)ci->buckets,
+			 PL_DOUBLE, (double)ci->speedup,
+			 PL_BOOL, ci->is_list);
+}
+
+
+static int
+get_index_hint(term_t t, Definition def, hash_hints *hints ARG_LD)
+{ term_t tail = PL_new_term_ref();
+  term_t head = PL_new_term_ref();
+  term_t a    = PL_new_term_ref();
+  size_t arity = def->functor->arity;
+  int64_t buckets;
+  double speedup;
+  int is_list;
+  int n = 0;
+
+  memset(hints, 0, sizeof(*hints));
+  if ( !PL_is_functor(t, FUNCTOR_hash4) )
+    return PL_type_error("index_hint", t);
+
+  _PL_get_arg(1, t, tail);
+  while( PL_get_list_ex(tail, head, tail) )
+  { int i;
+
+    if ( !PL_get_integer_ex(head, &i) )
+      return FALSE;
+    if ( i < 1 || (size_t)i > arity || i > MAXINDEXARG )
+      return PL_domain_error("argument_position", head);
+    if ( n == MAX_MULTI_INDEX )
+      return PL_domain_error("index_hint", t);
+    hints->args[n++] = (iarg_t)i;
+  }
+  if ( !PL_get_nil_ex(tail) )
+    return FALSE;
+  if ( n == 0 )
+    return PL_domain_error("index_hint", t);
+
+  _PL_get_arg(2, t, a);
+  if ( !PL_get_int64_ex(a, &buckets) )
+    return FALSE;
+  if ( buckets < 2 || buckets > (1<<24) )
+    return PL_domain_error("index_buckets", a);
+  while( (int64_t)2<<hints->ln_buckets < buckets )
+    hints->ln_buckets++;
+
+  _PL_get_arg(3, t, a);
+  if ( !PL_get_float_ex(a, &speedup) )
+    return FALSE;
+  hints->speedup = (float)speedup;
+
+  _PL_get_arg(4, t, a);
+  if ( !PL_get_bool_ex(a, &is_list) )
+    return FALSE;
+  hints->list = is_list;
+
+  return TRUE;
+}
+
+
+/** '$index_hints'(:PI, -Hints) is semidet.
+ *
+ * Hints is a list of hash(Args, Buckets, Speedup, IsList) terms that
+ * describe the primary indexes that currently exist for PI.
+ */
+
+static
+PRED_IMPL("$index_hints", 2, index_hints, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Definition def;
+  ClauseIndex *cip;
+  term_t tail = PL_copy_term_ref(A2);
+  term_t head = PL_new_term_ref();
+  int rc = TRUE;
+
+  if ( !get_hint_procedure(A1, &def PASS_LD) )
+    return FALSE;
+
+  acquire_def(def);
+  if ( (cip=def->impl.clauses.clause_indexes) )
+  { for(; *cip; cip++)
+    { ClauseIndex ci = *cip;
+
+      if ( ISDEADCI(ci) )
+	continue;
+      if ( !PL_unify_list(tail, head, tail) ||
+	   !unify_index_hint(head, ci PASS_LD) )
+      { rc = FALSE;
+	break;
+      }
+    }
+  }
+  release_def(def);
+
+  return rc && PL_unify_nil(tail);
+}
+
+
+/** '$set_index_hints'(:PI, +Hints) is det.
+ *
+ * Create the primary indexes described by Hints for PI.  Hints for
+ * indexes that already exist are ignored, as are all hints if PI has
+ * no clauses.  Large indexes may be filled in the background (see
+ * the flag `index_async_threshold`).
+ */
+
+static
+PRED_IMPL("$set_index_hints", 2, set_index_hints, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Definition def;
+  term_t tail = PL_copy_term_ref(A2);
+  term_t head = PL_new_term_ref();
+
+  if ( !get_hint_procedure(A1, &def PASS_LD) )
+    return PL_existence_error("procedure", A1);
+
+  while( PL_get_list_ex(tail, head, tail) )
+  { hash_hints hints;
+    index_context ctx;
+
+    if ( !get_index_hint(head, def, &hints PASS_LD) )
+      return FALSE;
+
+    acquire_def(def);
+    if ( def->impl.clauses.number_of_clauses > 0 )
+    { ctx.generation  = global_generation();
+      ctx.predicate   = def;
+      ctx.chp         = NULL;
+      ctx.depth       = 0;
+      ctx.position[0] = END_INDEX_POS;
+
+      hashDefinition(&def->impl.clauses, &hints, &ctx);
+    }
+    release_def(def);
+  }
+
+  return PL_get_nil_ex(tail);
+}
+
+
+		 /*******************************
+		 *	 INDEX STATISTICS	*
+		 *******************************/
+
+/** '$index_statistics'(:PI, -Stats) is semidet.
+ *
+ * Stats is a list Indexed-index_stats(Lookups, Hits, Scanned,
+ * ChoicePoints) for each index of PI, where Indexed is the same as
+ * for predicate_property/2 `indexed`.  This only reads the counters
+ * and is cheap enough for polling.
+ */
+
+static
+PRED_IMPL("$index_statistics", 2, index_statistics, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Definition def;
+
+  if ( !get_hint_procedure(A1, &def PASS_LD) )
+    return FALSE;
+
+  return unify_indexes(def, A2, INDEX_STATS PASS_LD);
+}
+
+
+/** '$index_buckets'(:PI, -Histograms) is semidet.
+ *
+ * Histograms is a list Indexed-Histogram for each index of PI,
+ * where Histogram is a list Length-Count, telling how many buckets
+ * hold a chain of Length clause references.  Buckets that are not in
+ * the list are unused.  This scans all buckets of all indexes.
+ */
+
+static
+PRED_IMPL("$index_buckets", 2, index_buckets, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Definition def;
+
+  if ( !get_hint_procedure(A1, &def PASS_LD) )
+    return FALSE;
+
+  return unify_indexes(def, A2, INDEX_BUCKETS PASS_LD);
+}
+
+
 		 /*******************************
 		 *      PUBLISH PREDICATES	*
 		 *******************************/
 
 BeginPredDefs(index)
+  PRED_DEF("$index_hints",	2, index_hints,	     PL_FA_TRANSPARENT)
+  PRED_DEF("$set_index_hints",	2, set_index_hints,  PL_FA_TRANSPARENT)
+  PRED_DEF("$index_statistics", 2, index_statistics, PL_FA_TRANSPARENT)
+  PRED_DEF("$index_buckets",	2, index_buckets,    PL_FA_TRANSPARENT)
 EndPredDefs
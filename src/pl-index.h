@@ -38,11 +38,24 @@
 #ifndef _PL_INDEX_H
 #define _PL_INDEX_H
 
+/* A queued or running job of the index builder.  The job references
+   def from queueIndexJob() until the index is completed or aborted.
+   See predicates_in_use() and indexJobPredicate().
+*/
+
+typedef struct index_job
+{ struct index_job *next;		/* Next in queue */
+  Definition	def;			/* Predicate we index */
+  ClauseList	clist;			/* Clause list we index */
+  ClauseIndex	ci;			/* The (incomplete) index */
+} index_job;
+
 		 /*******************************
 		 *    FUNCTION DECLARATIONS	*
 		 *******************************/
 
 word		getIndexOfTerm(term_t t);
+word		getIndexOfWord(word w ARG_LD);
 ClauseRef	firstClause(Word argv, LocalFrame fr, Definition def,
 			    ClauseChoice next ARG_LD);
 ClauseRef	nextClause__LD(ClauseChoice chp, Word argv, LocalFrame fr,
@@ -59,10 +72,19 @@ void		deleteActiveClauseFromIndexes(Definition def, Clause cl);
 bool		unify_index_pattern(Procedure proc, term_t value);
 void		deleteIndexes(ClauseList cl, int isnew);
 void		deleteIndexesDefinition(Definition def);
+void		invalidateClauseKeys(Definition def);
+void		addClauseKeys(Definition def, ClauseRef cref);
+void		freeClauseKeys(Definition def);
+int		setKeyFilterDefinition(Definition def, int val);
+void		freeKeyFilter(Definition def);
+int		unify_key_filter(Definition def, term_t t);
 int		checkClauseIndexSizes(Definition def, int nindexable);
 void		checkClauseIndexes(Definition def);
 void		listIndexGenerations(Definition def, gen_t gen);
 size_t		sizeofClauseIndexes(Definition def);
+void		runIndexJobs(void);
+void		abortIndexJobs(void);
+int		indexJobPredicate(Definition def);
 
 		 /*******************************
 		 *	LD-USING FUNCTIONS	*
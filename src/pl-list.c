@@ -40,6 +40,8 @@
 #include "pl-gc.h"
 #include "pl-wam.h"
 #include "pl-fli.h"
+#include "pl-rsort.h"
+#include "pl-setup.h"
 
 #undef LD
 #define LD LOCAL_LD
@@ -217,7 +219,9 @@ typedef struct
 
 					/* TBD: handle CMP_ERROR */
 #ifndef COMPARE_KEY
-#define COMPARE_KEY(x,y) compareStandard((x)->key, (y)->key, FALSE PASS_LD)
+#define COMPARE_KEY(x,y) \
+	( shared ? compareAcyclic((x)->key, (y)->key, FALSE PASS_LD) \
+		 : compareStandard((x)->key, (y)->key, FALSE PASS_LD) )
 #endif
 #ifndef FREE
 #define FREE(x) \
@@ -241,9 +245,8 @@ struct List_Record {
 
 
 static list
-nat_sort(list data, int remove_dups, sort_order order)
-{ GET_LD
-  list stack[64];			/* enough for biggest machine */
+nat_sort(list data, int remove_dups, sort_order order, int shared ARG_LD)
+{ list stack[64];			/* enough for biggest machine */
   list *sp = stack;
   int runs = 0;				/* total number of runs processed */
   list p, q, r, s;
@@ -347,6 +350,476 @@ nat_sort(list data, int remove_dups, sort_order order)
 }
 
 
+#ifdef O_PLMT
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Parallel sort.  If the list has  at   least  `sort_parallel_threshold`
+elements, the flag `cpu_count` is more  than   one  and  all keys can be
+compared concurrently (see canCompareConcurrently()), the list is split
+into one block per CPU.  The blocks  are   sorted  by nat_sort() and
+subsequently merged pairwise until a single list remains.
+
+Each round of sorting or merging is   a  batch of jobs. The calling thread
+queues the batch for a pool of sort workers and runs unclaimed jobs of its
+batch itself, so the sort completes even  if   no  worker can be created.
+Workers are created on demand, up to MAX_SORT_THREADS-1, and wait for the
+next batch when done. Each worker has  its   own  local  data that only
+holds what compareAcyclic() needs  to  read   the  caller's  stacks: the
+stack base addresses and the boolean  flags.   The  caller's LD is never
+accessed by a worker.
+
+Merging resolves ties in favour of the   earlier block and drops the
+later of two equal elements if   duplicates  are removed. The result is
+thus identical to the result of the sequential nat_sort(), including the
+stability of msort/2 and which element of a set of equal keys is kept.
+
+The calling thread waits for its batch  to complete. It does not execute
+Prolog code, so its stacks cannot move.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define MAX_SORT_THREADS	64
+#define MIN_SORT_BLOCK		1024	/* Do not split below this size */
+
+typedef struct sort_job
+{ list		p;			/* (second) input list and result */
+  list		q;			/* first input list when merging */
+  int		remove_dups;		/* Remove duplicates */
+  sort_order	order;			/* Sort order */
+} sort_job;
+
+typedef struct sort_batch
+{ sort_job     *jobs;			/* Jobs of this batch */
+  int		njobs;			/* # jobs */
+  int		next;			/* First unclaimed job */
+  int		pending;		/* # jobs not completed */
+  uintptr_t	bases[STG_MASK+1];	/* Stack bases of the caller */
+  pl_features_t	flags;			/* Boolean flags of the caller */
+  struct sort_batch *next_batch;	/* Next batch with unclaimed jobs */
+} sort_batch;
+
+static struct
+{ pthread_mutex_t mutex;
+  pthread_cond_t  work;			/* Signal workers */
+  pthread_cond_t  done;			/* Signal waiting callers */
+  sort_batch     *batches;		/* Batches with unclaimed jobs */
+  int		  workers;		/* # pool threads */
+  int		  idle;			/* # workers waiting for a batch */
+} sort_pool =
+{ PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  NULL, 0, 0
+};
+
+
+static list
+merge_runs(list q, list p, int remove_dups, sort_order order ARG_LD)
+{ struct List_Record header;
+  list r = &header;
+  list s;
+  int shared = TRUE;
+
+  remove_dups = !remove_dups;		/* 0 -> do, 1 -> don't */
+  while (q && p)
+  { /* q precedes p */
+    compare(c, q, p);
+
+    if (c <= 0)
+    { r->next = q, r = q, q = q->next;
+      if (c == remove_dups)
+      { s = p->next;
+	FREE(p);
+	p = s;
+      }
+    } else
+    { r->next = p, r = p, p = p->next;
+    }
+  }
+  r->next = q ? q : p;
+
+  return header.next;
+}
+
+
+static void
+run_sort_job(sort_job *job ARG_LD)
+{ if ( job->q )
+    job->p = merge_runs(job->q, job->p, job->remove_dups, job->order PASS_LD);
+  else
+    job->p = nat_sort(job->p, job->remove_dups, job->order, TRUE PASS_LD);
+}
+
+
+/* Claim the next job of `b`.  Must be called with sort_pool.mutex
+   held and b->next < b->njobs.  A batch leaves the queue when its
+   last job is claimed.
+*/
+
+static sort_job *
+claim_sort_job(sort_batch *b)
+{ sort_job *job = &b->jobs[b->next++];
+
+  if ( b->next == b->njobs )
+  { sort_batch **bp;
+
+    for(bp = &sort_pool.batches; *bp; bp = &(*bp)->next_batch)
+    { if ( *bp == b )
+      { *bp = b->next_batch;
+	break;
+      }
+    }
+  }
+
+  return job;
+}
+
+
+static void *
+sort_worker(void *closure)
+{ PL_local_data_t *ld = closure;
+
+#ifdef HAVE_SIGPROCMASK
+  sigset_t set;
+  allSignalMask(&set);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+  pthread_mutex_lock(&sort_pool.mutex);
+  for(;;)
+  { sort_batch *b;
+    sort_job *job;
+
+    while ( !(b=sort_pool.batches) )
+    { sort_pool.idle++;
+      pthread_cond_wait(&sort_pool.work, &sort_pool.mutex);
+      sort_pool.idle--;
+    }
+    job = claim_sort_job(b);
+    memcpy(ld->bases, b->bases, sizeof(ld->bases));
+    ld->prolog_flag.mask = b->flags;
+    pthread_mutex_unlock(&sort_pool.mutex);
+
+    run_sort_job(job, ld);
+
+    pthread_mutex_lock(&sort_pool.mutex);
+    if ( --b->pending == 0 )		/* b may be gone after unlock */
+      pthread_cond_broadcast(&sort_pool.done);
+  }
+
+  return NULL;
+}
+
+
+/* Start a new pool worker.  Must be called with sort_pool.mutex held.
+*/
+
+static int
+start_sort_worker(void)
+{ PL_local_data_t *ld;
+  pthread_attr_t attr;
+  pthread_t tid;
+  int rc;
+
+  if ( !(ld = malloc(sizeof(*ld))) )
+    return FALSE;
+  memset(ld, 0, sizeof(*ld));
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  rc = pthread_create(&tid, &attr, sort_worker, ld);
+  pthread_attr_destroy(&attr);
+  if ( rc != 0 )
+  { free(ld);
+    return FALSE;
+  }
+  sort_pool.workers++;
+
+  return TRUE;
+}
+
+
+static void
+run_sort_jobs(sort_job *jobs, int njobs ARG_LD)
+{ sort_batch b;
+  sort_batch **bp;
+  int need;
+
+  b.jobs       = jobs;
+  b.njobs      = njobs;
+  b.next       = 0;
+  b.pending    = njobs;
+  b.next_batch = NULL;
+  memcpy(b.bases, LD->bases, sizeof(b.bases));
+  b.flags      = LD->prolog_flag.mask;
+
+  pthread_mutex_lock(&sort_pool.mutex);
+  for(bp = &sort_pool.batches; *bp; bp = &(*bp)->next_batch)
+    ;
+  *bp = &b;
+  for(need = njobs-1-sort_pool.idle;
+      need > 0 && sort_pool.workers < MAX_SORT_THREADS-1;
+      need--)
+  { if ( !start_sort_worker() )
+      break;
+  }
+  pthread_cond_broadcast(&sort_pool.work);
+
+  while ( b.next < b.njobs )
+  { sort_job *job = claim_sort_job(&b);
+
+    pthread_mutex_unlock(&sort_pool.mutex);
+    run_sort_job(job PASS_LD);
+    pthread_mutex_lock(&sort_pool.mutex);
+    b.pending--;
+  }
+  while ( b.pending > 0 )
+    pthread_cond_wait(&sort_pool.done, &sort_pool.mutex);
+  pthread_mutex_unlock(&sort_pool.mutex);
+}
+
+
+/* Return the number of blocks to use for sorting the `len` elements
+   starting at `data` or 0 if we must sort sequentially.
+*/
+
+static int
+parallel_sort_blocks(list data, size_t len ARG_LD)
+{ size_t threshold = GD->thread.sort.threshold;
+  int64_t cpus;
+  size_t i;
+
+  if ( threshold == 0 || len < threshold || len < 2*MIN_SORT_BLOCK ||
+       !PL_current_prolog_flag(ATOM_cpu_count, PL_INTEGER, &cpus) ||
+       cpus < 2 )
+    return 0;
+
+  for(i=0; i<len; i++)
+  { if ( !canCompareConcurrently(data[i].item.key PASS_LD) )
+      return 0;
+  }
+
+  if ( cpus > MAX_SORT_THREADS )
+    cpus = MAX_SORT_THREADS;
+  if ( (size_t)cpus > len/MIN_SORT_BLOCK )
+    cpus = len/MIN_SORT_BLOCK;
+
+  return (int)cpus;
+}
+
+
+static list
+par_nat_sort(list data, size_t len, int nblocks,
+	     int remove_dups, sort_order order ARG_LD)
+{ sort_job jobs[MAX_SORT_THREADS];
+  int i;
+
+  for(i=0; i<nblocks; i++)
+  { size_t from = len*i/nblocks;
+    size_t to   = len*(i+1)/nblocks;
+
+    data[to-1].next     = NIL;
+    jobs[i].p           = &data[from];
+    jobs[i].q           = NIL;
+    jobs[i].remove_dups = remove_dups;
+    jobs[i].order       = order;
+  }
+  run_sort_jobs(jobs, nblocks PASS_LD);
+
+  while( nblocks > 1 )
+  { int merges = nblocks/2;
+
+    for(i=0; i<merges; i++)
+    { jobs[i].q           = jobs[2*i].p;
+      jobs[i].p           = jobs[2*i+1].p;
+      jobs[i].remove_dups = remove_dups;
+      jobs[i].order       = order;
+    }
+    run_sort_jobs(jobs, merges PASS_LD);
+    if ( nblocks%2 )			/* odd block passes to next round */
+    { jobs[merges].p = jobs[nblocks-1].p;
+      nblocks = merges+1;
+    } else
+    { nblocks = merges;
+    }
+  }
+
+  return jobs[0].p;
+}
+
+#endif /*O_PLMT*/
+
+
+		 /*******************************
+		 *	  RADIX SORT KEYS	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+If all keys are tagged integers or all keys are text atoms we map each key
+to an unsigned 64-bit integer that preserves the standard order of terms
+and sort the records using radix_sort().   Integers are mapped by flipping
+the sign bit.  For atoms we collect the distinct atoms in a hash table, sort
+these by text and use the rank as key,  so each distinct atom is compared
+only O(log D) times.  Both keys are exact:  equal keys imply equal terms,
+so duplicates can be removed by comparing keys.
+
+Returns FALSE if the keys are not homogeneous or we cannot allocate the
+required memory, in which case the caller uses nat_sort().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define RADIX_SORT_MIN 64		/* Minimal length to try radix sort */
+
+typedef struct atom_rank
+{ word		atom;			/* The atom (0: empty slot) */
+  uint64_t	rank;			/* Rank in standard order */
+} atom_rank;
+
+static int
+compare_atom_ranks(const void *a1, const void *a2, void *arg)
+{ const atom_rank *r1 = *(const atom_rank**)a1;
+  const atom_rank *r2 = *(const atom_rank**)a2;
+  (void)arg;
+
+  return compareAtoms(r1->atom, r2->atom);
+}
+
+
+static int
+is_text_atom(word w)
+{ if ( isAtom(w) )
+  { PL_blob_t *type = atomValue(w)->type;
+
+    return true(type, PL_BLOB_TEXT) && !type->compare;
+  }
+
+  return FALSE;
+}
+
+
+static int
+rank_atoms(radix_item *items, size_t len)
+{ size_t size = 64, count = 0, i;
+  atom_rank *table, **sorted;
+  uint64_t rank;
+
+  while(size < 2*len)			/* at most half full */
+    size *= 2;
+  if ( !(table = calloc(size, sizeof(*table))) )
+    return FALSE;
+
+  for(i=0; i<len; i++)
+  { word a = (word)items[i].key;
+    size_t k = MurmurHashAligned2(&a, sizeof(a), MURMUR_SEED) & (size-1);
+
+    for(;;)
+    { if ( table[k].atom == a )
+	break;
+      if ( !table[k].atom )
+      { table[k].atom = a;
+	count++;
+	break;
+      }
+      if ( ++k == size )
+	k = 0;
+    }
+    items[i].key = k;			/* slot of the atom */
+  }
+
+  if ( !(sorted = malloc(count*sizeof(*sorted))) )
+  { free(table);
+    return FALSE;
+  }
+  for(i=0, count=0; i<size; i++)
+  { if ( table[i].atom )
+      sorted[count++] = &table[i];
+  }
+  sort_r(sorted, count, sizeof(*sorted), compare_atom_ranks, NULL);
+  for(i=0, rank=0; i<count; i++)
+  { if ( i > 0 &&
+	 compareAtoms(sorted[i-1]->atom, sorted[i]->atom) != CMP_EQUAL )
+      rank++;
+    sorted[i]->rank = rank;
+  }
+  free(sorted);
+
+  for(i=0; i<len; i++)
+    items[i].key = table[items[i].key].rank;
+  free(table);
+
+  return TRUE;
+}
+
+
+static int
+radix_sort_list(list data, size_t len, int remove_dups, sort_order order,
+		list *result)
+{ radix_item *items;
+  list l;
+  size_t i;
+  int ints;
+  int sorted = TRUE;
+
+  if ( len < RADIX_SORT_MIN )
+    return FALSE;
+
+  if ( isTaggedInt(*data->item.key) )
+    ints = TRUE;
+  else if ( is_text_atom(*data->item.key) )
+    ints = FALSE;
+  else
+    return FALSE;
+
+  for(i=0, l=data; i<len; i++, l++)
+  { word k = *l->item.key;
+
+    if ( ints ? !isTaggedInt(k) : !is_text_atom(k) )
+      return FALSE;
+  }
+
+  if ( !(items = malloc(len*sizeof(*items))) )
+    return FALSE;
+
+  for(i=0, l=data; i<len; i++, l++)
+  { word k = *l->item.key;
+
+    items[i].key = ints ? (uint64_t)valInt(k) ^ ((uint64_t)1<<63) : k;
+    items[i].value = l;
+  }
+  if ( !ints && !rank_atoms(items, len) )
+  { free(items);
+    return FALSE;
+  }
+
+  for(i=0; i<len; i++)
+  { if ( order == SORT_DESC )
+      items[i].key = ~items[i].key;
+    if ( i > 0 && items[i].key < items[i-1].key )
+      sorted = FALSE;
+  }
+
+  if ( !sorted && !radix_sort(items, len) )
+  { free(items);
+    return FALSE;
+  }
+
+  l = items[0].value;
+  *result = l;
+  for(i=1; i<len; i++)
+  { list n = items[i].value;
+
+    if ( remove_dups && items[i].key == items[i-1].key )
+    { FREE(n);
+    } else
+    { l->next = n;
+      l = n;
+    }
+  }
+  l->next = NIL;
+  free(items);
+
+  return TRUE;
+}
+
+
 static Word
 extract_key(Word p1, int argc, const word *argv, int pair ARG_LD)
 { if ( pair )
@@ -534,7 +1007,19 @@ pl_nat_sort(term_t in, term_t out,
     case SORT_SORT:
     default:
     { term_t tmp = PL_new_term_ref();
-      l = nat_sort(l, remove_dups, order);
+      size_t len = (list)top - l;
+#ifdef O_PLMT
+      int nblocks;
+#endif
+
+      if ( radix_sort_list(l, len, remove_dups, order, &l) )
+	;
+#ifdef O_PLMT
+      else if ( (nblocks=parallel_sort_blocks(l, len PASS_LD)) > 1 )
+	l = par_nat_sort(l, len, nblocks, remove_dups, order PASS_LD);
+      else
+#endif
+	l = nat_sort(l, remove_dups, order, FALSE PASS_LD);
       put_sort_list(tmp, l);
       gTop = top;
 
@@ -321,6 +321,7 @@ unallocModule(Module m)
 
   if ( m->public )     destroyHTable(m->public);
   if ( m->procedures ) destroyHTable(m->procedures);
+  procedureResolutionChanged();
   if ( m->operators )  destroyHTable(m->operators);
   if ( m->supers )     unallocList(m->supers);
 #ifdef O_PLMT
@@ -408,6 +409,7 @@ static void
 emptyModule(Module m)
 { DEBUG(MSG_CLEANUP, Sdprintf("emptyModule(%s)\n", PL_atom_chars(m->name)));
   if ( m->procedures ) clearHTable(m->procedures);
+  procedureResolutionChanged();
 }
 
 
@@ -533,6 +535,7 @@ addSuperModule_no_lock(Module m, Module s, int where)
   }
 
   updateLevelModule(m);
+  procedureResolutionChanged();
   succeed;
 }
 
@@ -561,6 +564,7 @@ delSuperModule(Module m, Module s)
       freeHeap(c, sizeof(*c));
 
       updateLevelModule(m);
+      procedureResolutionChanged();
       succeed;
     }
   }
@@ -581,6 +585,7 @@ clearSupersModule_no_lock(Module m)
   }
 
   m->level = 0;
+  procedureResolutionChanged();
 }
 
 void
@@ -600,6 +605,7 @@ setSuperModule(Module m, Module s)
   { if ( (Module)m->supers->value != s )
     { m->supers->value = s;
       m->level = s->level+1;
+      procedureResolutionChanged();
 
       succeed;
     }
@@ -1726,6 +1732,8 @@ retry:
     old = addHTable(destination->procedures,
 		    (void *)proc->definition->functor->functor, nproc);
     UNLOCKMODULE(destination);
+    if ( old == nproc )
+      procedureResolutionChanged();
     if ( old != nproc )
     { int shared = unshareDefinition(proc->definition);
       assert(shared > 0);
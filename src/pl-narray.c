@@ -0,0 +1,1149 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pl-incl.h"
+#include "pl-narray.h"
+#include "pl-arith.h"
+#include "pl-fli.h"
+#include "pl-prims.h"
+#include "pl-gc.h"
+#include <math.h>
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Packed numeric arrays (narrays) are blobs that hold a contiguous array of
+int64_t or double elements.  They avoid the cons cell and (for floats)
+the boxed value that a Prolog list needs per element and allow the map
+and reduce operations below to run as tight loops over the array.
+
+The blob is a non-unique PL_BLOB_NOCOPY blob: the atom points  to  the
+malloc()ed narray struct, which is freed  if   the  atom  is garbage
+collected.  Being an atom, an  narray  is   passed  by  reference when
+recorded, sent to a message queue or copied by findall/3. The external
+record format (fast_term_serialized/2, fast_write/2) stores the raw array
+preceded by the element type and byte order.  See narrayImage().
+
+The kernels are written such that  the   C  compiler can vectorise them:
+no function calls and no data dependent branches in the inner loops.
+Float reductions use multiple partial sums, which implies the result may
+differ in the last bits from a left-to-right sum of the same values.
+Integer reductions are exact.  Integer elementwise operations raise an
+evaluation error if a result does not fit in 64 bits.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define NA_INT64	0
+#define NA_FLOAT	1
+
+#define NA_LITTLE_ENDIAN 'L'
+#define NA_BIG_ENDIAN	 'B'
+#ifdef WORDS_BIGENDIAN
+#define NA_BYTE_ORDER	NA_BIG_ENDIAN
+#else
+#define NA_BYTE_ORDER	NA_LITTLE_ENDIAN
+#endif
+
+#define NA_SUM_CHUNK	((size_t)1<<30)	/* See sum_int64() */
+
+typedef union
+{ int64_t	i;
+  double	f;
+} na_cell;
+
+typedef struct narray
+{ size_t	length;			/* # elements */
+  unsigned int	type;			/* NA_INT64 or NA_FLOAT */
+  unsigned int	padding;		/* align data */
+  na_cell	data[];			/* the elements */
+} narray;
+
+typedef enum
+{ NA_ADD = 0,
+  NA_SUB,
+  NA_MUL,
+  NA_DIV,
+  NA_MIN,
+  NA_MAX
+} na_op;
+
+
+		 /*******************************
+		 *	       BLOB		*
+		 *******************************/
+
+static atom_t
+type_name(const narray *na)
+{ return na->type == NA_FLOAT ? ATOM_float : ATOM_int64;
+}
+
+
+static int
+release_narray(atom_t a)
+{ narray *na = PL_blob_data(a, NULL, NULL);
+
+  free(na);
+
+  return TRUE;
+}
+
+
+static int
+write_narray(IOSTREAM *s, atom_t a, int flags)
+{ narray *na = PL_blob_data(a, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<narray>(%s,%" PRId64 ")",
+	   stringAtom(type_name(na)), (int64_t)na->length);
+  return TRUE;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Standard order of narrays: by type and then lexicographically on the
+elements, where a prefix sorts before the longer narray.  As the
+blob is not unique, two distinct narrays may have the same content.  We
+compare the atom handles as a last resort such that compare/3 only returns
+= for the same narray, consistent with ==/2.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+compare_narray(atom_t a, atom_t b)
+{ const narray *na = PL_blob_data(a, NULL, NULL);
+  const narray *nb = PL_blob_data(b, NULL, NULL);
+  size_t k, len;
+
+  if ( na->type != nb->type )
+    return na->type < nb->type ? CMP_LESS : CMP_GREATER;
+
+  len = na->length < nb->length ? na->length : nb->length;
+  if ( na->type == NA_INT64 )
+  { for(k=0; k<len; k++)
+    { if ( na->data[k].i != nb->data[k].i )
+	return na->data[k].i < nb->data[k].i ? CMP_LESS : CMP_GREATER;
+    }
+  } else
+  { for(k=0; k<len; k++)
+    { if ( na->data[k].f < nb->data[k].f )
+	return CMP_LESS;
+      if ( na->data[k].f > nb->data[k].f )
+	return CMP_GREATER;
+    }
+  }
+
+  if ( na->length != nb->length )
+    return na->length < nb->length ? CMP_LESS : CMP_GREATER;
+
+  return a < b ? CMP_LESS : a == b ? CMP_EQUAL : CMP_GREATER;
+}
+
+
+static void
+swap_cells(na_cell *p, size_t n)
+{ size_t k;
+
+  for(k=0; k<n; k++)
+  { unsigned char *b = (unsigned char *)&p[k];
+    int i;
+
+    for(i=0; i<4; i++)
+    { unsigned char c = b[i];
+
+      b[i] = b[7-i];
+      b[7-i] = c;
+    }
+  }
+}
+
+
+static narray *
+alloc_narray(unsigned int type, size_t len)
+{ narray *na;
+
+  if ( len > (SIZE_MAX-sizeof(*na))/sizeof(na_cell) ||
+       !(na = malloc(sizeof(*na)+len*sizeof(na_cell))) )
+  { PL_no_memory();
+    return NULL;
+  }
+  na->length  = len;
+  na->type    = type;
+  na->padding = 0;
+
+  return na;
+}
+
+
+static int save_narray(atom_t a, IOSTREAM *fd);
+static atom_t load_narray(IOSTREAM *fd);
+
+static PL_blob_t narray_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_NOCOPY,
+  "narray",
+  release_narray,
+  compare_narray,
+  write_narray,
+  NULL,
+  save_narray,
+  load_narray
+};
+
+
+static atom_t
+narray_atom(narray *na)
+{ int new;
+
+  return lookupBlob((const char *)na, sizeof(*na), &narray_blob, &new);
+}
+
+
+static int
+unify_narray(term_t t, narray *na)
+{ GET_LD
+  atom_t a = narray_atom(na);
+  int rc = PL_unify_atom(t, a);
+
+  PL_unregister_atom(a);
+
+  return rc;
+}
+
+
+static int
+get_narray(term_t t, narray **nap)
+{ PL_blob_t *type;
+  void *data;
+
+  *nap = NULL;
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &narray_blob )
+  { *nap = data;
+    return TRUE;
+  }
+
+  return PL_type_error("narray", t);
+}
+
+
+void
+initNArray(void)
+{ PL_register_blob_type(&narray_blob);	/* needed to load .qlf files */
+}
+
+
+int
+isNArrayAtom(atom_t a)
+{ return atomValue(a)->type == &narray_blob;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The  image  of  an  narray  used  for  external  records  and  saved
+states is a two byte header holding the  element type and byte order,
+followed by the elements.  The loader swaps the bytes if the image was
+created on a machine with a different byte order.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+const void *
+narrayImage(atom_t a, char hdr[NARRAY_IMAGE_HDR], size_t *bytes)
+{ narray *na = PL_blob_data(a, NULL, NULL);
+
+  hdr[0] = (char)na->type;
+  hdr[1] = NA_BYTE_ORDER;
+  *bytes = na->length*sizeof(na_cell);
+
+  return na->data;
+}
+
+
+static narray *
+narray_from_image(const char hdr[NARRAY_IMAGE_HDR],
+		  const void *data, size_t len)
+{ narray *na;
+  unsigned int type = (hdr[0] == NA_FLOAT ? NA_FLOAT : NA_INT64);
+
+  if ( (na=alloc_narray(type, len)) )
+  { memcpy(na->data, data, len*sizeof(na_cell));
+    if ( hdr[1] != NA_BYTE_ORDER )
+      swap_cells(na->data, len);
+  }
+
+  return na;
+}
+
+
+atom_t
+narrayFromImage(const char *image, size_t len)
+{ narray *na;
+
+  if ( len < NARRAY_IMAGE_HDR )
+    len = NARRAY_IMAGE_HDR;
+  if ( (na=narray_from_image(image, image+NARRAY_IMAGE_HDR,
+			     (len-NARRAY_IMAGE_HDR)/sizeof(na_cell))) )
+    return narray_atom(na);
+
+  return 0;
+}
+
+
+static int
+save_narray(atom_t a, IOSTREAM *fd)
+{ char hdr[NARRAY_IMAGE_HDR];
+  size_t bytes;
+  const void *data = narrayImage(a, hdr, &bytes);
+  uint64_t len = bytes/sizeof(na_cell);
+  int i;
+
+  Sputc(hdr[0], fd);
+  Sputc(hdr[1], fd);
+  for(i=0; i<8; i++)
+    Sputc((int)((len>>(i*8))&0xff), fd);
+
+  return Sfwrite(data, 1, bytes, fd) == bytes;
+}
+
+
+static atom_t
+load_narray(IOSTREAM *fd)
+{ char hdr[NARRAY_IMAGE_HDR];
+  uint64_t len = 0;
+  narray *na;
+  int i;
+
+  hdr[0] = (char)Sgetc(fd);
+  hdr[1] = (char)Sgetc(fd);
+  for(i=0; i<8; i++)
+    len |= (uint64_t)(Sgetc(fd)&0xff) << (i*8);
+
+  if ( (na=alloc_narray(hdr[0] == NA_FLOAT ? NA_FLOAT : NA_INT64,
+			(size_t)len)) )
+  { if ( Sfread(na->data, sizeof(na_cell), na->length, fd) != na->length )
+    { free(na);
+      return 0;
+    }
+    if ( hdr[1] != NA_BYTE_ORDER )
+      swap_cells(na->data, na->length);
+
+    return narray_atom(na);
+  }
+
+  return 0;
+}
+
+
+		 /*******************************
+		 *	    CONVERSION		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+list_type() determines the element type  for   a  list  without a type
+specification:  int64  if all elements are  integers and float if some
+element is a float.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static unsigned int
+list_type(term_t list ARG_LD)
+{ Word l = valTermRef(list);
+
+  deRef(l);
+  while ( isList(*l) )
+  { Word h = HeadList(l);
+
+    deRef(h);
+    if ( isFloat(*h) )
+      return NA_FLOAT;
+    l = TailList(l);
+    deRef(l);
+  }
+
+  return NA_INT64;
+}
+
+
+static int
+get_element(Word h, unsigned int type, na_cell *c ARG_LD)
+{ int rc;
+  term_t t;
+
+  if ( type == NA_INT64 )
+  { if ( isTaggedInt(*h) )
+    { c->i = valInt(*h);
+      return TRUE;
+    }
+    t = pushWordAsTermRef(h);
+    rc = ( PL_is_integer(t) ? PL_get_int64_ex(t, &c->i)
+			    : PL_type_error("integer", t) );
+  } else
+  { if ( isFloat(*h) )
+    { c->f = valFloat(*h);
+      return TRUE;
+    } else if ( isTaggedInt(*h) )
+    { c->f = (double)valInt(*h);
+      return TRUE;
+    }
+    t = pushWordAsTermRef(h);
+    rc = PL_get_float_ex(t, &c->f);
+  }
+  popTermRef();
+
+  return rc;
+}
+
+
+static int
+list_to_narray(term_t list, term_t type, term_t array ARG_LD)
+{ intptr_t len;
+  unsigned int t;
+  narray *na;
+  Word l;
+  size_t k;
+
+  if ( PL_is_variable(type) )
+  { t = list_type(list PASS_LD);
+    if ( !PL_unify_atom(type, t == NA_FLOAT ? ATOM_float : ATOM_int64) )
+      return FALSE;
+  } else
+  { atom_t name;
+
+    if ( !PL_get_atom_ex(type, &name) )
+      return FALSE;
+    if ( name == ATOM_int64 )
+      t = NA_INT64;
+    else if ( name == ATOM_float )
+      t = NA_FLOAT;
+    else
+      return PL_domain_error("narray_type", type);
+  }
+
+  if ( (len=lengthList(list, TRUE)) < 0 ||
+       !(na=alloc_narray(t, len)) )
+    return FALSE;
+
+  l = valTermRef(list);
+  deRef(l);
+  for(k=0; k<na->length; k++)
+  { Word h = HeadList(l);
+
+    deRef(h);
+    if ( !get_element(h, t, &na->data[k] PASS_LD) )
+    { free(na);
+      return FALSE;
+    }
+    l = TailList(l);
+    deRef(l);
+  }
+
+  return unify_narray(array, na);
+}
+
+
+static int
+unify_narray_list(term_t t, const narray *na ARG_LD)
+{ size_t n = na->length;
+  size_t k, cells = 3*n;
+  term_t l;
+  Word a;
+  int rc;
+
+  if ( n == 0 )
+    return PL_unify_nil(t);
+
+  if ( na->type == NA_FLOAT )
+  { cells += n*(2+WORDS_PER_DOUBLE);
+  } else
+  { for(k=0; k<n; k++)
+    { if ( na->data[k].i < PLMINTAGGEDINT || na->data[k].i > PLMAXTAGGEDINT )
+	cells += 2+WORDS_PER_INT64;
+    }
+  }
+
+  if ( !(l=PL_new_term_ref()) )
+    return FALSE;
+  if ( !hasGlobalSpace(cells) &&
+       (rc=ensureGlobalSpace(cells, ALLOW_GC)) != TRUE )
+    return raiseStackOverflow(rc);
+
+  a = gTop;
+  gTop += 3*n;
+  *valTermRef(l) = consPtr(a, TAG_COMPOUND|STG_GLOBAL);
+  for(k=0; k<n; k++, a += 3)
+  { a[0] = FUNCTOR_dot2;
+    if ( na->type == NA_FLOAT )
+      put_double(&a[1], na->data[k].f, ALLOW_CHECKED PASS_LD);
+    else
+      put_int64(&a[1], na->data[k].i, ALLOW_CHECKED PASS_LD);
+    a[2] = ( k+1 < n ? consPtr(&a[3], TAG_COMPOUND|STG_GLOBAL)
+		     : ATOM_nil );
+  }
+
+  return PL_unify(t, l);
+}
+
+
+static int
+unify_cell(term_t t, const narray *na, const na_cell *c)
+{ GET_LD
+  if ( na->type == NA_FLOAT )
+    return PL_unify_float(t, c->f);
+  else
+    return PL_unify_int64(t, c->i);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+float_cells() returns the elements of na as doubles.  If na is an int64
+array the elements are converted into a new array, returned in *tmp and
+to be freed by the caller.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static const na_cell *
+float_cells(const narray *na, na_cell **tmp)
+{ na_cell *c;
+  size_t k;
+
+  *tmp = NULL;
+  if ( na->type == NA_FLOAT )
+    return na->data;
+
+  if ( !(c = malloc(na->length*sizeof(*c) + 1)) )
+  { PL_no_memory();
+    return NULL;
+  }
+  for(k=0; k<na->length; k++)
+    c[k].f = (double)na->data[k].i;
+
+  return (*tmp = c);
+}
+
+
+		 /*******************************
+		 *	      KERNELS		*
+		 *******************************/
+
+static int
+add_number(Number acc, Number n)
+{ number r;
+  int rc;
+
+  if ( (rc=pl_ar_add(acc, n, &r)) )
+  { clearNumber(acc);
+    *acc = r;
+  }
+  clearNumber(n);
+
+  return rc;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+sum_int64() sums the high and low 32 bits   of the elements in separate
+accumulators.  Neither can overflow for up   to NA_SUM_CHUNK elements,
+so the inner loop needs no overflow test.  The chunk results are added
+using normal arithmetic, which promotes to unbounded integers as needed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+sum_int64(const na_cell *p, size_t n, Number r)
+{ r->type = V_INTEGER;
+  r->value.i = 0;
+
+  while ( n > 0 )
+  { size_t k, chunk = (n > NA_SUM_CHUNK ? NA_SUM_CHUNK : n);
+    int64_t hi = 0;
+    uint64_t lo = 0;
+    number h, s, l;
+
+    for(k=0; k<chunk; k++)
+    { lo += (uint32_t)p[k].i;
+      hi += p[k].i >> 32;
+    }
+
+    h.type = V_INTEGER;
+    h.value.i = hi;
+    s.type = V_INTEGER;
+    s.value.i = (int64_t)1<<32;
+    if ( !ar_mul(&h, &s, &l) )
+      return FALSE;
+    clearNumber(&h);
+    clearNumber(&s);
+    if ( !add_number(r, &l) )
+      return FALSE;
+    l.type = V_INTEGER;
+    l.value.i = (int64_t)lo;
+    if ( !add_number(r, &l) )
+      return FALSE;
+
+    p += chunk;
+    n -= chunk;
+  }
+
+  return TRUE;
+}
+
+
+static double
+sum_float(const na_cell *p, size_t n)
+{ double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  size_t k;
+
+  for(k=0; k+4 <= n; k += 4)
+  { s0 += p[k].f;
+    s1 += p[k+1].f;
+    s2 += p[k+2].f;
+    s3 += p[k+3].f;
+  }
+  for(; k<n; k++)
+    s0 += p[k].f;
+
+  return (s0+s1)+(s2+s3);
+}
+
+
+static double
+dot_float(const na_cell *a, const na_cell *b, size_t n)
+{ double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  size_t k;
+
+  for(k=0; k+4 <= n; k += 4)
+  { s0 += a[k].f*b[k].f;
+    s1 += a[k+1].f*b[k+1].f;
+    s2 += a[k+2].f*b[k+2].f;
+    s3 += a[k+3].f*b[k+3].f;
+  }
+  for(; k<n; k++)
+    s0 += a[k].f*b[k].f;
+
+  return (s0+s1)+(s2+s3);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+dot_int64() accumulates in an int64_t and switches to normal arithmetic
+for a product or partial sum that does not fit.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+dot_int64(const na_cell *a, const na_cell *b, size_t n, Number r)
+{ int64_t s = 0;
+  number t;
+  size_t k;
+
+  r->type = V_INTEGER;
+  r->value.i = 0;
+
+  for(k=0; k<n; k++)
+  { int64_t p, s1;
+
+    if ( mul64(a[k].i, b[k].i, &p) )
+    { s1 = (int64_t)((uint64_t)s+(uint64_t)p);
+      if ( ((s^s1)&(p^s1)) >= 0 )
+      { s = s1;
+	continue;
+      }
+    }
+
+    { number x, y, xy;
+
+      x.type = V_INTEGER;
+      x.value.i = a[k].i;
+      y.type = V_INTEGER;
+      y.value.i = b[k].i;
+      if ( !ar_mul(&x, &y, &xy) )
+	return FALSE;
+      clearNumber(&x);
+      clearNumber(&y);
+      if ( !add_number(r, &xy) )
+	return FALSE;
+    }
+  }
+
+  t.type = V_INTEGER;
+  t.value.i = s;
+
+  return add_number(r, &t);
+}
+
+
+#define NA_MINMAX(field, cmp) \
+	do \
+	{ size_t k; \
+	  for(k=1; k<n; k++) \
+	  { if ( p[k].field cmp m.field ) \
+	      m.field = p[k].field; \
+	  } \
+	} while(0)
+
+static na_cell
+min_max(const narray *na, int max)
+{ const na_cell *p = na->data;
+  size_t n = na->length;
+  na_cell m = p[0];
+
+  if ( na->type == NA_FLOAT )
+  { if ( max )
+      NA_MINMAX(f, >);
+    else
+      NA_MINMAX(f, <);
+  } else
+  { if ( max )
+      NA_MINMAX(i, >);
+    else
+      NA_MINMAX(i, <);
+  }
+
+  return m;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Elementwise operations.  If b is NULL the scalar y is used as right hand
+operand.  The integer versions collect overflow  information in ovf and
+only test it after the loop.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define NA_MAP(field, expr) \
+	do \
+	{ if ( b ) \
+	  { for(k=0; k<n; k++) \
+	    { x = a[k].field; y = b[k].field; \
+	      r[k].field = (expr); \
+	    } \
+	  } else \
+	  { for(k=0; k<n; k++) \
+	    { x = a[k].field; \
+	      r[k].field = (expr); \
+	    } \
+	  } \
+	} while(0)
+
+#define NA_MAP_OVF(expr, ovfexpr) \
+	do \
+	{ if ( b ) \
+	  { for(k=0; k<n; k++) \
+	    { x = a[k].i; y = b[k].i; \
+	      z = (expr); ovf |= (ovfexpr); r[k].i = z; \
+	    } \
+	  } else \
+	  { for(k=0; k<n; k++) \
+	    { x = a[k].i; \
+	      z = (expr); ovf |= (ovfexpr); r[k].i = z; \
+	    } \
+	  } \
+	} while(0)
+
+static void
+map_float(na_op op, na_cell *r, const na_cell *a, const na_cell *b,
+	  double y, size_t n)
+{ double x;
+  size_t k;
+
+  switch(op)
+  { case NA_ADD: NA_MAP(f, x+y); break;
+    case NA_SUB: NA_MAP(f, x-y); break;
+    case NA_MUL: NA_MAP(f, x*y); break;
+    case NA_DIV: NA_MAP(f, x/y); break;
+    case NA_MIN: NA_MAP(f, x < y ? x : y); break;
+    case NA_MAX: NA_MAP(f, x > y ? x : y); break;
+  }
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+check_float_cells() applies the float_overflow, float_zero_div, etc. flags
+to the result of map_float() the same way is/2 does.  The map loop itself
+stays free of branches; we only scan the result for non-normal values and
+hand these to check_float(), which either accepts them or raises the error.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+check_float_cells(na_op op, na_cell *r, const na_cell *a,
+		  const na_cell *b, double y, size_t n ARG_LD)
+{ size_t k;
+
+  for(k=0; k<n; k++)
+  { double f = r[k].f;
+
+    if ( !isnormal(f) && f != 0.0 )
+    { number v;
+
+      if ( op == NA_DIV )
+      { double x = a[k].f;
+
+	if ( b )
+	  y = b[k].f;
+	if ( y == 0.0 && !isnan(x) && x != 0.0 )
+	{ if ( LD->arith.f.flags & FLT_ZERO_DIV )
+	    continue;
+	  return PL_error("/", 2, NULL, ERR_DIV_BY_ZERO);
+	}
+      }
+
+      v.type = V_FLOAT;
+      v.value.f = f;
+      if ( !check_float(&v) )
+	return FALSE;
+      r[k].f = v.value.f;
+    }
+  }
+
+  return TRUE;
+}
+
+
+static int
+map_int64(na_op op, na_cell *r, const na_cell *a, const na_cell *b,
+	  int64_t y, size_t n)
+{ int64_t x, z, ovf = 0;
+  size_t k;
+
+  switch(op)
+  { case NA_ADD:
+      NA_MAP_OVF((int64_t)((uint64_t)x+(uint64_t)y), (x^z)&(y^z));
+      break;
+    case NA_SUB:
+      NA_MAP_OVF((int64_t)((uint64_t)x-(uint64_t)y), (x^y)&(x^z));
+      break;
+    case NA_MUL:
+      for(k=0; k<n; k++)
+      { if ( b )
+	  y = b[k].i;
+	if ( !mul64(a[k].i, y, &r[k].i) )
+	  ovf = -1;
+      }
+      break;
+    case NA_MIN: NA_MAP(i, x < y ? x : y); break;
+    case NA_MAX: NA_MAP(i, x > y ? x : y); break;
+    case NA_DIV: assert(0);
+  }
+
+  return ovf >= 0;
+}
+
+
+		 /*******************************
+		 *	   PREDICATES		*
+		 *******************************/
+
+/** list_narray(+List, ?Type, -NArray)
+*/
+
+static
+PRED_IMPL("list_narray", 3, list_narray, 0)
+{ PRED_LD
+
+  return list_to_narray(A1, A2, A3 PASS_LD);
+}
+
+
+static
+PRED_IMPL("list_narray", 2, list_narray, 0)
+{ PRED_LD
+  term_t type = PL_new_term_ref();
+
+  return type && list_to_narray(A1, type, A2 PASS_LD);
+}
+
+
+static
+PRED_IMPL("narray_list", 2, narray_list, 0)
+{ PRED_LD
+  narray *na;
+
+  return ( get_narray(A1, &na) &&
+	   unify_narray_list(A2, na PASS_LD) );
+}
+
+
+static
+PRED_IMPL("is_narray", 1, is_narray, 0)
+{ PL_blob_t *type;
+
+  return PL_is_blob(A1, &type) && type == &narray_blob;
+}
+
+
+static
+PRED_IMPL("narray_length", 2, narray_length, 0)
+{ PRED_LD
+  narray *na;
+
+  return ( get_narray(A1, &na) &&
+	   PL_unify_int64(A2, na->length) );
+}
+
+
+static
+PRED_IMPL("narray_type", 2, narray_type, 0)
+{ PRED_LD
+  narray *na;
+
+  return ( get_narray(A1, &na) &&
+	   PL_unify_atom(A2, type_name(na)) );
+}
+
+
+/** narray_nth0(+Index, +NArray, -Elem)
+*/
+
+static
+PRED_IMPL("narray_nth0", 3, narray_nth0, 0)
+{ narray *na;
+  int64_t i;
+
+  if ( get_narray(A2, &na) &&
+       PL_get_int64_ex(A1, &i) )
+  { if ( i >= 0 && (uint64_t)i < na->length )
+      return unify_cell(A3, na, &na->data[i]);
+  }
+
+  return FALSE;
+}
+
+
+/** narray_slice(+NArray, +Start, +Length, -Slice)
+*/
+
+static
+PRED_IMPL("narray_slice", 4, narray_slice, 0)
+{ PRED_LD
+  narray *na, *s;
+  size_t start, len;
+
+  if ( get_narray(A1, &na) &&
+       PL_get_size_ex(A2, &start) &&
+       PL_get_size_ex(A3, &len) )
+  { if ( start > na->length || len > na->length-start )
+      return FALSE;
+    if ( !(s=alloc_narray(na->type, len)) )
+      return FALSE;
+    memcpy(s->data, &na->data[start], len*sizeof(na_cell));
+
+    return unify_narray(A4, s);
+  }
+
+  return FALSE;
+}
+
+
+static
+PRED_IMPL("narray_sum", 2, narray_sum, 0)
+{ PRED_LD
+  narray *na;
+
+  if ( !get_narray(A1, &na) )
+    return FALSE;
+
+  if ( na->type == NA_FLOAT )
+  { return PL_unify_float(A2, sum_float(na->data, na->length));
+  } else
+  { number n;
+    int rc;
+
+    rc = ( sum_int64(na->data, na->length, &n) &&
+	   PL_unify_number(A2, &n) );
+    clearNumber(&n);
+
+    return rc;
+  }
+}
+
+
+static
+PRED_IMPL("narray_dot", 3, narray_dot, 0)
+{ PRED_LD
+  narray *a, *b;
+
+  if ( !get_narray(A1, &a) || !get_narray(A2, &b) )
+    return FALSE;
+  if ( a->length != b->length )
+    return PL_domain_error("narray_length", A2);
+
+  if ( a->type == NA_INT64 && b->type == NA_INT64 )
+  { number n;
+    int rc;
+
+    rc = ( dot_int64(a->data, b->data, a->length, &n) &&
+	   PL_unify_number(A3, &n) );
+    clearNumber(&n);
+
+    return rc;
+  } else
+  { na_cell *ta, *tb = NULL;
+    const na_cell *fa, *fb;
+    int rc = FALSE;
+
+    if ( (fa=float_cells(a, &ta)) &&
+	 (fb=float_cells(b, &tb)) )
+      rc = PL_unify_float(A3, dot_float(fa, fb, a->length));
+    if ( ta ) free(ta);
+    if ( tb ) free(tb);
+
+    return rc;
+  }
+}
+
+
+static int
+narray_min_max(term_t array, term_t value, int max)
+{ narray *na;
+
+  if ( get_narray(array, &na) && na->length > 0 )
+  { na_cell m = min_max(na, max);
+
+    return unify_cell(value, na, &m);
+  }
+
+  return FALSE;
+}
+
+
+static
+PRED_IMPL("narray_min", 2, narray_min, 0)
+{ return narray_min_max(A1, A2, FALSE);
+}
+
+
+static
+PRED_IMPL("narray_max", 2, narray_max, 0)
+{ return narray_min_max(A1, A2, TRUE);
+}
+
+
+static int
+get_na_op(term_t t, na_op *op)
+{ GET_LD
+  atom_t name;
+
+  *op = NA_ADD;
+  if ( !PL_get_atom_ex(t, &name) )
+    return FALSE;
+
+  if ( name == ATOM_plus )
+    *op = NA_ADD;
+  else if ( name == ATOM_minus )
+    *op = NA_SUB;
+  else if ( name == ATOM_star )
+    *op = NA_MUL;
+  else if ( name == ATOM_divide )
+    *op = NA_DIV;
+  else if ( name == ATOM_min )
+    *op = NA_MIN;
+  else if ( name == ATOM_max )
+    *op = NA_MAX;
+  else
+    return PL_domain_error("narray_operator", t);
+
+  return TRUE;
+}
+
+
+/** narray_map(+Op, +NArray1, +NArray2OrNumber, -NArray)
+*/
+
+static
+PRED_IMPL("narray_map", 4, narray_map, 0)
+{ PRED_LD
+  na_op op;
+  narray *a, *b = NULL, *r;
+  na_cell y;
+  unsigned int btype, rtype;
+  int rc = FALSE;
+
+  if ( !get_na_op(A1, &op) || !get_narray(A2, &a) )
+    return FALSE;
+
+  if ( PL_is_integer(A3) )
+  { if ( !PL_get_int64_ex(A3, &y.i) )
+      return FALSE;
+    btype = NA_INT64;
+  } else if ( PL_is_float(A3) )
+  { if ( !PL_get_float(A3, &y.f) )
+      return FALSE;
+    btype = NA_FLOAT;
+  } else
+  { if ( !get_narray(A3, &b) )
+      return FALSE;
+    if ( b->length != a->length )
+      return PL_domain_error("narray_length", A3);
+    btype = b->type;
+  }
+
+  rtype = ( a->type == NA_INT64 && btype == NA_INT64 && op != NA_DIV
+	    ? NA_INT64 : NA_FLOAT );
+  if ( !(r=alloc_narray(rtype, a->length)) )
+    return FALSE;
+
+  if ( rtype == NA_INT64 )
+  { if ( map_int64(op, r->data, a->data, b ? b->data : NULL,
+		   y.i, a->length) )
+      rc = TRUE;
+    else
+      rc = PL_error(NULL, 0, NULL, ERR_EVALUATION, ATOM_int_overflow);
+  } else
+  { na_cell *ta, *tb = NULL;
+    const na_cell *fa, *fb = NULL;
+
+    if ( !b && btype == NA_INT64 )
+      y.f = (double)y.i;
+    if ( (fa=float_cells(a, &ta)) &&
+	 (!b || (fb=float_cells(b, &tb))) )
+    { map_float(op, r->data, fa, fb, y.f, a->length);
+      rc = check_float_cells(op, r->data, fa, fb, y.f, a->length PASS_LD);
+    }
+    if ( ta ) free(ta);
+    if ( tb ) free(tb);
+  }
+
+  if ( rc )
+    return unify_narray(A4, r);
+
+  free(r);
+  return FALSE;
+}
+
+
+		 /*******************************
+		 *      PUBLISH PREDICATES	*
+		 *******************************/
+
+BeginPredDefs(narray)
+  PRED_DEF("list_narray",   3, list_narray,   0)
+  PRED_DEF("list_narray",   2, list_narray,   0)
+  PRED_DEF("narray_list",   2, narray_list,   0)
+  PRED_DEF("is_narray",     1, is_narray,     0)
+  PRED_DEF("narray_length", 2, narray_length, 0)
+  PRED_DEF("narray_type",   2, narray_type,   0)
+  PRED_DEF("narray_nth0",   3, narray_nth0,   0)
+  PRED_DEF("narray_slice",  4, narray_slice,  0)
+  PRED_DEF("narray_sum",    2, narray_sum,    0)
+  PRED_DEF("narray_dot",    3, narray_dot,    0)
+  PRED_DEF("narray_min",    2, narray_min,    0)
+  PRED_DEF("narray_max",    2, narray_max,    0)
+  PRED_DEF("narray_map",    4, narray_map,    0)
+EndPredDefs
@@ -1817,7 +1817,8 @@ compare_functors(word f1, word f2, int eq)
 }
 
 static int
-do_compare(term_agendaLR *agenda, Functor f1, Functor f2, int eq ARG_LD)
+do_compare(term_agendaLR *agenda, Functor f1, Functor f2, int eq,
+	   int cyclic ARG_LD)
 { Word p1, p2;
 
   goto compound;
@@ -1853,7 +1854,8 @@ do_compare(term_agendaLR *agenda, Functor f1, Functor f2, int eq ARG_LD)
       compound:
 	arity = arityFunctor(f1->definition);
 
-	linkTermsCyclic(f1, f2 PASS_LD);
+	if ( cyclic )
+	  linkTermsCyclic(f1, f2 PASS_LD);
 	if ( !pushWorkAgendaLR(agenda, arity, f1->arguments, f2->arguments) )
 	{ PL_error(NULL, 0, NULL, ERR_RESOURCE, ATOM_memory);
 	  return CMP_ERROR;
@@ -1867,8 +1869,8 @@ do_compare(term_agendaLR *agenda, Functor f1, Functor f2, int eq ARG_LD)
 }
 
 
-int
-compareStandard(Word p1, Word p2, int eq ARG_LD)
+static int
+compare_standard(Word p1, Word p2, int eq, int cyclic ARG_LD)
 { int rc;
 
   deRef(p1);
@@ -1885,11 +1887,13 @@ compareStandard(Word p1, Word p2, int eq ARG_LD)
     } else
     { term_agendaLR agenda;
 
-      initCyclic(PASS_LD1);
+      if ( cyclic )
+	initCyclic(PASS_LD1);
       initTermAgendaLR0(&agenda);
-      rc = do_compare(&agenda, f1, f2, eq PASS_LD);
+      rc = do_compare(&agenda, f1, f2, eq, cyclic PASS_LD);
       clearTermAgendaLR(&agenda);
-      exitCyclic(PASS_LD1);
+      if ( cyclic )
+	exitCyclic(PASS_LD1);
 
       return rc;
     }
@@ -1897,6 +1901,74 @@ compareStandard(Word p1, Word p2, int eq ARG_LD)
 }
 
 
+int
+compareStandard(Word p1, Word p2, int eq ARG_LD)
+{ return compare_standard(p1, p2, eq, TRUE PASS_LD);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+compareAcyclic() is compareStandard() for   terms that are known to be
+acyclic.  Unlike compareStandard() it does   not  temporarily link the
+compound terms it compares and thus   leaves  the terms untouched. If
+canCompareConcurrently() is true for  both   terms,  multiple threads may
+compare them concurrently, passing the LD  of   the  thread that owns the
+stack.  This is used by the parallel sort in pl-list.c.
+
+canCompareConcurrently() requires the term  to   be  acyclic and all
+atomic sub-terms to be comparable without  using thread-local data that
+is not passed as LD, allocating memory  or   calling  a blob compare()
+function.  This excludes indirect integers (see get_rational()) and
+blobs with a compare function.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+int
+compareAcyclic(Word p1, Word p2, int eq ARG_LD)
+{ return compare_standard(p1, p2, eq, FALSE PASS_LD);
+}
+
+
+static int
+can_compare_concurrently(word w)
+{ switch(tag(w))
+  { case TAG_INTEGER:
+      return isTaggedInt(w);
+    case TAG_ATOM:
+      return !atomValue(w)->type->compare;
+    default:
+      return TRUE;
+  }
+}
+
+
+int
+canCompareConcurrently(Word p ARG_LD)
+{ term_agenda agenda;
+  int rc = TRUE;
+
+  deRef(p);
+  if ( !isTerm(*p) )
+    return can_compare_concurrently(*p);
+  if ( is_acyclic(p PASS_LD) != TRUE )
+    return FALSE;
+
+  initTermAgenda(&agenda, 1, p);
+  while( rc && (p=nextTermAgenda(&agenda)) )
+  { if ( isTerm(*p) )
+    { Functor f = valueTerm(*p);
+
+      if ( !pushWorkAgenda(&agenda, arityFunctor(f->definition), f->arguments) )
+	rc = FALSE;
+    } else
+    { rc = can_compare_concurrently(*p);
+    }
+  }
+  clearTermAgenda(&agenda);
+
+  return rc;
+}
+
+
 /* compare(-Diff, +T1, +T2) */
 
 static
@@ -5594,6 +5666,10 @@ swi_statistics__LD(atom_t key, Number v, PL_local_data_t *ld)
     v->value.f = GD->statistics.user_cputime;
   } else if (key == ATOM_inferences)			/* inferences */
     v->value.i = LD->statistics.inferences;
+  else if (key == ATOM_call_cache_hits)
+    v->value.i = LD->call_cache.hits;
+  else if (key == ATOM_call_cache_misses)
+    v->value.i = LD->call_cache.misses;
   else if (key == ATOM_stack)
     v->value.i = GD->statistics.stack_space;
   else if (key == ATOM_stack_limit)
@@ -5708,6 +5784,12 @@ swi_statistics__LD(atom_t key, Number v, PL_local_data_t *ld)
     v->value.i = GD->statistics.indexes.created;
   else if (key == ATOM_indexes_destroyed)
     v->value.i = GD->statistics.indexes.destroyed;
+  else if (key == ATOM_indexes_built_async)
+    v->value.i = GD->statistics.indexes.built_async;
+  else if (key == ATOM_indexes_build_time)
+  { v->type = V_FLOAT;
+    v->value.f = GD->statistics.indexes.build_time;
+  }
   else if (key == ATOM_warnings)
     v->value.i = GD->statistics.warnings;
   else if (key == ATOM_errors)
@@ -5732,6 +5814,11 @@ pl_statistics_ld(term_t k, term_t value, PL_local_data_t *ld ARG_LD)
   if ( !PL_get_atom_ex(k, &key) )
     fail;
 
+#ifdef O_ALLOC_CACHE
+  if ( key == ATOM_heap_cache )
+    return unify_alloc_cache_statistics(value, ld);
+#endif
+
   if ( !PL_is_list(value) )
   { switch(swi_statistics__LD(key, &result, ld))
     { case TRUE:
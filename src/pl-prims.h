@@ -47,6 +47,8 @@ int		unify_ptrs(Word t1, Word t2, int flags ARG_LD);
 void		unify_vp(Word vp, Word val ARG_LD);
 bool		can_unify(Word t1, Word t2, term_t ex);
 int		compareStandard(Word t1, Word t2, int eq ARG_LD);
+int		compareAcyclic(Word t1, Word t2, int eq ARG_LD);
+int		canCompareConcurrently(Word p ARG_LD);
 int		compareAtoms(atom_t a1, atom_t a2);
 intptr_t	skip_list(Word l, Word *tailp ARG_LD);
 intptr_t	lengthList(term_t list, int errors);
@@ -41,6 +41,8 @@
 #include "pl-event.h"
 #include "pl-tabling.h"
 #include "pl-transaction.h"
+#include "pl-columnar.h"
+#include "pl-shard.h"
 #include "pl-util.h"
 #include "pl-supervisor.h"
 #include "pl-index.h"
@@ -126,7 +128,8 @@ lookupProcedure(functor_t f, Module m)
   ATOMIC_ADD(&m->code_size, SIZEOF_PROC);
 
   if ( (oproc=addHTable(m->procedures, (void *)f, proc)) == proc )
-  { return proc;
+  { procedureResolutionChanged();
+    return proc;
   } else
   { unallocProcedure(proc);
     return oproc;
@@ -188,19 +191,16 @@ destroyDefinition(Definition def)
   freeCodesDefinition(def, FALSE);
 
   if ( false(def, P_FOREIGN|P_THREAD_LOCAL) )	/* normal Prolog predicate */
-  { GET_LD
-
-    deleteIndexesDefinition(def);
-    removeClausesPredicate(def, 0, FALSE);
-    registerDirtyDefinition(def PASS_LD);
+  { if ( isShardedDefinition(def) )
+      freeShardInfo(def);
+    eraseDefinition(def);
     DEBUG(MSG_PROC_COUNT, Sdprintf("Erased %s\n", predicateName(def)));
-    def->module = NULL;
-    set(def, P_ERASED);
 
     return;
   } else					/* foreign and thread-local */
   { DEBUG(MSG_PROC_COUNT, Sdprintf("Unalloc foreign/thread-local: %s\n",
 				   predicateName(def)));
+    freeColumnarDefinition(def);
 #ifdef O_PLMT
     if ( true(def, P_THREAD_LOCAL) )
       destroyLocalDefinitions(def);
@@ -215,6 +215,23 @@ destroyDefinition(Definition def)
 }
 
 
+/* eraseDefinition() removes the clauses of a Prolog predicate that is no
+   longer reachable and leaves reclaiming def to clause-GC.  See
+   maybeUnregisterDirtyDefinition().
+*/
+
+void
+eraseDefinition(Definition def)
+{ GET_LD
+
+  deleteIndexesDefinition(def);
+  removeClausesPredicate(def, 0, FALSE);
+  registerDirtyDefinition(def PASS_LD);
+  def->module = NULL;
+  set(def, P_ERASED);
+}
+
+
 void
 unallocProcedure(Procedure proc)
 { Definition def = proc->definition;
@@ -267,6 +284,7 @@ importDefinitionModule(Module m, Definition def, int flags)
     proc->flags      = flags;
     proc->source_no  = 0;
     addNewHTable(m->procedures, (void *)functor, proc);
+    procedureResolutionChanged();
   }
   UNLOCKMODULE(m);
 
@@ -789,7 +807,7 @@ typedef struct
 } cur_enum;
 
 
-static int
+int
 isDefinedOrAutoloadProcedure(Procedure proc)
 { Definition def = proc->definition;
 
@@ -1310,6 +1328,7 @@ assertDefinition(Definition def, Clause clause, ClauseRef where ARG_LD)
     }
     assert(cr);
   }
+  addClauseKeys(def, cref);
 
   def->impl.clauses.number_of_clauses++;
   if ( false(clause, UNIT_CLAUSE) )
@@ -1368,6 +1387,124 @@ assertProcedure(Procedure proc, Clause clause, ClauseRef where ARG_LD)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+assertDefinitionBulk() appends count clauses to the end of def as a single
+update.  All clauses are linked  under  one   LOCKDEF()  and  become
+visible at the same generation.  The  new   generation  is  only stored in
+GD->_generation after all clauses are stamped,   so  a concurrent reader
+sees either none or all of them. If the batch is at least as large as the predicate,
+the existing clause indexes are dropped first: updating them clause by
+clause would trigger repeated resizes, while the JIT indexer rebuilds them
+at the right size on the next call.
+
+Transactions and predicates with update  events   need  per-clause
+generations and callbacks; for these we simply call assertDefinition().
+
+Returns the number of clauses added.   On error, the clauses that were
+not added are freed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+size_t
+assertDefinitionBulk(Definition def, Clause *clauses, size_t count ARG_LD)
+{ ClauseRef *crefs;
+  gen_t gen;
+  size_t i;
+
+  if ( count == 0 )
+    return 0;
+
+  if ( LD->transaction.generation || def->events || count == 1 )
+  { for(i=0; i<count; i++)
+    { if ( !assertDefinition(def, clauses[i], CL_END PASS_LD) )
+      { size_t done = i;
+
+	for(i++; i<count; i++)
+	  freeClause(clauses[i]);
+	return done;
+      }
+    }
+    return count;
+  }
+
+  if ( !(crefs = malloc(count*sizeof(*crefs))) )
+  { PL_no_memory();
+    goto error;
+  }
+
+  for(i=0; i<count; i++)
+  { Clause clause = clauses[i];
+    word key;
+
+    if ( !add_ssu_clause(def, clause) )
+      goto error;
+    argKey(clause->codes, 0, &key);
+    if ( !(crefs[i]=newClauseRef(clause, key)) )
+    { PL_no_memory();
+      goto error;
+    }
+    clause->generation.created = max_generation(def PASS_LD);
+    clause->generation.erased  = 1;
+  }
+
+  LOCKDEF(def);
+  acquire_def(def);
+  if ( count >= def->impl.clauses.number_of_clauses )
+  { deleteIndexesDefinition(def);
+    clearTriedIndexes(def);
+  }
+  for(i=0; i<count; i++)
+  { Clause clause = clauses[i];
+    ClauseRef cref = crefs[i];
+
+    if ( !def->impl.clauses.last_clause )
+    { def->impl.clauses.first_clause = def->impl.clauses.last_clause = cref;
+    } else
+    { def->impl.clauses.last_clause->next = cref;
+      def->impl.clauses.last_clause = cref;
+    }
+    def->impl.clauses.number_of_clauses++;
+    if ( false(clause, UNIT_CLAUSE) )
+      def->impl.clauses.number_of_rules++;
+    addClauseToIndexes(def, clause, CL_END);
+    addClauseKeys(def, cref);
+  }
+  if ( true(def, P_DIRTYREG) )
+    ATOMIC_ADD(&GD->clauses.dirty, count);
+  if ( false(def, P_DYNAMIC|P_LOCKED_SUPERVISOR) )
+    freeCodesDefinition(def, TRUE);
+  release_def(def);
+  DEBUG(CHK_SECURE, checkDefinition(def));
+  UNLOCKDEF(def);
+  free(crefs);
+
+  PL_LOCK(L_GENERATION);		/* stamp all, then publish gen */
+  gen = global_generation()+1;
+  for(i=0; i<count; i++)
+  { clauses[i]->generation.erased  = max_generation(def PASS_LD);
+    clauses[i]->generation.created = gen;
+  }
+  MEMORY_BARRIER();
+  GD->_generation = gen;
+  PL_UNLOCK(L_GENERATION);
+
+  setLastModifiedPredicate(def, gen, TWF_ASSERT);
+
+  return count;
+
+error:
+  if ( crefs )
+  { size_t n = i;
+
+    for(i=0; i<n; i++)
+      freeClauseRef(crefs[i]);
+    free(crefs);
+  }
+  for(i=0; i<count; i++)
+    freeClause(clauses[i]);
+  return 0;
+}
+
+
 /*  Abolish a procedure.  Referenced  clauses  are   unlinked  and left
     dangling in the dark until the procedure referencing it deletes it.
 
@@ -1398,14 +1535,17 @@ abolishProcedure(Procedure proc, Module module)
     ATOMIC_ADD(&module->code_size, sizeof(*ndef));
     resetProcedure(proc, TRUE);
   } else if ( true(def, P_FOREIGN) )	/* foreign: make normal */
-  { def->impl.clauses.first_clause = def->impl.clauses.last_clause = NULL;
+  { freeColumnarDefinition(def);
+    def->impl.clauses.first_clause = def->impl.clauses.last_clause = NULL;
     resetProcedure(proc, TRUE);
   } else if ( true(def, P_THREAD_LOCAL) )
   { UNLOCKDEF(def);
     return PL_error(NULL, 0, NULL, ERR_PERMISSION_PROC,
 		    ATOM_modify, ATOM_thread_local_procedure, proc);
   } else				/* normal Prolog procedure */
-  { removeClausesPredicate(def, 0, FALSE);
+  { if ( isShardedDefinition(def) )
+      freeShardInfo(def);
+    removeClausesPredicate(def, 0, FALSE);
     setDynamicDefinition_unlocked(def, FALSE);
     resetProcedure(proc, FALSE);
   }
@@ -1720,6 +1860,7 @@ cleanDefinition(Definition def, DirtyDefInfo ddi, gen_t start, Buffer tr_starts,
 	}
 	removed++;
 	def->impl.clauses.erased_clauses--;
+	invalidateClauseKeys(def);
 	UNLOCKDEF(def);
 
 	lingerClauseRef(cref);
@@ -1736,7 +1877,8 @@ cleanDefinition(Definition def, DirtyDefInfo ddi, gen_t start, Buffer tr_starts,
     gen_t active = ddi_oldest_generation(ddi);
     if ( start < active )
       active = start;
-    free_lingering(&def->lingering, active);
+    if ( !indexJobPredicate(def) )	/* may access a deleted index */
+      free_lingering(&def->lingering, active);
 
     DEBUG(CHK_SECURE,
 	  LOCKDEF(def);
@@ -2492,23 +2634,37 @@ maybeUnregisterDirtyDefinition(Definition def)
   if ( true(def, P_ERASED) )
   { DEBUG(MSG_PROC_COUNT, Sdprintf("Delayed unalloc %s\n", predicateName(def)));
     assert(def->module == NULL);
-    if ( def->impl.clauses.first_clause == NULL )
+    if ( def->impl.clauses.first_clause == NULL &&
+	 !indexJobPredicate(def) )
     { DEBUG(0,
 	    if ( def->lingering )
 	    { Sdprintf("maybeUnregisterDirtyDefinition(%s): lingering data\n",
 		       predicateName(def));
 	    });
       unregisterDirtyDefinition(def);
-      deleteIndexes(&def->impl.clauses, TRUE);
-      freeHeap(def->impl.any.args, sizeof(arg_info)*def->functor->arity);
-      if ( def->tabling )
-	freeHeap(def->tabling, sizeof(*def->tabling));
-      freeHeap(def, sizeof(*def));
+      if ( isShardDefinition(def) )
+	releaseShardDefinition(def);	/* last shard frees all of them */
+      else
+	unallocDefinition(def);
     }
   }
 }
 
 
+/* unallocDefinition() frees an erased definition without clauses */
+
+void
+unallocDefinition(Definition def)
+{ deleteIndexes(&def->impl.clauses, TRUE);
+  freeClauseKeys(def);
+  freeKeyFilter(def);
+  freeHeap(def->impl.any.args, sizeof(arg_info)*def->functor->arity);
+  if ( def->tabling )
+    freeHeap(def->tabling, sizeof(*def->tabling));
+  freeHeap(def, sizeof(*def));
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 (*) We set the initial generation to   GEN_MAX  to know which predicates
 have been marked. We can only reclaim   clauses  that were erased before
@@ -2693,6 +2849,59 @@ resolveProcedure__LD(functor_t f, Module module ARG_LD)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+resolveProcedureStable() is resolveProcedure() for  the  meta-call  cache
+(see resolveCallSite() in pl-wam.c).  It sets *stable to FALSE  if  the
+result may change without calling procedureResolutionChanged().  This is
+the case if we pass a module that has  an  undefined  procedure  for  f,
+as  this  may  be  defined  later,  or  if  we  return  an  undefined
+procedure.  Otherwise the result only changes  if  procedures  are  added
+to  modules,  the  module  inheritance  changes  or  the  result  becomes
+undefined.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static Procedure
+visibleProcedureStable(functor_t f, Module m, int *stable ARG_LD)
+{ ListCell c;
+  Procedure p;
+
+  for(;;)
+  { next:
+
+    if ( (p = isCurrentProcedure(f, m)) )
+    { if ( isDefinedOrAutoloadProcedure(p) )
+	return p;
+      *stable = FALSE;
+    }
+
+    for(c=m->supers; c; c=c->next)
+    { if ( c->next )
+      { if ( (p=visibleProcedureStable(f, c->value, stable PASS_LD)) )
+	  return p;
+      } else
+      { m = c->value;
+	goto next;
+      }
+    }
+
+    return NULL;
+  }
+}
+
+
+Procedure
+resolveProcedureStable(functor_t f, Module module, int *stable ARG_LD)
+{ Procedure proc;
+
+  *stable = TRUE;
+  if ( (proc = visibleProcedureStable(f, module, stable PASS_LD)) )
+    return proc;
+
+  *stable = FALSE;
+  return lookupProcedure(f, module);
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 autoImport() tries to autoimport  f  into   module  `m'  and returns the
 definition if this is possible.
@@ -2925,6 +3134,7 @@ typedef struct
 { Definition def;
   struct clause_choice chp;
   int allocated;
+  int all_shards;			/* Walking all shards */
 } retract_context;
 
 static retract_context *
@@ -2958,7 +3168,8 @@ PRED_IMPL("retract", 1, retract,
   if ( CTX_CNTRL == FRG_CUTTED )
   { ctx = CTX_PTR;
 
-    unprotectCRef(ctx->chp.cref);
+    if ( ctx->chp.cref )
+      unprotectCRef(ctx->chp.cref);
     free_retract_context(ctx PASS_LD);
 
     return TRUE;
@@ -2995,6 +3206,7 @@ PRED_IMPL("retract", 1, retract,
     { functor_t fd;
       Procedure proc;
       Definition def;
+      int all_shards = FALSE;
 
       if ( !PL_get_functor(head, &fd) )
 	return PL_error(NULL, 0, NULL, ERR_TYPE, ATOM_callable, head);
@@ -3005,6 +3217,10 @@ PRED_IMPL("retract", 1, retract,
 
       def = getProcDefinition(proc);
 
+      if ( isColumnarDefinition(def) )
+	return PL_error(NULL, 0, "use retractall/1",
+			ERR_PERMISSION_PROC, ATOM_modify,
+			ATOM_columnar_procedure, proc);
       if ( true(def, P_FOREIGN) )
 	return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
       if ( false(def, P_DYNAMIC) )
@@ -3013,11 +3229,22 @@ PRED_IMPL("retract", 1, retract,
 	setDynamicDefinition(def, TRUE); /* implicit */
 	fail;				/* no clauses */
       }
+      if ( isShardedDefinition(def) )
+      { Definition shard = shardDefinition(def, argv PASS_LD);
+
+	if ( (all_shards = (shard == def->shards->all)) )
+	  def = firstShard(def);
+	else
+	  def = shard;
+      }
 
       enterDefinition(def);			/* reference the predicate */
       dref = pushPredicateAccessObj(def PASS_LD);
       setGenerationFrameVal(environment_frame, dref->generation);
       cref = firstClause(argv, environment_frame, def, &ctxbuf.chp PASS_LD);
+      if ( !cref && all_shards )
+	cref = nextShardClause(&def, argv, environment_frame,
+			       &ctxbuf.chp PASS_LD);
       DEBUG(MSG_CGC_RETRACT,
 	    Sdprintf("Started retract from %s at gen = %s\n",
 		     predicateName(def),
@@ -3031,14 +3258,21 @@ PRED_IMPL("retract", 1, retract,
       ctx = &ctxbuf;
       ctx->def = def;
       ctx->allocated = 0;
+      ctx->all_shards = all_shards;
     } else
     { ctx  = CTX_PTR;
       DEBUG(MSG_CGC_RETRACT,
 	    Sdprintf("Retry retract from %s at gen = %lld\n",
 		     predicateName(ctx->def),
 		     generationFrame(environment_frame)));
-      unprotectCRef(ctx->chp.cref);
-      cref = nextClause(&ctx->chp, argv, environment_frame, ctx->def);
+      if ( ctx->chp.cref )
+      { unprotectCRef(ctx->chp.cref);
+	cref = nextClause(&ctx->chp, argv, environment_frame, ctx->def);
+      } else
+	cref = NULL;
+      if ( !cref && ctx->all_shards )
+	cref = nextShardClause(&ctx->def, argv, environment_frame,
+			       &ctx->chp PASS_LD);
     }
 
     if ( !(fid = PL_open_foreign_frame()) )
@@ -3053,7 +3287,8 @@ PRED_IMPL("retract", 1, retract,
 	   decompile(clause, cl, 0) )
       { if ( retractClauseDefinition(ctx->def, clause, TRUE) ||
 	     CTX_CNTRL != FRG_FIRST_CALL )
-	{ if ( !ctx->chp.cref )		/* deterministic last one */
+	{ if ( !ctx->chp.cref &&		/* deterministic last one */
+	       !(ctx->all_shards && !isLastShard(ctx->def)) )
 	  { free_retract_context(ctx PASS_LD);
 	    PL_close_foreign_frame(fid);
 	    return TRUE;
@@ -3062,11 +3297,13 @@ PRED_IMPL("retract", 1, retract,
 	  if ( ctx == &ctxbuf )		/* non-determinisic; save state */
 	    ctx = alloc_retract_context(ctx);
 
-	  DEBUG(0,
-		assert(visibleClause(
-			   ctx->chp.cref->value.clause,
-			   generationFrame(environment_frame))));
-	  protectCRef(ctx->chp.cref);
+	  if ( ctx->chp.cref )
+	  { DEBUG(0,
+		  assert(visibleClause(
+			     ctx->chp.cref->value.clause,
+			     generationFrame(environment_frame))));
+	    protectCRef(ctx->chp.cref);
+	  }
 
 	  PL_close_foreign_frame(fid);
 	  ForeignRedoPtr(ctx);
@@ -3082,7 +3319,12 @@ PRED_IMPL("retract", 1, retract,
 	break;
 
       PL_rewind_foreign_frame(fid);
-      cref = nextClause(&ctx->chp, argv, environment_frame, ctx->def);
+      cref = ( ctx->chp.cref ? nextClause(&ctx->chp, argv, environment_frame,
+					    ctx->def)
+			     : NULL );
+      if ( !cref && ctx->all_shards )
+	cref = nextShardClause(&ctx->def, argv, environment_frame,
+			       &ctx->chp PASS_LD);
     }
 
     PL_close_foreign_frame(fid);
@@ -3117,47 +3359,25 @@ allVars(int argc, Word argv ARG_LD)
 }
 
 
-static
-PRED_IMPL("retractall", 1, retractall, PL_FA_NONDETERMINISTIC|PL_FA_ISO)
-{ GET_LD
-  term_t head = A1;
-  term_t thehead = PL_new_term_ref();
-  Procedure proc;
-  Definition def;
-  definition_ref *dref;
+/* retractall_definition() removes the clauses of def that match head.
+   It returns RETRACTALL_DONE if the last candidate clause was handled
+   deterministically.
+*/
+
+#define RETRACTALL_DONE 2
+
+static int
+retractall_definition(Definition def, term_t thehead, int allvars ARG_LD)
+{ definition_ref *dref;
   ClauseRef cref;
-  Word argv;
-  int allvars = TRUE;
+  Word argv = NULL;
   fid_t fid;
   int rc = TRUE;
 
-  if ( !get_procedure(head, &proc, thehead, GP_CREATE) )
-    fail;
-
-  def = getProcDefinition(proc);
-  if ( true(def, P_FOREIGN) )
-    return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
-  if ( false(def, P_DYNAMIC) )
-  { if ( isDefinedProcedure(proc) )
-      return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
-    if ( !setDynamicDefinition(def, TRUE) )
-      fail;
-    succeed;				/* nothing to retract */
-  }
-
-  if ( !retractall_event(def, thehead, FUNCTOR_start1 PASS_LD) )
-    return FALSE;
-
-  argv = valTermRef(thehead);
-  deRef(argv);
-  if ( isTerm(*argv) )
-  { int arity = arityTerm(*argv);
+  if ( !allvars )
+  { argv = valTermRef(thehead);
+    deRef(argv);
     argv = argTermP(*argv, 0);
-
-    allvars = allVars(arity, argv PASS_LD);
-  } else
-  { allvars = TRUE;
-    argv = NULL;
   }
 
   if ( !(dref=pushPredicateAccessObj(def PASS_LD)) )
@@ -3190,7 +3410,7 @@ PRED_IMPL("retractall", 1, retractall, PL_FA_NONDETERMINISTIC|PL_FA_ISO)
     if ( !(cref = firstClause(argv, environment_frame, def, &chp PASS_LD)) )
     { popPredicateAccess(def);
       leaveDefinition(def);
-      return TRUE;
+      return RETRACTALL_DONE;
     }
 
     while( cref )
@@ -3211,13 +3431,11 @@ PRED_IMPL("retractall", 1, retractall, PL_FA_NONDETERMINISTIC|PL_FA_ISO)
       if ( !chp.cref )
       { popPredicateAccess(def);
 	leaveDefinition(def);
-	return TRUE;
+	return RETRACTALL_DONE;
       }
 
-      if ( argv )				/* may be shifted */
-      { argv = valTermRef(thehead);
-	argv = argTermP(*argv, 0);
-      }
+      argv = valTermRef(thehead);		/* may be shifted */
+      argv = argTermP(*argv, 0);
 
       cref = nextClause(&chp, argv, environment_frame, def);
       rc = TRUE;
@@ -3230,6 +3448,73 @@ PRED_IMPL("retractall", 1, retractall, PL_FA_NONDETERMINISTIC|PL_FA_ISO)
 	checkDefinition(def);
 	UNLOCKDEF(def));
 
+  return rc;
+}
+
+
+static
+PRED_IMPL("retractall", 1, retractall, PL_FA_NONDETERMINISTIC|PL_FA_ISO)
+{ GET_LD
+  term_t head = A1;
+  term_t thehead = PL_new_term_ref();
+  Procedure proc;
+  Definition def;
+  Word argv;
+  int allvars = TRUE;
+  int rc = TRUE;
+
+  if ( !get_procedure(head, &proc, thehead, GP_CREATE) )
+    fail;
+
+  def = getProcDefinition(proc);
+  if ( isColumnarDefinition(def) )
+    return columnarRetractAll(proc, thehead);
+  if ( true(def, P_FOREIGN) )
+    return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
+  if ( false(def, P_DYNAMIC) )
+  { if ( isDefinedProcedure(proc) )
+      return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
+    if ( !setDynamicDefinition(def, TRUE) )
+      fail;
+    succeed;				/* nothing to retract */
+  }
+
+  if ( !retractall_event(def, thehead, FUNCTOR_start1 PASS_LD) )
+    return FALSE;
+
+  argv = valTermRef(thehead);
+  deRef(argv);
+  if ( isTerm(*argv) )
+  { int arity = arityTerm(*argv);
+    argv = argTermP(*argv, 0);
+
+    allvars = allVars(arity, argv PASS_LD);
+  } else
+  { allvars = TRUE;
+    argv = NULL;
+  }
+
+  if ( isShardedDefinition(def) )
+  { ShardInfo si = def->shards;
+    Definition shard = shardDefinition(def, argv PASS_LD);
+
+    if ( shard != si->all )
+    { rc = retractall_definition(shard, thehead, allvars PASS_LD);
+    } else
+    { unsigned int i;
+
+      for(i=0; rc && i<si->count; i++)
+	rc = retractall_definition(si->shards[i]->definition,
+				   thehead, allvars PASS_LD);
+    }
+    if ( rc == RETRACTALL_DONE )
+      rc = TRUE;
+  } else
+  { rc = retractall_definition(def, thehead, allvars PASS_LD);
+    if ( rc == RETRACTALL_DONE )
+      return TRUE;
+  }
+
   if ( rc )
     rc = retractall_event(def, thehead, FUNCTOR_end1 PASS_LD);
 
@@ -3350,6 +3635,15 @@ static size_t
 num_visible_clauses(Definition def, atom_t key, gen_t gen ARG_LD)
 { size_t count;
 
+  if ( isShardedDefinition(def) )
+  { unsigned int i;
+
+    for(count=0, i=0; i<def->shards->count; i++)
+      count += num_visible_clauses(def->shards->shards[i]->definition,
+				   key, gen PASS_LD);
+    return count;
+  }
+
   if ( key == ATOM_number_of_clauses )
     count = def->impl.clauses.number_of_clauses;
   else
@@ -3398,6 +3692,8 @@ sizeof_predicate(Definition def)
     release_def(def);
 
     size += sizeofClauseIndexes(def);
+  } else if ( isColumnarDefinition(def) )
+  { size += sizeof_columnar(def);
   }
 
   return size;
@@ -3476,8 +3772,18 @@ PRED_IMPL("$get_predicate_attribute", 3, get_predicate_attribute,
     return rc;
   } else if ( key == ATOM_foreign )
   { return PL_unify_integer(value, true(def, P_FOREIGN) ? 1 : 0);
+  } else if ( key == ATOM_columnar )
+  { return unify_columnar_spec(def, value);
+  } else if ( key == ATOM_bloom )
+  { if ( true(def, P_FOREIGN) )
+      fail;
+    return unify_key_filter(getProcDefinition(proc), value);
+  } else if ( key == ATOM_sharded )
+  { return unify_shard_spec(def, value);
   } else if ( key == ATOM_number_of_clauses )
   { size_t num_clauses;
+    if ( isColumnarDefinition(def) )
+      return PL_unify_int64(value, columnar_rows(def));
     if ( def->flags & P_FOREIGN )
       fail;
 
@@ -3682,6 +3988,21 @@ PRED_IMPL("$set_predicate_attribute", 3, set_predicate_attribute,
     return FALSE;
   }
 
+  if ( key == ATOM_sharded )
+  { if ( !get_procedure(pred, &proc, 0, GP_DEFINE|GP_NAMEARITY) )
+      return FALSE;
+    return setShardedDefinition(proc, value);
+  }
+
+  if ( key == ATOM_bloom )
+  { if ( !PL_get_bool_ex(value, &val) ||
+	 !get_procedure(pred, &proc, 0, GP_DEFINE|GP_NAMEARITY) )
+      return FALSE;
+    if ( true(proc->definition, P_FOREIGN) )
+      return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
+    return setKeyFilterDefinition(proc->definition, val);
+  }
+
   if ( !get_bool_or_int_ex(value, &val PASS_LD) ||
        !(att = attribute_mask(key)) )
     return FALSE;
@@ -71,6 +71,8 @@ ClauseRef	assertDefinition(Definition def, Clause clause,
 				 ClauseRef where ARG_LD);
 ClauseRef	assertProcedure(Procedure proc, Clause clause,
 				ClauseRef where ARG_LD);
+size_t		assertDefinitionBulk(Definition def, Clause *clauses,
+				     size_t count ARG_LD);
 bool		abolishProcedure(Procedure proc, Module module);
 int		retract_clause(Clause clause, gen_t gen ARG_LD);
 bool		retractClauseDefinition(Definition def, Clause clause,
@@ -86,7 +88,12 @@ size_t		removeClausesPredicate(Definition def,
 void		reconsultFinalizePredicate(sf_reload *rl, Definition def,
 					   p_reload *r ARG_LD);
 void		destroyDefinition(Definition def);
+void		eraseDefinition(Definition def);
+void		unallocDefinition(Definition def);
 Procedure	resolveProcedure__LD(functor_t f, Module module ARG_LD);
+Procedure	resolveProcedureStable(functor_t f, Module module,
+				       int *stable ARG_LD);
+int		isDefinedOrAutoloadProcedure(Procedure proc);
 Definition	trapUndefined(Definition undef ARG_LD);
 word		pl_abolish(term_t atom, term_t arity);
 word		pl_abolish1(term_t pred);
@@ -131,6 +138,17 @@ lookupDefinition(functor_t f, Module m)
   return proc ? proc->definition : NULL;
 }
 
+/* procedureResolutionChanged() must be called if resolveProcedure() may
+   return a different procedure for a goal because a procedure is added
+   to a module, the import modules of a module change or a module is
+   destroyed.  This invalidates the meta-call caches of all threads.
+*/
+
+static inline void
+procedureResolutionChanged(void)
+{ ATOMIC_INC(&GD->procedures.resolve_epoch);
+}
+
 
 
 #endif /*_PL_PROC_H*/
\ No newline at end of file
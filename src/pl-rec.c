@@ -47,6 +47,7 @@
 #include "pl-funct.h"
 #include "pl-gc.h"
 #include "pl-proc.h"
+#include "pl-narray.h"
 
 #define WORDS_PER_PLINT (sizeof(int64_t)/sizeof(word))
 
@@ -258,6 +259,7 @@ typedef struct
 #define PL_REC_MPQ		(19)	/* GMP rational */
 
 #define PL_TYPE_EXT_COMPOUND_V2	(20)	/* Read V2 external records */
+#define PL_TYPE_EXT_NARRAY	(21)	/* External (inlined) narray blob */
 
 static const int v2_map[] =
 { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,		/* variable..string */
@@ -426,6 +428,15 @@ addAtom(CompileInfo info, atom_t a)
 	addOpCode(info, PL_TYPE_EXT_ATOM);
 
       addAtomValue(info, ap);
+    } else if ( isNArrayAtom(a) )
+    { char hdr[NARRAY_IMAGE_HDR];
+      size_t bytes;
+      const void *data = narrayImage(a, hdr, &bytes);
+
+      addOpCode(info, PL_TYPE_EXT_NARRAY);
+      addSizeInt(info, sizeof(hdr)+bytes);
+      addMultipleBuffer(&info->code, hdr, sizeof(hdr), char);
+      addMultipleBuffer(&info->code, data, bytes, char);
     } else
     { info->error = EFAST_SERIALIZE;
       info->econtext[0] = a;
@@ -1115,6 +1126,7 @@ PRED_IMPL("fast_read", 2, fast_read, 0)
 	      goto out;
 	    case PL_TYPE_EXT_WATOM:
 	    case PL_TYPE_EXT_ATOM:
+	    case PL_TYPE_EXT_NARRAY:
 	    { size_t bytes;
 	      char *np;
 
@@ -1327,6 +1339,17 @@ fetchAtomW(CopyInfo b, atom_t *a)
 }
 
 
+static int
+fetchNArray(CopyInfo b, atom_t *a)
+{ size_t len = fetchSizeInt(b);
+
+  *a = narrayFromImage(b->data, len);
+  b->data += len;
+
+  return *a != 0;
+}
+
+
 static void
 fetchChars(CopyInfo b, unsigned len, Word to)
 { fetchMultipleBuf(b, (char *)to, len, char);
@@ -1404,6 +1427,12 @@ copy_record(Word p, CopyInfo b ARG_LD)
 	PL_unregister_atom(*p);
 	continue;
       }
+      case PL_TYPE_EXT_NARRAY:
+      { if ( !fetchNArray(b, p) )
+	  return MEMORY_OVERFLOW;
+	PL_unregister_atom(*p);
+	continue;
+      }
       case PL_TYPE_TAGGED_INTEGER:
       { int64_t val = fetchInt64(b);
 	*p = consInt(val);
@@ -1606,6 +1635,7 @@ is_external(const char *rec, size_t len)
 	    return len == 2;
 	  case PL_TYPE_EXT_WATOM:
 	  case PL_TYPE_EXT_ATOM:
+	  case PL_TYPE_EXT_NARRAY:
 	  { size_t bytes = fetchSizeInt(&info);
 	    return len == (info.data-info.base)+bytes;
 	  }
@@ -1639,7 +1669,7 @@ recursion.   Other   options:   combine     into    copyRecordToGlobal()
 
 static void
 skipAtom(CopyInfo b)
-{ uint len = fetchSizeInt(b);
+{ size_t len = fetchSizeInt(b);
 
   b->data += len;
 }
@@ -1696,6 +1726,7 @@ scanAtomsRecord(CopyInfo b, void (*func)(atom_t a))
       }
       case PL_TYPE_EXT_ATOM:
       case PL_TYPE_EXT_WATOM:
+      case PL_TYPE_EXT_NARRAY:
       { skipAtom(b);
 	continue;
       }
@@ -1882,6 +1913,10 @@ PL_recorded_external(const char *rec, term_t t)
         case PL_TYPE_EXT_WATOM:
 	  fetchAtomW(&b, &a);
 	  break;
+        case PL_TYPE_EXT_NARRAY:
+	  if ( !fetchNArray(&b, &a) )
+	    return PL_no_memory();
+	  break;
 	default:
 	  a = 0;
 	  assert(0);
@@ -2450,6 +2485,115 @@ PRED_IMPL("erase", 1, erase, 0)
   }
 }
 
+		 /*******************************
+		 *	   SHARED TERMS		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+share_term(+Term, -Handle) compiles a ground term into a record once and
+returns a blob that refers to it.  The handle is an atom and can thus be
+passed to other threads using message queues, global variables or the
+database at constant cost, after which each thread copies the term using
+shared_term/2.  The record locks the atoms of the term and the record is
+released by AGC after the last reference to the handle disappears, i.e.,
+the reference count is maintained by the atom garbage collector.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct shared_term_ref
+{ Record	record;			/* The shared term */
+} shared_term_ref;
+
+static int
+write_shared_term(IOSTREAM *s, atom_t aref, int flags)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<shared_term>(%p)", ref->record);
+  return TRUE;
+}
+
+
+static int
+release_shared_term(atom_t aref)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+
+  freeRecord(ref->record);
+
+  return TRUE;
+}
+
+
+static int
+save_shared_term(atom_t aref, IOSTREAM *fd)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)fd;
+
+  return PL_warning("Cannot save reference to <shared_term>(%p)",
+		    ref->record);
+}
+
+
+static atom_t
+load_shared_term(IOSTREAM *fd)
+{ (void)fd;
+
+  return PL_new_atom("<saved-shared-term-ref>");
+}
+
+
+static PL_blob_t shared_term_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_UNIQUE,
+  "shared_term",
+  release_shared_term,
+  NULL,
+  write_shared_term,
+  NULL,
+  save_shared_term,
+  load_shared_term
+};
+
+
+static
+PRED_IMPL("share_term", 2, share_term, 0)
+{ PRED_LD
+  shared_term_ref ref;
+
+  if ( !PL_is_ground(A1) )
+    return PL_error(NULL, 0, NULL, ERR_INSTANTIATION);
+
+  if ( (ref.record = compileTermToHeap(A1, 0)) )
+  { if ( PL_unify_blob(A2, &ref, sizeof(ref), &shared_term_blob) )
+      return TRUE;
+    freeRecord(ref.record);
+    return FALSE;
+  }
+
+  return PL_no_memory();
+}
+
+
+static
+PRED_IMPL("shared_term", 2, shared_term, 0)
+{ PRED_LD
+  PL_blob_t *type;
+  void *data;
+  term_t t;
+  int rc;
+
+  if ( !PL_get_blob(A1, &data, NULL, &type) || type != &shared_term_blob )
+    return PL_type_error("shared_term", A1);
+
+  if ( !(t=PL_new_term_ref()) )
+    return FALSE;
+  if ( (rc=copyRecordToGlobal(t, ((shared_term_ref*)data)->record,
+			      ALLOW_GC PASS_LD)) < 0 )
+    return raiseStackOverflow(rc);
+
+  return PL_unify(A2, t);
+}
+
+
 		 /*******************************
 		 *      PUBLISH PREDICATES	*
 		 *******************************/
@@ -2470,4 +2614,7 @@ BeginPredDefs(rec)
   PRED_DEF("fast_term_serialized", 2, fast_term_serialized, 0)
   PRED_DEF("fast_write",	   2, fast_write,	    0)
   PRED_DEF("fast_read",		   2, fast_read,	    0)
+
+  PRED_DEF("share_term",	   2, share_term,	    0)
+  PRED_DEF("shared_term",	   2, shared_term,	    0)
 EndPredDefs
@@ -117,3 +117,77 @@ sort_r(void *base, size_t nel, size_t width,
 
 #endif /*HAVE_QSORT_R|HAVE_QSORT_S*/
 
+
+
+		 /*******************************
+		 *	     RADIX SORT		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int radix_sort(radix_item *items, size_t nel)
+
+Stable LSD radix sort of items on their  unsigned 64-bit key using 8-bit
+digits.  The histograms for all digits   are computed in a single pass
+and digits for which all keys are  the   same  are skipped, so sorting
+small integers takes only one or  two   scatter  passes.  Returns FALSE
+if the temporary buffer cannot be allocated.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define RADIX_BITS	8
+#define RADIX_SIZE	(1<<RADIX_BITS)
+#define RADIX_DIGITS	(64/RADIX_BITS)
+
+#define radix_digit(k, d) ((size_t)((k)>>((d)*RADIX_BITS)) & (RADIX_SIZE-1))
+
+int
+radix_sort(radix_item *items, size_t nel)
+{ size_t (*count)[RADIX_SIZE];
+  radix_item *tmp, *src, *dst;
+  size_t i;
+  int d;
+
+  if ( nel < 2 )
+    return TRUE;
+  if ( !(count = calloc(RADIX_DIGITS, sizeof(*count))) )
+    return FALSE;
+  if ( !(tmp = malloc(nel*sizeof(*tmp))) )
+  { free(count);
+    return FALSE;
+  }
+
+  for(i=0; i<nel; i++)
+  { uint64_t k = items[i].key;
+
+    for(d=0; d<RADIX_DIGITS; d++)
+      count[d][radix_digit(k, d)]++;
+  }
+
+  src = items;
+  dst = tmp;
+  for(d=0; d<RADIX_DIGITS; d++)
+  { size_t *c = count[d];
+    size_t offset = 0;
+
+    if ( c[radix_digit(src[0].key, d)] == nel )
+      continue;				/* all the same */
+
+    for(i=0; i<RADIX_SIZE; i++)
+    { size_t n = c[i];
+
+      c[i] = offset;
+      offset += n;
+    }
+    for(i=0; i<nel; i++)
+      dst[c[radix_digit(src[i].key, d)]++] = src[i];
+
+    { radix_item *t = src; src = dst; dst = t; }
+  }
+
+  if ( src != items )
+    memcpy(items, src, nel*sizeof(*items));
+
+  free(tmp);
+  free(count);
+
+  return TRUE;
+}
@@ -41,4 +41,11 @@ COMMON(void) sort_r(void *base, size_t nel, size_t width,
 		    int (*compar)(const void *a1, const void *a2, void *aarg),
 		    void *arg);
 
+typedef struct radix_item
+{ uint64_t	key;			/* Sort key */
+  void	       *value;			/* Associated data */
+} radix_item;
+
+COMMON(int) radix_sort(radix_item *items, size_t nel);
+
 #endif /*PL_RSORT_H_INCLUDED*/
@@ -61,6 +61,7 @@
 #include "pl-proc.h"
 #include "pl-pro.h"
 #include "pl-gvar.h"
+#include "pl-narray.h"
 #include <sys/stat.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -134,6 +135,7 @@ setupProlog(void)
   DEBUG(1, Sdprintf("Records ...\n"));
   initDBRef();
   initRecords();
+  initNArray();
   DEBUG(1, Sdprintf("Tries ...\n"));
   initTries();
   DEBUG(1, Sdprintf("Tabling ...\n"));
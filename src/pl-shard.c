@@ -0,0 +1,429 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pl-incl.h"
+#include "pl-shard.h"
+#include "pl-comp.h"
+#include "pl-proc.h"
+#include "pl-index.h"
+#include "pl-wrap.h"
+#include "pl-fli.h"
+#include "pl-hash.h"
+#include "pl-tabling.h"
+#include "pl-funct.h"
+#include "pl-util.h"
+#include "pl-supervisor.h"
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A sharded dynamic predicate distributes its clauses over N shards based
+on the hash of the clause index key (see indexOfWord()) of one argument.
+A predicate is sharded using
+
+    :- dynamic([counter/2], [sharded(16)]).	% first argument
+    :- dynamic([edge/3], [sharded(16-2)]).	% second argument
+
+Each shard is an anonymous dynamic definition that shares  the  functor
+and module of the sharded predicate, so clauses, clause references and
+error messages refer to the predicate itself.  Each  shard has its own
+clause list, its own JIT clause indexes and  its own mutex (see LOCKDEF()
+in pl-thread.h), such that threads updating different shards do  not
+contend.
+
+The predicate itself has no clauses.   Its  supervisor, S_SHARD, looks
+at the shard argument.  If  bound,  the   call  is  continued  in  the
+matching shard.  Otherwise it continues in `all`, an anonymous predicate
+with one clause per shard that  calls   the  shard  through a closure
+(see pl-wrap.c).  As a result, an  unbound   call  enumerates the shards
+in order, and the order of clauses is  only maintained within a shard.
+The logical update view also applies per shard.
+
+Clauses are added  to  a  shard  by   assert/1  and  friends,  which
+therefore require the shard  argument  to  be   bound.  retract/1  and
+clause/2 with a bound shard argument  operate   on  a  single shard.
+Otherwise they walk the shards using nextShardClause().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static inline unsigned int
+shard_index(ShardInfo si, word key)
+{ return (unsigned int)(MurmurHashAligned2(&key, sizeof(key), MURMUR_SEED) %
+			si->count);
+}
+
+
+static Definition
+new_shard_definition(Definition parent, ShardInfo si)
+{ Definition def = allocHeapOrHalt(sizeof(*def));
+  size_t arity = parent->functor->arity;
+
+  memset(def, 0, sizeof(*def));
+  def->functor = parent->functor;
+  def->module  = parent->module;
+  def->shared  = 1;
+  def->impl.any.args = allocHeapOrHalt(sizeof(arg_info)*arity);
+  memset(def->impl.any.args, 0, sizeof(arg_info)*arity);
+  def->flags   = P_DYNAMIC|(parent->flags&(TRACE_ME|HIDE_CHILDS|P_LOCKED));
+  def->codes   = SUPERVISOR(dynamic);
+  def->shards  = si;
+
+  return def;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Reclaiming a ShardInfo.  Running goals may still be inside a shard, so
+the shards and `all` are erased as  normal   predicates  and  left to
+clause-GC.  Each shard still points at si,  and nextShardClause() walks
+si->shards[], so we cannot free  a   shard  before  all of them can be
+reclaimed.  When clause-GC finds an  erased   shard  without clauses, it
+calls releaseShardDefinition().  The last one frees  all shards, their
+procedures and si itself.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+erase_shard(Definition def)
+{ LOCKDEF(def);				/* private mutex */
+  removeClausesPredicate(def, 0, FALSE);
+  UNLOCKDEF(def);
+  eraseDefinition(def);
+}
+
+
+/* `all` shares L_PREDICATE, which our caller may hold.  It is not
+   modified after setShardedDefinition() and thus needs no lock.
+*/
+
+static void
+erase_shards(ShardInfo si)
+{ unsigned int i;
+
+  if ( si->all )
+  { eraseDefinition(si->all);
+    si->all = NULL;
+  }
+  for(i=0; i<si->count; i++)
+    erase_shard(si->shards[i]->definition);
+}
+
+
+/* freeShardInfo() is called if the sharded predicate def is abolished or
+   destroyed.  It turns def into a normal predicate and erases the shards.
+*/
+
+void
+freeShardInfo(Definition def)
+{ ShardInfo si = def->shards;
+
+  def->shards = NULL;
+  freeCodesDefinition(def, TRUE);	/* S_SHARD --> S_VIRGIN */
+  erase_shards(si);
+}
+
+
+void
+releaseShardDefinition(Definition def)
+{ ShardInfo si = def->shards;
+
+  if ( ATOMIC_DEC(&si->references) == 0 )
+  { unsigned int i;
+
+    for(i=0; i<si->count; i++)
+    { Procedure proc = si->shards[i];
+
+#ifdef O_PLMT
+      freeSimpleMutex(proc->definition->mutex);
+#endif
+      unallocDefinition(proc->definition);
+      freeHeap(proc, sizeof(*proc));
+    }
+    freeHeap(si, sizeof(*si) + (si->count-1)*sizeof(Procedure));
+  }
+}
+
+
+static Procedure
+new_shard(Definition parent, ShardInfo si)
+{ Procedure proc = allocHeapOrHalt(sizeof(*proc));
+  Definition def = new_shard_definition(parent, si);
+
+#ifdef O_PLMT
+  def->mutex = allocSimpleMutex(predicateName(parent));
+#endif
+  proc->definition = def;
+  proc->flags      = 0;
+  proc->source_no  = 0;
+
+  return proc;
+}
+
+
+/* Create the clause  p(A1,  ...)  :-   call(<closure>,  A1,  ...)  for
+   calling shard `i` from the `all` predicate.
+*/
+
+static int
+add_all_clause(ShardInfo si, unsigned int i ARG_LD)
+{ Definition parent = si->parent;
+  size_t arity = parent->functor->arity;
+  struct procedure allproc = { si->all, 0, 0 };
+  fid_t fid;
+  int rc = FALSE;
+
+  if ( (fid = PL_open_foreign_frame()) )
+  { term_t av   = PL_new_term_refs((int)arity+1);
+    term_t head = PL_new_term_ref();
+    term_t body = PL_new_term_ref();
+    Clause clause;
+
+    if ( unify_closure(av, si->shards[i]->definition, SUPERVISOR(dynamic)) &&
+	 PL_cons_functor_v(head, parent->functor->functor, av+1) &&
+	 PL_cons_functor_v(body, lookupFunctorDef(ATOM_call, arity+1), av) )
+    { Word h = valTermRef(head);
+      Word b = valTermRef(body);
+
+      deRef(h);
+      deRef(b);
+      if ( compileClause(&clause, h, b, &allproc, parent->module,
+			 0, 0 PASS_LD) == TRUE &&
+	   assertDefinition(si->all, clause, CL_END PASS_LD) )
+	rc = TRUE;
+    }
+    PL_close_foreign_frame(fid);
+  }
+
+  return rc;
+}
+
+
+static int
+get_shard_spec(term_t spec, int arity, int *count, int *arg)
+{ GET_LD
+  term_t a;
+
+  *arg = 1;
+  if ( PL_is_functor(spec, FUNCTOR_minus2) )
+  { a = PL_new_term_ref();
+
+    _PL_get_arg(2, spec, a);
+    if ( !PL_get_integer_ex(a, arg) )
+      return FALSE;
+    if ( *arg < 1 || *arg > arity )
+      return PL_domain_error("shard_argument", a);
+    _PL_get_arg(1, spec, a);
+  } else
+  { a = spec;
+  }
+
+  if ( !PL_get_integer_ex(a, count) )
+    return FALSE;
+  if ( *count < 2 || *count > MAX_SHARDS )
+    return PL_domain_error("shard_count", a);
+
+  return TRUE;
+}
+
+
+int
+setShardedDefinition(Procedure proc, term_t spec)
+{ GET_LD
+  Definition def = proc->definition;
+  int arity = (int)def->functor->arity;
+  ShardInfo si;
+  int count, arg;
+  unsigned int i;
+  int was_dynamic;
+  int rc = FALSE;
+
+  if ( true(def, P_FOREIGN) ||
+       (false(def, P_DYNAMIC) && isDefinedProcedure(proc)) )
+    return PL_error(NULL, 0, NULL, ERR_MODIFY_STATIC_PROC, proc);
+  if ( arity == 0 )
+    return PL_error(NULL, 0, "sharded predicates need an argument",
+		    ERR_PERMISSION_PROC, ATOM_modify,
+		    ATOM_sharded_procedure, proc);
+  if ( !get_shard_spec(spec, arity, &count, &arg) )
+    return FALSE;
+
+  LOCKMODULE(def->module);
+  if ( (si=def->shards) )
+  { if ( si->count == (unsigned int)count && si->arg == (unsigned int)arg-1 )
+      rc = TRUE;
+    else
+      PL_error(NULL, 0, "already sharded",
+	       ERR_PERMISSION_PROC, ATOM_modify,
+	       ATOM_sharded_procedure, proc);
+    goto out;
+  }
+  if ( true(def, P_THREAD_LOCAL) || def->tabling || def->events ||
+       hasClausesDefinition(def) )
+  { PL_error(NULL, 0, "must be a plain dynamic predicate without clauses",
+	     ERR_PERMISSION_PROC, ATOM_modify,
+	     ATOM_sharded_procedure, proc);
+    goto out;
+  }
+  was_dynamic = true(def, P_DYNAMIC);
+  if ( !setDynamicDefinition(def, TRUE) )
+    goto out;
+
+  si = allocHeapOrHalt(sizeof(*si) + (count-1)*sizeof(Procedure));
+  si->parent     = def;
+  si->arg        = arg-1;
+  si->count      = count;
+  si->references = count;
+  for(i=0; i<si->count; i++)
+    si->shards[i] = new_shard(def, si);
+  si->all = new_shard_definition(def, si);
+  si->all->shards = NULL;		/* just a predicate */
+  for(i=0; i<si->count; i++)
+  { if ( !add_all_clause(si, i PASS_LD) )
+    { erase_shards(si);
+      if ( !was_dynamic )
+	setDynamicDefinition(def, FALSE);
+      goto out;
+    }
+  }
+
+  LOCKDEF(def);
+  def->shards = si;
+  freeCodesDefinition(def, TRUE);	/* S_VIRGIN --> S_SHARD */
+  UNLOCKDEF(def);
+  rc = TRUE;
+
+out:
+  UNLOCKMODULE(def->module);
+  return rc;
+}
+
+
+int
+unify_shard_spec(Definition def, term_t spec)
+{ GET_LD
+  ShardInfo si;
+
+  if ( isShardedDefinition(def) )
+  { si = def->shards;
+    return PL_unify_term(spec,
+			 PL_FUNCTOR, FUNCTOR_minus2,
+			   PL_INT, (int)si->count,
+			   PL_INT, (int)si->arg+1);
+  }
+
+  return FALSE;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+shardDefinition() returns the definition that handles a call to the
+sharded predicate def with arguments argv: the  shard  if  the  shard
+argument is bound and the `all` predicate otherwise. Used by S_SHARD.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+Definition
+shardDefinition(Definition def, Word argv ARG_LD)
+{ ShardInfo si = def->shards;
+  word key;
+
+  if ( (key = getIndexOfWord(argv[si->arg] PASS_LD)) )
+    return si->shards[shard_index(si, key)]->definition;
+
+  return si->all;
+}
+
+
+/* shardProcedure() returns the shard to which a clause with the given
+   head must be added, raising an instantiation error if the shard argument
+   is unbound.
+*/
+
+Procedure
+shardProcedure(Definition def, term_t head)
+{ GET_LD
+  ShardInfo si = def->shards;
+  term_t a = PL_new_term_ref();
+  word key;
+
+  if ( !PL_get_arg(si->arg+1, head, a) )
+    return NULL;
+  if ( !(key = getIndexOfTerm(a)) )
+  { PL_error(NULL, 0, "shard argument must be bound", ERR_INSTANTIATION);
+    return NULL;
+  }
+
+  return si->shards[shard_index(si, key)];
+}
+
+
+Definition
+firstShard(Definition def)
+{ return def->shards->shards[0]->definition;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+nextShardClause() is used to walk  all   shards  if the shard argument is
+unbound.  *defp is the shard we are in, to which  the caller holds
+predicate access (see pushPredicateAccessObj()).  It finds  the  first
+candidate clause in the shards that follow.  Access is moved along to
+each shard visited and *defp is updated,  so the caller always releases
+*defp.  If a clause is found, chp is set up as by firstClause() for the
+remainder of this shard.  The frame gets the generation of the new shard.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+ClauseRef
+nextShardClause(Definition *defp, Word argv, LocalFrame fr,
+		ClauseChoice chp ARG_LD)
+{ Definition def = *defp;
+  ShardInfo si = def->shards;
+  unsigned int i;
+
+  for(i=0; i<si->count; i++)
+  { if ( si->shards[i]->definition == def )
+      break;
+  }
+
+  for(i++; i<si->count; i++)
+  { Definition next = si->shards[i]->definition;
+    definition_ref *dref;
+    ClauseRef cref;
+
+    if ( !(dref=pushPredicateAccessObj(next PASS_LD)) )
+      return NULL;
+    popPredicateAccess(def);
+    *defp = def = next;
+    setGenerationFrameVal(fr, dref->generation);
+
+    if ( (cref = firstClause(argv, fr, def, chp PASS_LD)) )
+      return cref;
+  }
+
+  return NULL;
+}
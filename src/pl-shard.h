@@ -0,0 +1,65 @@
+/*  Part of SWI-Prolog
+
+    Author:        SWI-Prolog contributors
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog contributors
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PL_SHARD_H_INCLUDED
+#define PL_SHARD_H_INCLUDED
+
+#define MAX_SHARDS	1024		/* Max # shards of a predicate */
+
+struct shard_info
+{ Definition	parent;			/* The sharded predicate */
+  unsigned int	arg;			/* 0-based shard argument */
+  unsigned int	count;			/* # shards */
+  unsigned int	references;		/* # shards not yet reclaimed */
+  Definition	all;			/* Calls all shards in order */
+  Procedure	shards[1];		/* The shards */
+};
+
+#define isShardedDefinition(def) \
+	unlikely((def)->shards != NULL && (def)->shards->parent == (def))
+#define isShardDefinition(def) \
+	unlikely((def)->shards != NULL && (def)->shards->parent != (def))
+#define isLastShard(def) \
+	((def)->shards->shards[(def)->shards->count-1]->definition == (def))
+
+int		setShardedDefinition(Procedure proc, term_t spec);
+void		freeShardInfo(Definition def);
+void		releaseShardDefinition(Definition def);
+int		unify_shard_spec(Definition def, term_t spec);
+Definition	shardDefinition(Definition def, Word argv ARG_LD);
+Procedure	shardProcedure(Definition def, term_t head);
+Definition	firstShard(Definition def);
+ClauseRef	nextShardClause(Definition *defp, Word argv, LocalFrame fr,
+				ClauseChoice chp ARG_LD);
+
+#endif /*PL_SHARD_H_INCLUDED*/
@@ -41,6 +41,7 @@
 #include "pl-wrap.h"
 #include "pl-tabling.h"
 #include "pl-util.h"
+#include "pl-shard.h"
 
 #define MAX_FLI_ARGS 10			/* extend switches on change */
 
@@ -284,6 +285,15 @@ listSupervisor(Definition def)
 }
 
 
+static Code
+shardedSupervisor(Definition def)
+{ if ( isShardedDefinition(def) )
+    return SUPERVISOR(shard);
+
+  return NULL;
+}
+
+
 static Code
 dynamicSupervisor(Definition def)
 { if ( true(def, P_DYNAMIC) )
@@ -405,6 +415,7 @@ createSupervisor(Definition def)
   int has_codes;
 
   has_codes = ((codes = undefSupervisor(def)) ||
+	       (codes = shardedSupervisor(def)) ||
 	       (codes = dynamicSupervisor(def)) ||
 	       (codes = multifileSupervisor(def)) ||
 	       (codes = singleClauseSupervisor(def)) ||
@@ -501,4 +512,5 @@ initSupervisors(void)
   MAKE_SV1(staticp,      S_STATIC);
   MAKE_SV1(wrapper,      S_WRAP);
   MAKE_SV1(trie_gen,     S_TRIE_GEN);
+  MAKE_SV1(shard,        S_SHARD);
 }
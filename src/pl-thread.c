@@ -464,6 +464,8 @@ static void	destroy_message_queue(message_queue *queue);
 static void	destroy_thread_message_queue(message_queue *queue);
 static void	init_message_queue(message_queue *queue, size_t max_size);
 static size_t	sizeof_message_queue(message_queue *queue);
+static message_queue *get_fifo_queue(term_t t ARG_LD);
+static void	ring_release(struct message_ring *r, size_t count);
 static size_t	sizeof_local_definitions(PL_local_data_t *ld);
 static void	freeThreadSignals(PL_local_data_t *ld);
 static thread_handle *create_thread_handle(PL_thread_info_t *info);
@@ -565,6 +567,9 @@ initialise_thread(PL_thread_info_t *info)
 
   initPrologLocalData(info->thread_data);
   info->thread_data->magic = LD_MAGIC;
+#ifdef O_ALLOC_CACHE
+  attachAllocCache(info->thread_data);
+#endif
 
   return TRUE;
 }
@@ -714,6 +719,9 @@ freePrologThread(PL_local_data_t *ld, int after_fork)
       free_thread_info(info);
 
     ld->thread.info = NULL;		/* help force a crash if ld used */
+#ifdef O_ALLOC_CACHE
+    detachAllocCache(ld);
+#endif
     maybe_free_local_data(ld);
 
     if ( acknowledge )			/* == canceled */
@@ -876,6 +884,9 @@ initPrologThreads(void)
   TLD_set_LD(&PL_local_data);
 
   PL_local_data.magic = LD_MAGIC;
+#ifdef O_ALLOC_CACHE
+  attachAllocCache(&PL_local_data);
+#endif
   { GD->thread.thread_max = 4;		/* see resizeThreadMax() */
     GD->thread.highest_allocated = 1;
     GD->thread.threads = allocHeapOrHalt(GD->thread.thread_max *
@@ -3603,13 +3614,80 @@ of waiting threads and the number waiting  with a variable. Only if they
 are not equal and there are multiple waiters we must be using broadcast.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Selective receive (e.g., thread_get_message(reply(Id,X))) on a queue with
+many pending messages used to scan the queue from the head, unifying with
+every message whose principal functor matches. If a queue holds at least
+MSG_INDEX_MIN messages and a selective receive does not match its head,
+we build an index that maps the combination of the functor and the index
+key of the first argument to a FIFO bucket of messages.  Plain FIFO usage
+thus never pays for the index.  Messages that cannot be indexed (unbound
+message or unbound first argument) are kept in the wildcards bucket.  A
+pattern with an instantiated first argument only needs to consider its
+bucket and the wildcards.  Both are ordered by sequence_id, so merging
+them preserves the global queue order.  The index is maintained by
+queue_message() and unlink_message() and dropped when the queue becomes
+empty.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define MSG_INDEX_MIN 64		/* Min queue size for key index */
+
 typedef struct thread_message
 { struct thread_message *next;		/* next in queue */
+  struct thread_message *prev;		/* previous in queue */
+  struct thread_message *next_key;	/* next in key bucket */
+  struct thread_message *prev_key;	/* previous in key bucket */
+  struct message_bucket *bucket;	/* bucket we are in (if indexed) */
   record_t            message;		/* message in queue */
   word		      key;		/* Indexing key */
+  word		      index_key;	/* Key in queue->index (or 0) */
   uint64_t	      sequence_id;	/* Numbered sequence */
 } thread_message;
 
+typedef struct message_bucket
+{ thread_message     *head;		/* First message with this key */
+  thread_message     *tail;		/* Last message with this key */
+  word		      index_key;	/* Key in the index (0: wildcards) */
+  struct message_bucket *next;		/* Next in hash chain */
+} message_bucket;
+
+typedef struct message_index
+{ message_bucket    **buckets;		/* Hash table */
+  size_t	      size;		/* # hash chains (power of 2) */
+  size_t	      count;		/* # keys in the table */
+  message_bucket      wildcards;	/* Messages that cannot be indexed */
+} message_index;
+
+
+/* message_index_key() computes the key in the queue's index from term t,
+   whose getIndexOfTerm() is `key`.  Returns 0 if t cannot be indexed
+   because it is unbound or its first argument is unbound.
+*/
+
+static word
+message_index_key(term_t t, word key ARG_LD)
+{ Word p = valTermRef(t);
+  word arg_key = 0;
+  word k;
+
+  if ( !key )
+    return 0;
+
+  deRef(p);
+  if ( isTerm(*p) )
+  { Functor f = valueTerm(*p);
+
+    if ( arityFunctor(f->definition) > 0 )
+    { if ( !(arg_key = getIndexOfWord(f->arguments[0] PASS_LD)) )
+	return 0;
+    }
+  }
+
+  k = key ^ ((arg_key << 13) | (arg_key >> (sizeof(word)*8-13)));
+
+  return k ? k : 1;
+}
+
 
 static thread_message *
 create_thread_message(term_t msg ARG_LD)
@@ -3620,9 +3698,10 @@ create_thread_message(term_t msg ARG_LD)
     return NULL;
 
   if ( (msgp = allocHeap(sizeof(*msgp))) )
-  { msgp->next    = NULL;
-    msgp->message = rec;
-    msgp->key     = getIndexOfTerm(msg);
+  { memset(msgp, 0, sizeof(*msgp));
+    msgp->message   = rec;
+    msgp->key       = getIndexOfTerm(msg);
+    msgp->index_key = message_index_key(msg, msgp->key PASS_LD);
   } else
   { freeRecord(rec);
   }
@@ -3640,18 +3719,601 @@ free_thread_message(thread_message *msg)
 }
 
 
+static inline size_t
+message_key_hash(word key, size_t size)
+{ return MurmurHashAligned2(&key, sizeof(key), MURMUR_SEED) & (size-1);
+}
+
+
+static message_bucket *
+lookup_message_bucket(message_index *idx, word index_key)
+{ message_bucket *b = idx->buckets[message_key_hash(index_key, idx->size)];
+
+  for( ; b; b = b->next )
+  { if ( b->index_key == index_key )
+      return b;
+  }
+
+  return NULL;
+}
+
+
+static void
+rehash_message_index(message_index *idx)
+{ size_t newsize = idx->size*2;
+  message_bucket **newbuckets = allocHeapOrHalt(newsize*sizeof(*newbuckets));
+  size_t i;
+
+  memset(newbuckets, 0, newsize*sizeof(*newbuckets));
+  for(i=0; i<idx->size; i++)
+  { message_bucket *b, *next;
+
+    for(b = idx->buckets[i]; b; b = next)
+    { size_t k = message_key_hash(b->index_key, newsize);
+
+      next = b->next;
+      b->next = newbuckets[k];
+      newbuckets[k] = b;
+    }
+  }
+
+  freeHeap(idx->buckets, idx->size*sizeof(*idx->buckets));
+  idx->buckets = newbuckets;
+  idx->size    = newsize;
+}
+
+
+static void
+index_message(message_queue *queue, thread_message *msgp)
+{ message_index *idx = queue->index;
+  message_bucket *b;
+
+  if ( msgp->index_key )
+  { if ( !(b = lookup_message_bucket(idx, msgp->index_key)) )
+    { size_t k;
+
+      if ( idx->count >= idx->size )
+	rehash_message_index(idx);
+      k = message_key_hash(msgp->index_key, idx->size);
+
+      b = allocHeapOrHalt(sizeof(*b));
+      b->head = b->tail = NULL;
+      b->index_key = msgp->index_key;
+      b->next = idx->buckets[k];
+      idx->buckets[k] = b;
+      idx->count++;
+    }
+  } else
+  { b = &idx->wildcards;
+  }
+
+  msgp->bucket   = b;
+  msgp->next_key = NULL;
+  if ( (msgp->prev_key = b->tail) )
+    b->tail->next_key = msgp;
+  else
+    b->head = msgp;
+  b->tail = msgp;
+}
+
+
+static void
+delete_message_bucket(message_index *idx, message_bucket *b)
+{ message_bucket **bp = &idx->buckets[message_key_hash(b->index_key, idx->size)];
+
+  for( ; *bp; bp = &(*bp)->next )
+  { if ( *bp == b )
+    { *bp = b->next;
+      idx->count--;
+      freeHeap(b, sizeof(*b));
+      return;
+    }
+  }
+
+  assert(0);
+}
+
+
+static void
+create_message_index(message_queue *queue)
+{ message_index *idx = allocHeapOrHalt(sizeof(*idx));
+  thread_message *msgp;
+
+  memset(idx, 0, sizeof(*idx));
+  idx->size    = MSG_INDEX_MIN;
+  idx->buckets = allocHeapOrHalt(idx->size*sizeof(*idx->buckets));
+  memset(idx->buckets, 0, idx->size*sizeof(*idx->buckets));
+  queue->index = idx;
+
+  for(msgp = queue->head; msgp; msgp = msgp->next)
+    index_message(queue, msgp);
+}
+
+
+static void
+destroy_message_index(message_queue *queue)
+{ message_index *idx;
+
+  if ( (idx=queue->index) )
+  { size_t i;
+    thread_message *msgp;
+
+    queue->index = NULL;
+    for(msgp = queue->head; msgp; msgp = msgp->next)
+      msgp->bucket = NULL;
+    for(i=0; i<idx->size; i++)
+    { message_bucket *b, *next;
+
+      for(b = idx->buckets[i]; b; b = next)
+      { next = b->next;
+	freeHeap(b, sizeof(*b));
+      }
+    }
+    freeHeap(idx->buckets, idx->size*sizeof(*idx->buckets));
+    freeHeap(idx, sizeof(*idx));
+  }
+}
+
+
+/* unlink_message_key() removes msgp from its key bucket.
+*/
+
+static void
+unlink_message_key(message_queue *queue, thread_message *msgp)
+{ message_bucket *b = msgp->bucket;
+
+  if ( msgp->prev_key )
+    msgp->prev_key->next_key = msgp->next_key;
+  else
+    b->head = msgp->next_key;
+  if ( msgp->next_key )
+    msgp->next_key->prev_key = msgp->prev_key;
+  else
+    b->tail = msgp->prev_key;
+
+  if ( !b->head && b->index_key )
+    delete_message_bucket(queue->index, b);
+}
+
+
+/* unlink_message() removes msgp from the queue and its key bucket.  The
+   caller must hold the queue-mutex.
+*/
+
+static void
+unlink_message(message_queue *queue, thread_message *msgp)
+{ simpleMutexLock(&queue->gc_mutex);	/* see get_message() */
+  if ( msgp->prev )
+    msgp->prev->next = msgp->next;
+  else
+    queue->head = msgp->next;
+  if ( msgp->next )
+    msgp->next->prev = msgp->prev;
+  else
+    queue->tail = msgp->prev;
+  simpleMutexUnlock(&queue->gc_mutex);
+  queue->size--;
+  if ( queue->ring )
+    ring_release(queue->ring, 1);
+
+  if ( msgp->bucket )
+  { if ( !queue->head )
+      destroy_message_index(queue);
+    else
+      unlink_message_key(queue, msgp);
+  }
+}
+
+
+/* unlink_messages() removes the first `count` messages from the queue,
+   locking gc_mutex only once.  Returns the first removed message; the
+   removed messages remain linked through their `next` field.
+*/
+
+static thread_message *
+unlink_messages(message_queue *queue, size_t count)
+{ thread_message *first = queue->head;
+  thread_message *last = first;
+  size_t i;
+
+  for(i=1; i<count; i++)
+    last = last->next;
+
+  simpleMutexLock(&queue->gc_mutex);	/* see get_message() */
+  if ( (queue->head = last->next) )
+    queue->head->prev = NULL;
+  else
+    queue->tail = NULL;
+  simpleMutexUnlock(&queue->gc_mutex);
+  queue->size -= count;
+  if ( queue->ring )
+    ring_release(queue->ring, count);
+
+  if ( queue->index )
+  { if ( !queue->head )
+    { destroy_message_index(queue);
+    } else
+    { thread_message *msgp = first;
+
+      for(i=0; i<count; i++, msgp=msgp->next)
+      { if ( msgp->bucket )
+	  unlink_message_key(queue, msgp);
+      }
+    }
+  }
+
+  return first;
+}
+
+
+/* A message_scan enumerates the messages in a queue that may unify with
+   a pattern in queue order.  If the pattern can be indexed and the queue
+   has an index we merge its key bucket and the wildcards, otherwise we
+   enumerate the entire queue.
+*/
+
+typedef struct message_scan
+{ thread_message *all;			/* Next in queue */
+  thread_message *keyed;		/* Next in key bucket */
+  thread_message *wild;			/* Next in wildcards */
+  int		  indexed;		/* Using the index */
+} message_scan;
+
+static void
+init_message_scan(message_scan *scan, message_queue *queue,
+		  word index_key)
+{ message_bucket *b;
+
+  if ( index_key && !queue->index &&
+       queue->size >= MSG_INDEX_MIN && queue->head->index_key != index_key )
+    create_message_index(queue);
+
+  if ( index_key && queue->index )
+  { scan->indexed = TRUE;
+    scan->all     = NULL;
+    scan->wild    = queue->index->wildcards.head;
+    if ( (b=lookup_message_bucket(queue->index, index_key)) )
+      scan->keyed = b->head;
+    else
+      scan->keyed = NULL;
+  } else
+  { scan->indexed = FALSE;
+    scan->all     = queue->head;
+    scan->keyed   = scan->wild = NULL;
+  }
+}
+
+static thread_message *
+next_message_scan(message_scan *scan)
+{ thread_message *msgp;
+
+  if ( !scan->indexed )
+  { if ( (msgp = scan->all) )
+      scan->all = msgp->next;
+  } else if ( scan->keyed &&
+	      (!scan->wild ||
+	       scan->keyed->sequence_id < scan->wild->sequence_id) )
+  { msgp = scan->keyed;
+    scan->keyed = msgp->next_key;
+  } else if ( (msgp = scan->wild) )
+  { scan->wild = msgp->next_key;
+  }
+
+  return msgp;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Queues created with fifo(true) hold their messages in a bounded lock-free
+multi-producer/multi-consumer ring (after Dmitry Vyukov).  Each cell has
+a sequence number: a cell at position `pos` may be filled if its sequence
+is `pos` and may be emptied if it is `pos+1`.  Producers and consumers
+claim positions using compare-and-swap on enqueue_pos and dequeue_pos.
+
+thread_send_message/2 and thread_get_message/2 on an anonymous fifo queue
+with an unbound message term use the ring without locking the queue.  The
+queue mutex and condition variables are only used if the ring is empty
+(get) or full (send).  All other operations lock the queue and use the
+normal code: get_message() and peek_message() first move messages from
+the ring to the queue's list, so the list always holds the oldest
+messages.
+
+Because messages may live in the ring as well   as in the list, the ring
+keeps `count`, the total number  of  messages   in  the  queue.  A sender
+reserves a place using compare-and-swap  on   `count`  before pushing a
+message and a consumer releases it  after   taking  a message from the
+ring or the list.  This bounds the queue  to `limit` messages: max_size
+if given and the capacity of the ring otherwise.
+
+Atom-GC marks the messages in the ring while holding the queue's gc_mutex
+and setting `marking`.  A consumer that finds `marking` set after taking
+a message synchronises with gc_mutex before freeing it.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define MSG_RING_SIZE 1024		/* Default capacity of fifo queues */
+
+typedef struct ring_cell
+{ size_t	      sequence;		/* Position + fill state */
+  thread_message     *message;		/* The message */
+} ring_cell;
+
+typedef struct message_ring
+{ size_t	      enqueue_pos;	/* Next position to fill */
+  char		      pad1[64-sizeof(size_t)];
+  size_t	      dequeue_pos;	/* Next position to empty */
+  char		      pad2[64-sizeof(size_t)];
+  size_t	      count;		/* # messages in ring and list */
+  char		      pad3[64-sizeof(size_t)];
+  size_t	      limit;		/* Max # messages */
+  size_t	      mask;		/* # cells - 1 */
+  int		      marking;		/* AGC is marking the ring */
+  ring_cell	     *cells;		/* Array of cells */
+} message_ring;
+
+
+static message_ring *
+create_message_ring(size_t size)
+{ message_ring *r = allocHeapOrHalt(sizeof(*r));
+  size_t cells = 2;
+  size_t i;
+
+  while ( cells < size )
+    cells *= 2;
+
+  memset(r, 0, sizeof(*r));
+  r->limit = size;
+  r->mask  = cells-1;
+  r->cells = allocHeapOrHalt(cells*sizeof(*r->cells));
+  for(i=0; i<cells; i++)
+  { r->cells[i].sequence = i;
+    r->cells[i].message  = NULL;
+  }
+
+  return r;
+}
+
+
+static int
+ring_push(message_ring *r, thread_message *msgp)
+{ size_t pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+  ring_cell *c;
+
+  for(;;)
+  { intptr_t dif;
+
+    c = &r->cells[pos & r->mask];
+    dif = (intptr_t)__atomic_load_n(&c->sequence, __ATOMIC_ACQUIRE) -
+	  (intptr_t)pos;
+
+    if ( dif == 0 )
+    { if ( COMPARE_AND_SWAP_SIZE(&r->enqueue_pos, pos, pos+1) )
+	break;
+    } else if ( dif < 0 )
+    { return FALSE;			/* full */
+    }
+    pos = __atomic_load_n(&r->enqueue_pos, __ATOMIC_RELAXED);
+  }
+
+  c->message = msgp;
+  __atomic_store_n(&c->sequence, pos+1, __ATOMIC_RELEASE);
+
+  return TRUE;
+}
+
+
+static thread_message *
+ring_pop(message_ring *r)
+{ size_t pos = __atomic_load_n(&r->dequeue_pos, __ATOMIC_RELAXED);
+  thread_message *msgp;
+  ring_cell *c;
+
+  for(;;)
+  { intptr_t dif;
+
+    c = &r->cells[pos & r->mask];
+    dif = (intptr_t)__atomic_load_n(&c->sequence, __ATOMIC_ACQUIRE) -
+	  (intptr_t)(pos+1);
+
+    if ( dif == 0 )
+    { if ( COMPARE_AND_SWAP_SIZE(&r->dequeue_pos, pos, pos+1) )
+	break;
+    } else if ( dif < 0 )
+    { return NULL;			/* empty */
+    }
+    pos = __atomic_load_n(&r->dequeue_pos, __ATOMIC_RELAXED);
+  }
+
+  msgp = c->message;
+  __atomic_store_n(&c->sequence, pos+r->mask+1, __ATOMIC_RELEASE);
+
+  return msgp;
+}
+
+
+/* ring_reserve() reserves a place for a new message.  ring_release()
+   gives back places of messages that were removed from the queue.
+*/
+
+static int
+ring_reserve(message_ring *r)
+{ size_t n;
+
+  do
+  { n = __atomic_load_n(&r->count, __ATOMIC_ACQUIRE);
+    if ( n >= r->limit )
+      return FALSE;
+  } while( !COMPARE_AND_SWAP_SIZE(&r->count, n, n+1) );
+
+  return TRUE;
+}
+
+
+static void
+ring_release(message_ring *r, size_t count)
+{ ATOMIC_SUB(&r->count, count);
+}
+
+
+/* ring_add() adds msgp to the ring if the queue is not full.
+*/
+
+static int
+ring_add(message_ring *r, thread_message *msgp)
+{ if ( !ring_reserve(r) )
+    return FALSE;
+  if ( !ring_push(r, msgp) )		/* a consumer did not yet */
+  { ring_release(r, 1);			/* release the cell */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+static size_t
+ring_count(message_ring *r)
+{ size_t deq = __atomic_load_n(&r->dequeue_pos, __ATOMIC_ACQUIRE);
+  size_t enq = __atomic_load_n(&r->enqueue_pos, __ATOMIC_ACQUIRE);
+
+  return enq > deq ? enq-deq : 0;
+}
+
+
+static void
+free_message_ring(message_queue *queue)
+{ message_ring *r;
+
+  if ( (r=queue->ring) )
+  { thread_message *msgp;
+
+    queue->ring = NULL;
+    while( (msgp=ring_pop(r)) )
+      free_thread_message(msgp);
+    freeHeap(r->cells, (r->mask+1)*sizeof(*r->cells));
+    freeHeap(r, sizeof(*r));
+  }
+}
+
+
+/* free_ring_message() frees a message taken from the ring without
+   holding the queue mutex.  See above.
+*/
+
+static void
+free_ring_message(message_queue *queue, thread_message *msgp)
+{ MEMORY_BARRIER();
+  if ( queue->ring->marking )
+  { simpleMutexLock(&queue->gc_mutex);
+    simpleMutexUnlock(&queue->gc_mutex);
+  }
+  free_thread_message(msgp);
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 queue_message() adds a message to a message queue.  The caller must hold
 the queue-mutex.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+/* queue_is_full() returns TRUE if msgp cannot be added to the queue.
+   For fifo queues it adds msgp to the ring if there is space.
+*/
+
 static int
-queue_message(message_queue *queue, thread_message *msgp,
-	      struct timespec *deadline ARG_LD)
-{ if ( queue->max_size > 0 && queue->size >= queue->max_size )
+queue_is_full(message_queue *queue, thread_message *msgp)
+{ if ( queue->ring )
+    return !ring_add(queue->ring, msgp);
+
+  return queue->max_size > 0 && queue->size >= queue->max_size;
+}
+
+
+static void
+append_message(message_queue *queue, thread_message *msgp)
+{ msgp->sequence_id = ++queue->sequence_next;
+  msgp->next = NULL;
+  if ( !queue->head )
+  { msgp->prev = NULL;
+    queue->head = queue->tail = msgp;
+  } else
+  { msgp->prev = queue->tail;
+    queue->tail->next = msgp;
+    queue->tail = msgp;
+  }
+  queue->size++;
+
+  if ( queue->index )
+    index_message(queue, msgp);
+}
+
+
+/* wakeup_readers() wakes up threads waiting for `count` new messages.
+*/
+
+static void
+wakeup_readers(message_queue *queue, size_t count)
+{ if ( queue->waiting )
+  { if ( queue->waiting > 1 &&
+	 (queue->waiting > queue->waiting_var || count > 1) )
+    { DEBUG(MSG_QUEUE,
+	    Sdprintf("%d: %d of %d non-var waiters on %p; broadcasting\n",
+		     PL_thread_self(),
+		     queue->waiting - queue->waiting_var,
+		     queue->waiting,
+		     queue));
+      cv_broadcast(&queue->cond_var);
+    } else
+    { DEBUG(MSG_QUEUE, Sdprintf("%d: %d waiters on %p; signalling\n",
+				PL_thread_self(), queue->waiting, queue));
+      cv_signal(&queue->cond_var);
+    }
+  } else
+  { DEBUG(MSG_QUEUE, Sdprintf("%d: no waiters on %p\n",
+			      PL_thread_self(), queue));
+  }
+}
+
+
+/* prepend_message() puts a message taken from the ring back in front of
+   the queue.  Used if ring_get_message() cannot copy it to the stack.
+   The message gets a sequence id below the head, which selective
+   readers may already have passed.  Bumping `requeued` makes them
+   rescan from the start.  Must be called with queue->mutex held.
+*/
+
+static void
+prepend_message(message_queue *queue, thread_message *msgp)
+{ simpleMutexLock(&queue->gc_mutex);
+  if ( !queue->head )
+  { append_message(queue, msgp);
+  } else
+  { destroy_message_index(queue);	/* rebuilt if needed */
+    msgp->sequence_id = queue->head->sequence_id-1;
+    msgp->prev = NULL;
+    msgp->next = queue->head;
+    queue->head->prev = msgp;
+    queue->head = msgp;
+    queue->size++;
+  }
+  queue->requeued++;
+  simpleMutexUnlock(&queue->gc_mutex);
+
+  wakeup_readers(queue, 1);
+}
+
+
+/* wait_queue_space() waits until msgp fits in the queue.  For fifo
+   queues msgp is added to the ring.  Returns TRUE or one of MSG_WAIT_*.
+*/
+
+static int
+wait_queue_space(message_queue *queue, thread_message *msgp,
+		 struct timespec *deadline ARG_LD)
+{ if ( queue_is_full(queue, msgp) )
   { queue->wait_for_drain++;
+    MEMORY_BARRIER();			/* see ring_get_message() */
 
-    while ( queue->size >= queue->max_size )
+    while ( queue_is_full(queue, msgp) )
     { switch ( dispatch_cond_wait(queue, QUEUE_WAIT_DRAIN, deadline PASS_LD) )
       { case CV_INTR:
 	{ if ( !LD )			/* needed for clean exit */
@@ -3683,38 +4345,111 @@ queue_message(message_queue *queue, thread_message *msgp,
     queue->wait_for_drain--;
   }
 
-  msgp->sequence_id = ++queue->sequence_next;
-  if ( !queue->head )
-  { queue->head = queue->tail = msgp;
-  } else
-  { queue->tail->next = msgp;
-    queue->tail = msgp;
+  return TRUE;
+}
+
+
+static int
+queue_message(message_queue *queue, thread_message *msgp,
+	      struct timespec *deadline ARG_LD)
+{ int rc;
+
+  if ( (rc=wait_queue_space(queue, msgp, deadline PASS_LD)) != TRUE )
+    return rc;
+
+  if ( !queue->ring )
+    append_message(queue, msgp);
+  wakeup_readers(queue, 1);
+
+  return TRUE;
+}
+
+
+/* queue_messages() adds `count` messages to the queue, waking up readers
+   once for all messages that fit.  If the queue is full, it wakes up the
+   readers for the messages added so far and waits for space.  `sent` is
+   the number of messages that were added.  The caller must hold the
+   queue-mutex.
+*/
+
+static int
+queue_messages(message_queue *queue, thread_message **msgs, size_t count,
+	       size_t *sent, struct timespec *deadline ARG_LD)
+{ size_t i, added = 0;
+  int rc = TRUE;
+
+  for(i=0; i<count; i++)
+  { if ( queue_is_full(queue, msgs[i]) )
+    { if ( added )
+      { wakeup_readers(queue, added);
+	added = 0;
+      }
+      if ( (rc=wait_queue_space(queue, msgs[i], deadline PASS_LD)) != TRUE )
+	break;
+    }
+    if ( !queue->ring )
+      append_message(queue, msgs[i]);
+    added++;
   }
-  queue->size++;
 
+  if ( added )
+    wakeup_readers(queue, added);
+  *sent = i;
+
+  return rc;
+}
+
+
+/* ring_send_message() is the lock-free path of thread_send_message/2 for
+   fifo queues.  Returns FALSE if the ring is full.
+*/
+
+static int
+ring_send_message(message_queue *queue, thread_message *msgp)
+{ if ( !ring_add(queue->ring, msgp) )
+    return FALSE;
+
+  MEMORY_BARRIER();
   if ( queue->waiting )
-  { if ( queue->waiting > queue->waiting_var && queue->waiting > 1 )
-    { DEBUG(MSG_QUEUE,
-	    Sdprintf("%d: %d of %d non-var waiters on %p; broadcasting\n",
-		     PL_thread_self(),
-		     queue->waiting - queue->waiting_var,
-		     queue->waiting,
-		     queue));
-      cv_broadcast(&queue->cond_var);
-    } else
-    { DEBUG(MSG_QUEUE, Sdprintf("%d: %d waiters on %p; signalling\n",
-				PL_thread_self(), queue->waiting, queue));
-      cv_signal(&queue->cond_var);
-    }
-  } else
-  { DEBUG(MSG_QUEUE, Sdprintf("%d: no waiters on %p\n",
-			      PL_thread_self(), queue));
+  { simpleMutexLock(&queue->mutex);
+    wakeup_readers(queue, 1);
+    simpleMutexUnlock(&queue->mutex);
   }
 
   return TRUE;
 }
 
 
+/* spill_message_ring() moves messages from the ring to the list of the
+   queue.  If `all` is FALSE it only moves a message if the list is empty.
+   Must be called with the queue mutex locked.
+*/
+
+static void
+spill_message_ring(message_queue *queue, int all)
+{ thread_message *msgp;
+  int moved = FALSE;
+
+  if ( !all && queue->head )
+    return;
+
+  simpleMutexLock(&queue->gc_mutex);	/* AGC must see the message */
+  while( (msgp = ring_pop(queue->ring)) )
+  { append_message(queue, msgp);
+    moved = TRUE;
+    if ( !all )
+      break;
+  }
+  simpleMutexUnlock(&queue->gc_mutex);
+
+  if ( moved )
+  { MEMORY_BARRIER();
+    if ( queue->wait_for_drain )
+      cv_broadcast(&queue->drain_var);
+  }
+}
+
+
 		 /*******************************
 		 *     READING FROM A QUEUE	*
 		 *******************************/
@@ -3988,9 +4723,12 @@ markAtomsMessageQueue() scans it. This fixes the reopened Bug#142.
 static int
 get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 { int isvar = PL_is_variable(msg) ? 1 : 0;
+  int plainvar = isvar && !PL_is_attvar(msg);
   word key = (isvar ? 0L : getIndexOfTerm(msg));
+  word index_key = message_index_key(msg, key PASS_LD);
   fid_t fid = PL_open_foreign_frame();
   uint64_t seen = 0;
+  uint64_t requeued = queue->requeued;
 
   QSTAT(getmsg);
 
@@ -4002,8 +4740,8 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 
   for(;;)
   { int rc;
-    thread_message *msgp = queue->head;
-    thread_message *prev = NULL;
+    thread_message *msgp;
+    message_scan scan;
 
     if ( queue->destroyed )
       return MSG_WAIT_DESTROYED;
@@ -4012,7 +4750,14 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 	  Sdprintf("%d: queue size=%ld\n",
 		   PL_thread_self(), (long)queue->size));
 
-    for( ; msgp; prev = msgp, msgp = msgp->next )
+    if ( queue->requeued != requeued )	/* see prepend_message() */
+    { requeued = queue->requeued;
+      seen = 0;
+    }
+    if ( queue->ring )
+      spill_message_ring(queue, !plainvar);
+    init_message_scan(&scan, queue, index_key);
+    while( (msgp = next_message_scan(&scan)) )
     { term_t tmp;
 
       if ( msgp->sequence_id < seen )
@@ -4056,18 +4801,8 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 	if (GD->atoms.gc_active)
 	  markAtomsRecord(msgp->message);
 
-        simpleMutexLock(&queue->gc_mutex);	/* see (*) */
-	if ( prev )
-	{ if ( !(prev->next = msgp->next) )
-	    queue->tail = prev;
-	} else
-	{ if ( !(queue->head = msgp->next) )
-	    queue->tail = NULL;
-	}
-        simpleMutexUnlock(&queue->gc_mutex);
-
+	unlink_message(queue, msgp);		/* see (*) */
 	free_thread_message(msgp);
-	queue->size--;
 	if ( queue->wait_for_drain )
 	{ DEBUG(MSG_QUEUE, Sdprintf("Queue drained. wakeup writers\n"));
 	  cv_signal(&queue->drain_var);
@@ -4085,6 +4820,14 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 
     queue->waiting++;
     queue->waiting_var += isvar;
+    if ( queue->ring )
+    { MEMORY_BARRIER();			/* see ring_send_message() */
+      if ( ring_count(queue->ring) > 0 )
+      { queue->waiting--;
+	queue->waiting_var -= isvar;
+	continue;
+      }
+    }
     DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: waiting on queue\n", PL_thread_self()));
     rc = dispatch_cond_wait(queue, QUEUE_WAIT_READ, deadline PASS_LD);
     switch ( rc )
@@ -4127,16 +4870,117 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
 }
 
 
+/* get_messages() implements thread_get_messages/3.  It waits for the
+   first message using get_message() and then takes up to max-1 more
+   messages that are available without waiting.  These are copied to the
+   stack before they are removed from the queue together.  Builds the
+   list of messages in `list`, which must be a fresh variable.  Must be
+   called with queue->mutex locked.  Returns the same values as
+   get_message().
+*/
+
+static int
+get_messages(message_queue *queue, term_t list, size_t max,
+	     struct timespec *deadline ARG_LD)
+{ term_t tail, head, first;
+  thread_message *msgp;
+  size_t n;
+  int rc;
+
+  if ( !(first = PL_new_term_ref()) ||
+       !(head  = PL_new_term_ref()) ||
+       !(tail  = PL_copy_term_ref(list)) )
+    return FALSE;
+
+  if ( (rc=get_message(queue, first, deadline PASS_LD)) != TRUE )
+    return rc;
+  if ( !PL_unify_list(tail, head, tail) ||
+       !PL_unify(head, first) )
+    return FALSE;
+
+  if ( queue->ring )
+    spill_message_ring(queue, TRUE);
+
+  for(n=0, msgp=queue->head; n<max-1 && msgp; n++, msgp=msgp->next)
+  { if ( !PL_recorded(msgp->message, first) ||
+	 !PL_unify_list(tail, head, tail) ||
+	 !PL_unify(head, first) )
+    { PL_clear_exception();		/* out of stack; return what we have */
+      break;
+    }
+
+    if ( GD->atoms.gc_active )
+      markAtomsRecord(msgp->message);
+  }
+
+  if ( n > 0 )
+  { size_t i;
+
+    msgp = unlink_messages(queue, n);
+    for(i=0; i<n; i++)
+    { thread_message *next = msgp->next;
+
+      free_thread_message(msgp);
+      msgp = next;
+    }
+
+    if ( queue->wait_for_drain )
+      cv_broadcast(&queue->drain_var);
+  }
+
+  return PL_unify_nil(tail);
+}
+
+
+/* ring_get_message() is the lock-free path of thread_get_message/2 for
+   fifo queues if the message term is a plain variable.  Returns -1 if
+   there is no message in the ring or older messages are in the list.
+*/
+
+static int
+ring_get_message(message_queue *queue, term_t msg ARG_LD)
+{ thread_message *msgp;
+  term_t tmp;
+
+  if ( queue->head || !(msgp = ring_pop(queue->ring)) )
+    return -1;
+
+  if ( !(tmp = PL_new_term_ref()) ||
+       !PL_recorded(msgp->message, tmp) )
+  { simpleMutexLock(&queue->mutex);
+    prepend_message(queue, msgp);	/* keeps its place */
+    simpleMutexUnlock(&queue->mutex);
+    return raiseStackOverflow(GLOBAL_OVERFLOW);
+  }
+
+  if ( GD->atoms.gc_active )
+    markAtomsRecord(msgp->message);
+  free_ring_message(queue, msgp);
+
+  ring_release(queue->ring, 1);
+  MEMORY_BARRIER();
+  if ( queue->wait_for_drain )
+  { simpleMutexLock(&queue->mutex);
+    cv_signal(&queue->drain_var);
+    simpleMutexUnlock(&queue->mutex);
+  }
+
+  return PL_unify(msg, tmp);
+}
+
+
 static int
 peek_message(message_queue *queue, term_t msg ARG_LD)
 { thread_message *msgp;
   term_t tmp = PL_new_term_ref();
   word key = getIndexOfTerm(msg);
   fid_t fid = PL_open_foreign_frame();
+  message_scan scan;
 
-  msgp = queue->head;
-
-  for( msgp = queue->head; msgp; msgp = msgp->next )
+  if ( queue->ring )
+    spill_message_ring(queue, TRUE);
+  init_message_scan(&scan, queue, message_index_key(msg, key PASS_LD));
+  while( (msgp = next_message_scan(&scan)) )
   { if ( key && msgp->key && key != msgp->key )
       continue;
 
@@ -4175,11 +5019,19 @@ destroy_message_queue(message_queue *queue)
 
     free_thread_message(msgp);
   }
+  queue->head = queue->tail = NULL;
+  destroy_message_index(queue);
+  if ( queue->ring )
+  { while( (msgp=ring_pop(queue->ring)) )
+      free_thread_message(msgp);
+  }
 
   simpleMutexDelete(&queue->gc_mutex);
   cv_destroy(&queue->cond_var);
-  if ( queue->max_size > 0 )
+  if ( queue->max_size > 0 || queue->ring )
     cv_destroy(&queue->drain_var);
+  if ( !queue->anonymous )		/* see release_message_queue_ref() */
+    free_message_ring(queue);
   if ( !queue->anonymous )
     simpleMutexDelete(&queue->mutex);
 }
@@ -4237,6 +5089,10 @@ sizeof_message_queue(message_queue *queue)
   { size += sizeof(*msgp);
     size += msgp->message->size;
   }
+  if ( queue->ring )
+  { size += sizeof(*queue->ring);
+    size += (queue->ring->mask+1)*sizeof(*queue->ring->cells);
+  }
   simpleMutexUnlock(&queue->gc_mutex);
 
   return size;
@@ -4370,6 +5226,9 @@ thread_send_message__LD(term_t queue, term_t msgterm,
   if ( !(msg = create_thread_message(msgterm PASS_LD)) )
     return PL_no_memory();
 
+  if ( (q=get_fifo_queue(queue PASS_LD)) && ring_send_message(q, msg) )
+    return TRUE;
+
   if ( !get_message_queue__LD(queue, &q PASS_LD) )
   { free_thread_message(msg);
     return FALSE;
@@ -4397,8 +5256,76 @@ PRED_IMPL("thread_send_message", 3, thread_send_message, 0)
   struct timespec deadline;
   struct timespec *dlop=NULL;
 
-  return process_deadline_options(A3,&deadline,&dlop)
-    &&   thread_send_message__LD(A1, A2, dlop PASS_LD);
+  return process_deadline_options(A3,&deadline,&dlop)
+    &&   thread_send_message__LD(A1, A2, dlop PASS_LD);
+}
+
+
+/* thread_send_messages(+Queue, +List) compiles all messages before
+   locking the queue and adds them using a single lock and wakeup, only
+   waiting if the queue is full.
+*/
+
+static
+PRED_IMPL("thread_send_messages", 2, thread_send_messages, 0)
+{ PRED_LD
+  term_t tail = PL_copy_term_ref(A2);
+  term_t head = PL_new_term_ref();
+  tmp_buffer buf;
+  thread_message **msgs;
+  size_t count, sent = 0;
+  message_queue *q;
+  int rc = FALSE;
+
+  initBuffer(&buf);
+  while( PL_get_list_ex(tail, head, tail) )
+  { thread_message *msg;
+
+    if ( !(msg = create_thread_message(head PASS_LD)) )
+    { PL_no_memory();
+      goto out;
+    }
+    addBuffer(&buf, msg, thread_message*);
+  }
+  if ( !PL_get_nil_ex(tail) )
+    goto out;
+
+  msgs  = baseBuffer(&buf, thread_message*);
+  count = entriesBuffer(&buf, thread_message*);
+  if ( count == 0 )
+  { rc = TRUE;
+    goto out;
+  }
+
+  if ( !get_message_queue__LD(A1, &q PASS_LD) )
+    goto out;
+
+  for(;;)
+  { size_t n;
+
+    rc = queue_messages(q, msgs+sent, count-sent, &n, NULL PASS_LD);
+    sent += n;
+
+    if ( rc == MSG_WAIT_INTR )
+    { if ( PL_handle_signals() >= 0 )
+	continue;
+      rc = FALSE;
+    } else if ( rc == MSG_WAIT_DESTROYED )
+    { rc = PL_existence_error("message_queue", A1);
+    }
+
+    break;
+  }
+  release_message_queue(q);
+
+out:
+  msgs  = baseBuffer(&buf, thread_message*);
+  count = entriesBuffer(&buf, thread_message*);
+  for( ; sent < count; sent++ )
+    free_thread_message(msgs[sent]);
+  discardBuffer(&buf);
+
+  return rc;
 }
 
 
@@ -4475,6 +5402,7 @@ release_message_queue_ref(atom_t aref)
   { destroy_message_queue(q);			/* can be called twice */
     if ( !q->destroyed )
       deleteHTable(queueTable, (void *)q->id);
+    free_message_ring(q);
     simpleMutexDelete(&q->mutex);
     PL_free(q);
   }
@@ -4537,7 +5465,7 @@ free_queue_symbol(void *name, void *value)
 
 
 static message_queue *
-unlocked_message_queue_create(term_t queue, long max_size)
+unlocked_message_queue_create(term_t queue, long max_size, int fifo)
 { GET_LD
   atom_t name = NULL_ATOM;
   message_queue *q;
@@ -4568,6 +5496,11 @@ unlocked_message_queue_create(term_t queue, long max_size)
   q = PL_malloc(sizeof(*q));
   init_message_queue(q, max_size);
   q->type = QTYPE_QUEUE;
+  if ( fifo )
+  { q->ring = create_message_ring(max_size > 0 ? max_size : MSG_RING_SIZE);
+    if ( max_size == 0 )
+      cv_init(&q->drain_var, NULL);
+  }
   if ( !id )
   { mqref ref;
     int new;
@@ -4665,6 +5598,27 @@ get_message_queue_unlocked__LD(term_t t, message_queue **queue ARG_LD)
 /* Get a message queue and lock it
 */
 
+/* get_fifo_queue() returns the queue if t is the handle of an anonymous
+   fifo queue.  Such queues can only be reclaimed by AGC after the handle
+   is gone, so we can use the ring without locking.
+*/
+
+static message_queue *
+get_fifo_queue(term_t t ARG_LD)
+{ PL_blob_t *type;
+  void *data;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &message_queue_blob )
+  { message_queue *q = ((mqref*)data)->queue;
+
+    if ( q->ring && !q->destroyed )
+      return q;
+  }
+
+  return NULL;
+}
+
+
 static int
 get_message_queue__LD(term_t t, message_queue **queue ARG_LD)
 { int rc;
@@ -4726,7 +5680,7 @@ PRED_IMPL("message_queue_create", 1, message_queue_create, 0)
 { int rval;
 
   PL_LOCK(L_THREAD);
-  rval = (unlocked_message_queue_create(A1, 0) ? TRUE : FALSE);
+  rval = (unlocked_message_queue_create(A1, 0, FALSE) ? TRUE : FALSE);
   PL_UNLOCK(L_THREAD);
 
   return rval;
@@ -4736,6 +5690,7 @@ PRED_IMPL("message_queue_create", 1, message_queue_create, 0)
 static const opt_spec message_queue_options[] =
 { { ATOM_alias,		OPT_ATOM },
   { ATOM_max_size,	OPT_SIZE },
+  { ATOM_fifo,		OPT_BOOL },
   { NULL_ATOM,		0 }
 };
 
@@ -4745,12 +5700,14 @@ PRED_IMPL("message_queue_create", 2, message_queue_create2, 0)
 { PRED_LD
   atom_t alias = 0;
   size_t max_size = 0;			/* to be processed */
+  int fifo = FALSE;
   message_queue *q;
 
   if ( !scan_options(A2, 0,
 		     ATOM_queue_option, message_queue_options,
 		     &alias,
-		     &max_size) )
+		     &max_size,
+		     &fifo) )
     fail;
 
   if ( alias )
@@ -4759,7 +5716,7 @@ PRED_IMPL("message_queue_create", 2, message_queue_create2, 0)
   }
 
   PL_LOCK(L_THREAD);
-  q = unlocked_message_queue_create(A1, max_size);
+  q = unlocked_message_queue_create(A1, max_size, fifo);
   PL_UNLOCK(L_THREAD);
 
   return q ? TRUE : FALSE;
@@ -4818,7 +5775,12 @@ message_queue_alias_property(message_queue *q, term_t prop ARG_LD)
 
 static int		/* message_queue_property(Queue, size(Size)) */
 message_queue_size_property(message_queue *q, term_t prop ARG_LD)
-{ return PL_unify_integer(prop, q->size);
+{ size_t size = q->size;
+
+  if ( q->ring )
+    size += ring_count(q->ring);
+
+  return PL_unify_integer(prop, size);
 }
 
 
@@ -4832,6 +5794,11 @@ message_queue_max_size_property(message_queue *q, term_t prop ARG_LD)
   fail;
 }
 
+static int		/* message_queue_property(Queue, fifo(Bool)) */
+message_queue_fifo_property(message_queue *q, term_t prop ARG_LD)
+{ return PL_unify_bool(prop, q->ring != NULL);
+}
+
 static int		/* message_queue_property(Queue, waiting(Count)) */
 message_queue_waiting_property(message_queue *q, term_t prop ARG_LD)
 { int waiting;
@@ -4847,6 +5814,7 @@ static const tprop qprop_list [] =
   { FUNCTOR_size1,	    message_queue_size_property },
   { FUNCTOR_max_size1,	    message_queue_max_size_property },
   { FUNCTOR_waiting1,	    message_queue_waiting_property },
+  { FUNCTOR_fifo1,	    message_queue_fifo_property },
   { 0,			    NULL }
 };
 
@@ -5063,17 +6031,30 @@ thread_get_message(-Message)
     a message from the queue implicitly associated to the thread.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+/* If max is 0, get a single message in msg.  Otherwise get a list of at
+   most max messages in msg (thread_get_messages/3).
+*/
+
 static int
-thread_get_message__LD(term_t queue, term_t msg, struct timespec *deadline ARG_LD)
+thread_get_message__LD(term_t queue, term_t msg, size_t max,
+		       struct timespec *deadline ARG_LD)
 { int rc;
+  message_queue *q;
 
-  for(;;)
-  { message_queue *q;
+  if ( max == 0 &&
+       (q=get_fifo_queue(queue PASS_LD)) &&
+       PL_is_variable(msg) && !PL_is_attvar(msg) &&
+       (rc=ring_get_message(q, msg PASS_LD)) >= 0 )
+    return rc;
 
-    if ( !get_message_queue__LD(queue, &q PASS_LD) )
+  for(;;)
+  { if ( !get_message_queue__LD(queue, &q PASS_LD) )
       return FALSE;
 
-    rc = get_message(q, msg, deadline PASS_LD);
+    if ( max == 0 )
+      rc = get_message(q, msg, deadline PASS_LD);
+    else
+      rc = get_messages(q, msg, max, deadline PASS_LD);
     release_message_queue(q);
 
     switch(rc)
@@ -5103,7 +6084,7 @@ static
 PRED_IMPL("thread_get_message", 2, thread_get_message, 0)
 { PRED_LD
 
-  return thread_get_message__LD(A1, A2, NULL PASS_LD);
+  return thread_get_message__LD(A1, A2, 0, NULL PASS_LD);
 }
 
 
@@ -5114,7 +6095,31 @@ PRED_IMPL("thread_get_message", 3, thread_get_message, 0)
   struct timespec *dlop=NULL;
 
   return process_deadline_options(A3,&deadline,&dlop)
-    &&   thread_get_message__LD(A1, A2, dlop PASS_LD);
+    &&   thread_get_message__LD(A1, A2, 0, dlop PASS_LD);
+}
+
+
+static const opt_spec get_messages_options[] =
+{ { ATOM_max,		OPT_SIZE },
+  { NULL_ATOM,		0 }
+};
+
+static
+PRED_IMPL("thread_get_messages", 3, thread_get_messages, 0)
+{ PRED_LD
+  struct timespec deadline;
+  struct timespec *dlop=NULL;
+  size_t max = (size_t)-1;
+  term_t list = PL_new_term_ref();
+
+  if ( !scan_options(A3, 0, ATOM_queue_option, get_messages_options, &max) )
+    return FALSE;
+  if ( max == 0 )
+    return PL_domain_error("max_messages", A3);
+
+  return ( process_deadline_options(A3,&deadline,&dlop) &&
+	   thread_get_message__LD(A1, list, max, dlop PASS_LD) &&
+	   PL_unify(A2, list) );
 }
 
 
@@ -5600,6 +6605,270 @@ out:
   return rc;
 }
 
+		 /*******************************
+		 *	  WORK POOL JOBS	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A pool job distributes a list of chunks of work over a fixed number of
+slots, where each slot is served by a thread from the pool of workers
+maintained by library(thread).  Each chunk is compiled into a record by
+'$pool_job_create'/3.  This includes the chunks that the calling thread
+runs itself: any chunk may be stolen by  a worker and workers cannot
+access the stacks of the caller.  The   chunks  are  initially divided
+evenly over the slots.  Each slot owns a range of chunk indexes.  It
+takes chunks from the start of its  own   range  and steals half of the
+largest remaining range from the end if its own range is empty.  The
+ranges are protected by a single mutex that is only held for a few
+instructions per chunk, so contention is low if chunks are sufficiently
+large.
+
+The job is a blob.  Its records are reclaimed by AGC after the caller
+and all workers have dropped the handle.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct job_range
+{ size_t	lo;			/* First chunk to execute */
+  size_t	hi;			/* Last chunk + 1 */
+} job_range;
+
+typedef struct pool_job
+{ simpleMutex	mutex;			/* Protects the ranges */
+  size_t	count;			/* # chunks */
+  size_t	slots;			/* # slots */
+  Record       *chunks;			/* Chunks of work */
+  job_range    *ranges;			/* Ranges owned by the slots */
+} pool_job;
+
+typedef struct pool_job_ref
+{ pool_job     *job;
+} pool_job_ref;
+
+
+static int
+write_pool_job(IOSTREAM *s, atom_t aref, int flags)
+{ pool_job_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<pool_job>(%p)", ref->job);
+  return TRUE;
+}
+
+
+static void
+free_pool_job(pool_job *job)
+{ size_t i;
+
+  for(i=0; i<job->count; i++)
+  { if ( job->chunks[i] )
+      freeRecord(job->chunks[i]);
+  }
+  simpleMutexDelete(&job->mutex);
+  freeHeap(job->chunks, job->count*sizeof(*job->chunks));
+  freeHeap(job->ranges, job->slots*sizeof(*job->ranges));
+  freeHeap(job, sizeof(*job));
+}
+
+
+static int
+release_pool_job(atom_t aref)
+{ pool_job_ref *ref = PL_blob_data(aref, NULL, NULL);
+
+  free_pool_job(ref->job);
+
+  return TRUE;
+}
+
+
+static PL_blob_t pool_job_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_UNIQUE,
+  "pool_job",
+  release_pool_job,
+  NULL,
+  write_pool_job
+};
+
+
+static int
+get_pool_job(term_t t, pool_job **jobp ARG_LD)
+{ PL_blob_t *type;
+  void *data;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &pool_job_blob )
+  { *jobp = ((pool_job_ref*)data)->job;
+    return TRUE;
+  }
+
+  return PL_type_error("pool_job", t);
+}
+
+
+static int
+get_job_slot(term_t t, pool_job *job, size_t *slot ARG_LD)
+{ size_t i;
+
+  if ( !PL_get_size_ex(t, &i) )
+    return FALSE;
+  if ( i >= job->slots )
+    return PL_domain_error("pool_job_slot", t);
+
+  *slot = i;
+  return TRUE;
+}
+
+
+/** '$pool_job_create'(+Chunks:list, +Slots:positive_integer, -Job)
+*/
+
+static
+PRED_IMPL("$pool_job_create", 3, pool_job_create, 0)
+{ PRED_LD
+  term_t tail = PL_copy_term_ref(A1);
+  term_t head = PL_new_term_ref();
+  pool_job_ref ref;
+  pool_job *job;
+  size_t count, slots, i;
+  intptr_t len;
+
+  if ( (len=lengthList(tail, TRUE)) < 0 )
+    return FALSE;
+  if ( !PL_get_size_ex(A2, &slots) )
+    return FALSE;
+  if ( slots == 0 )
+    return PL_domain_error("not_less_than_one", A2);
+  count = len;
+
+  job = allocHeapOrHalt(sizeof(*job));
+  memset(job, 0, sizeof(*job));
+  simpleMutexInit(&job->mutex);
+  job->count  = count;
+  job->slots  = slots;
+  job->chunks = allocHeapOrHalt(count*sizeof(*job->chunks));
+  job->ranges = allocHeapOrHalt(slots*sizeof(*job->ranges));
+  memset(job->chunks, 0, count*sizeof(*job->chunks));
+
+  for(i=0; PL_get_list(tail, head, tail); i++)
+  { if ( !(job->chunks[i] = compileTermToHeap(head, 0)) )
+    { free_pool_job(job);
+      return PL_no_memory();
+    }
+  }
+
+  for(i=0; i<slots; i++)
+  { job->ranges[i].lo = (count*i)/slots;
+    job->ranges[i].hi = (count*(i+1))/slots;
+  }
+
+  ref.job = job;
+  if ( PL_unify_blob(A3, &ref, sizeof(ref), &pool_job_blob) )
+    return TRUE;
+
+  free_pool_job(job);
+  return FALSE;
+}
+
+
+/** '$pool_job_next'(+Job, +Slot, -Index) is semidet.
+ *
+ * Get the 1-based index of the next chunk to execute for Slot.  Fails
+ * if there is no more work.
+ */
+
+static
+PRED_IMPL("$pool_job_next", 3, pool_job_next, 0)
+{ PRED_LD
+  pool_job *job = NULL;
+  size_t slot = 0, index = 0;
+  job_range *own;
+  int found = FALSE;
+
+  if ( !get_pool_job(A1, &job PASS_LD) ||
+       !get_job_slot(A2, job, &slot PASS_LD) )
+    return FALSE;
+
+  own = &job->ranges[slot];
+  simpleMutexLock(&job->mutex);
+  if ( own->lo == own->hi )
+  { job_range *victim = NULL;
+    size_t i, left = 0;
+
+    for(i=0; i<job->slots; i++)
+    { job_range *r = &job->ranges[i];
+
+      if ( r->hi - r->lo > left )
+      { left = r->hi - r->lo;
+	victim = r;
+      }
+    }
+
+    if ( victim )
+    { size_t steal = (left+1)/2;
+
+      own->hi = victim->hi;
+      own->lo = victim->hi - steal;
+      victim->hi = own->lo;
+    }
+  }
+  if ( own->lo < own->hi )
+  { index = own->lo++;
+    found = TRUE;
+  }
+  simpleMutexUnlock(&job->mutex);
+
+  return found && PL_unify_int64(A3, index+1);
+}
+
+
+/** '$pool_job_chunk'(+Job, +Index, -Chunk)
+*/
+
+static
+PRED_IMPL("$pool_job_chunk", 3, pool_job_chunk, 0)
+{ PRED_LD
+  pool_job *job = NULL;
+  size_t index;
+  term_t t;
+  int rc;
+
+  if ( !get_pool_job(A1, &job PASS_LD) ||
+       !PL_get_size_ex(A2, &index) )
+    return FALSE;
+  if ( index == 0 || index > job->count )
+    return PL_domain_error("pool_job_chunk", A2);
+
+  if ( !(t=PL_new_term_ref()) )
+    return FALSE;
+  if ( (rc=copyRecordToGlobal(t, job->chunks[index-1], ALLOW_GC PASS_LD)) < 0 )
+    return raiseStackOverflow(rc);
+
+  return PL_unify(A3, t);
+}
+
+
+/** '$pool_job_abort'(+Job)
+ *
+ * Discard all chunks that have not yet been handed out.
+ */
+
+static
+PRED_IMPL("$pool_job_abort", 1, pool_job_abort, 0)
+{ PRED_LD
+  pool_job *job = NULL;
+  size_t i;
+
+  if ( !get_pool_job(A1, &job PASS_LD) )
+    return FALSE;
+
+  simpleMutexLock(&job->mutex);
+  for(i=0; i<job->slots; i++)
+    job->ranges[i].hi = job->ranges[i].lo;
+  simpleMutexUnlock(&job->mutex);
+
+  return TRUE;
+}
+
+
 		 /*******************************
 		 *	 MUTEX PRIMITIVES	*
 		 *******************************/
@@ -6226,6 +7495,96 @@ PRED_IMPL("$gc_stop", 0, gc_stop, 0)
 }
 
 
+		 /*******************************
+		 *	  INDEX BUILDER		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The index builder is a  system  thread   that  fills  clause indexes for
+large predicates in the background. See  queueIndexJob() in pl-index.c.
+We use a separate thread rather  than  the   gc  thread  because  filling
+an index may take seconds and  threads   that  assert to the predicate
+wait for it while holding the  predicate   lock,  which  clause GC may
+need.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int IB_id = 0;
+static int IB_starting = 0;
+
+static rc_cancel
+cancelIndexBuilder(int tid)
+{ (void)tid;
+
+  pthread_mutex_lock(&GD->thread.index.mutex);
+  GD->thread.index.stop = TRUE;
+  pthread_cond_broadcast(&GD->thread.index.cond);
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+
+  return PL_THREAD_CANCEL_MUST_JOIN;
+}
+
+
+static void *
+IndexBuilderMain(void *closure)
+{ PL_thread_attr_t attrs = {0};
+#ifdef HAVE_SIGPROCMASK
+  sigset_t set;
+  allSignalMask(&set);
+  if ( GD->signals.sig_alert )
+    sigdelset(&set, GD->signals.sig_alert);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+  attrs.alias = "jit_index";
+  attrs.flags = PL_THREAD_NO_DEBUG|PL_THREAD_NOT_DETACHED;
+  set_os_thread_name_from_charp("jit_index");
+
+  if ( PL_thread_attach_engine(&attrs) > 0 )
+  { GET_LD
+    PL_thread_info_t *info = LD->thread.info;
+
+    IB_id = PL_thread_self();
+    info->cancel = cancelIndexBuilder;
+    runIndexJobs();
+    IB_id = 0;
+
+    set_thread_completion(info, TRUE, 0);
+    PL_thread_destroy_engine();
+    IB_starting = FALSE;
+  } else
+  { IB_starting = FALSE;		/* allow for a new attempt */
+    abortIndexJobs();			/* and release the waiters */
+  }
+
+  return NULL;
+}
+
+
+int
+startIndexBuilder(void)
+{ if ( IB_id <= 0 )
+  { if ( GD->bootsession || GD->thread.index.stop )
+      return FALSE;
+
+    if ( COMPARE_AND_SWAP_INT(&IB_starting, FALSE, TRUE) )
+    { pthread_attr_t attr;
+      pthread_t thr;
+      int rc;
+
+      pthread_attr_init(&attr);
+      rc = pthread_create(&thr, &attr, IndexBuilderMain, NULL);
+      pthread_attr_destroy(&attr);
+      if ( rc != 0 )
+      { IB_starting = FALSE;
+	return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+
 		 /*******************************
 		 *	     STATISTICS		*
 		 *******************************/
@@ -6750,10 +8109,28 @@ significantly better.
 static void
 markAtomsMessageQueue(message_queue *queue)
 { thread_message *msg;
+  message_ring *r;
 
   for(msg=queue->head; msg; msg=msg->next)
   { markAtomsRecord(msg->message);
   }
+
+  if ( (r=queue->ring) )		/* see free_ring_message() */
+  { size_t pos, end;
+
+    r->marking = TRUE;
+    MEMORY_BARRIER();
+    pos = __atomic_load_n(&r->dequeue_pos, __ATOMIC_ACQUIRE);
+    end = __atomic_load_n(&r->enqueue_pos, __ATOMIC_ACQUIRE);
+    for( ; pos < end; pos++ )
+    { ring_cell *c = &r->cells[pos & r->mask];
+
+      if ( __atomic_load_n(&c->sequence, __ATOMIC_ACQUIRE) == pos+1 )
+	markAtomsRecord(c->message->message);
+    }
+    MEMORY_BARRIER();
+    r->marking = FALSE;
+  }
 }
 
 
@@ -6925,6 +8302,9 @@ localiseDefinition(Definition def)
   clear(local, P_THREAD_LOCAL|P_DIRTYREG);	/* remains P_DYNAMIC */
   local->impl.clauses.first_clause = NULL;
   local->impl.clauses.clause_indexes = NULL;
+  local->clause_keys = NULL;
+  if ( local->key_filter != NO_KEY_FILTER )
+    local->key_filter = NULL;
   ATOMIC_INC(&GD->statistics.predicates);
   ATOMIC_ADD(&local->module->code_size, sizeof(*local));
   DEBUG(MSG_PROC_COUNT, Sdprintf("Localise %s\n", predicateName(def)));
@@ -7039,6 +8419,11 @@ isSignalledGCThread(int sig ARG_LD)
 { return PL_pending(sig);
 }
 
+int
+startIndexBuilder(void)
+{ return FALSE;
+}
+
 
 int
 PL_thread_self()
@@ -7321,12 +8706,43 @@ pl_atom_buckets_in_use(void)
 }
 
 
+#ifdef O_PLMT
+static Definition *
+add_predicate_in_use(Definition *buckets, size_t *szp, int *indexp,
+		     Definition def)
+{ if ( *indexp >= *szp-1 )
+  { int j = 0;
+    size_t oldsz = *szp;
+    size_t sz = oldsz*2;
+    Definition *newbuckets = allocHeapOrHalt(sz * sizeof(Definition));
+    memset(newbuckets, 0, sz * sizeof(Definition));
+    for ( ; j < oldsz; j++ )
+    { newbuckets[j] = buckets[j];
+    }
+    PL_free(buckets);
+    buckets = newbuckets;
+    *szp = sz;
+  }
+  buckets[*indexp] = def;
+  if ( buckets[*indexp] )	/* atom_bucket may have been released */
+    (*indexp)++;
+
+  return buckets;
+}
+#endif
+
+/* predicates_in_use() returns a 0-terminated array of the predicates
+   acquired by a thread (see acquire_def()) or referenced by a job of
+   the index builder (see queueIndexJob()).
+*/
+
 Definition*
 predicates_in_use(void)
 {
 #ifdef O_PLMT
   int i, index=0;
   size_t sz = 32;
+  index_job *job;
 
   Definition *buckets = allocHeapOrHalt(sz * sizeof(Definition));
   memset(buckets, 0, sz * sizeof(Definition*));
@@ -7334,24 +8750,17 @@ predicates_in_use(void)
   for(i=1; i<=GD->thread.highest_id; i++)
   { PL_thread_info_t *info = GD->thread.threads[i];
     if ( info && info->access.predicate )
-    { if ( index >= sz-1 )
-      { int j = 0;
-        size_t oldsz = sz;
-        sz *= 2;
-        Definition *newbuckets = allocHeapOrHalt(sz * sizeof(Definition));
-	memset(newbuckets, 0, sz * sizeof(Definition));
-	for ( ; j < oldsz; j++ )
-	{ newbuckets[j] = buckets[j];
-	}
-	PL_free(buckets);
-        buckets = newbuckets;
-      }
-      buckets[index] = info->access.predicate;
-      if ( buckets[index] )	/* atom_bucket may have been released */
-        index++;
-    }
+      buckets = add_predicate_in_use(buckets, &sz, &index,
+				     info->access.predicate);
   }
 
+  pthread_mutex_lock(&GD->thread.index.mutex);
+  if ( (job=GD->thread.index.running) )
+    buckets = add_predicate_in_use(buckets, &sz, &index, job->def);
+  for(job=GD->thread.index.jobs; job; job=job->next)
+    buckets = add_predicate_in_use(buckets, &sz, &index, job->def);
+  pthread_mutex_unlock(&GD->thread.index.mutex);
+
   return buckets;
 #endif
 
@@ -7594,9 +9003,11 @@ BeginPredDefs(thread)
 
   PRED_DEF("thread_send_message",    2,	thread_send_message,   PL_FA_ISO)
   PRED_DEF("thread_send_message",    3,	thread_send_message,   0)
+  PRED_DEF("thread_send_messages",   2,	thread_send_messages,  0)
   PRED_DEF("thread_get_message",     1,	thread_get_message,    PL_FA_ISO)
   PRED_DEF("thread_get_message",     2,	thread_get_message,    PL_FA_ISO)
   PRED_DEF("thread_get_message",     3,	thread_get_message,    PL_FA_ISO)
+  PRED_DEF("thread_get_messages",    3,	thread_get_messages,   0)
   PRED_DEF("thread_peek_message",    1,	thread_peek_message_1, PL_FA_ISO)
   PRED_DEF("thread_peek_message",    2,	thread_peek_message_2, PL_FA_ISO)
   PRED_DEF("message_queue_destroy",  1,	message_queue_destroy, PL_FA_ISO)
@@ -7605,6 +9016,11 @@ BeginPredDefs(thread)
   PRED_DEF("thread_update",	     2, thread_update,         META)
   PRED_DEF("thread_setconcurrency",  2,	thread_setconcurrency, 0)
 
+  PRED_DEF("$pool_job_create",	     3, pool_job_create,       0)
+  PRED_DEF("$pool_job_next",	     3, pool_job_next,	       0)
+  PRED_DEF("$pool_job_chunk",	     3, pool_job_chunk,	       0)
+  PRED_DEF("$pool_job_abort",	     1, pool_job_abort,	       0)
+
   PRED_DEF("$engine_create",	     3,	engine_create,	       0)
   PRED_DEF("engine_destroy",	     1,	engine_destroy,	       0)
   PRED_DEF("engine_next",	     2,	engine_next,	       0)
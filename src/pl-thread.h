@@ -160,7 +160,10 @@ typedef struct message_queue
 #endif
   struct thread_message   *head;	/* Head of message queue */
   struct thread_message   *tail;	/* Tail of message queue */
+  struct message_index *index;		/* Index for selective receive */
+  struct message_ring  *ring;		/* Lock-free buffer for fifo(true) */
   uint64_t	       sequence_next;	/* next for sequence id */
+  uint64_t	       requeued;	/* # messages put back at head */
   word		       id;		/* Id of the queue */
   size_t	       size;		/* # terms in queue */
   size_t	       max_size;	/* Max # terms in queue */
@@ -288,8 +291,23 @@ countingMutexUnlock(counting_mutex *cm)
 #define PL_UNLOCK(id) IF_MT(id, countingMutexUnlock(&_PL_mutexes[id]))
 #endif
 
-#define LOCKDEF(def)   PL_LOCK(L_PREDICATE)
-#define UNLOCKDEF(def) PL_UNLOCK(L_PREDICATE)
+/* Predicates normally share L_PREDICATE.  The shards of a sharded
+   predicate (see pl-shard.c) have a private mutex such that updates
+   to different shards do not contend.
+*/
+
+#define LOCKDEF(def) \
+	do { if ( unlikely((def)->mutex != NULL) ) \
+	       countingMutexLock((def)->mutex); \
+	     else \
+	       PL_LOCK(L_PREDICATE); \
+	   } while(0)
+#define UNLOCKDEF(def) \
+	do { if ( unlikely((def)->mutex != NULL) ) \
+	       countingMutexUnlock((def)->mutex); \
+	     else \
+	       PL_UNLOCK(L_PREDICATE); \
+	   } while(0)
 
 #define LOCKMODULE(module)	countingMutexLock((module)->mutex)
 #define UNLOCKMODULE(module)	countingMutexUnlock((module)->mutex)
@@ -575,6 +593,7 @@ void		markAccessedPredicates(PL_local_data_t *ld);
 int		cgc_thread_stats(cgc_stats *stats ARG_LD);
 int		signalGCThread(int sig);
 int		isSignalledGCThread(int sig ARG_LD);
+int		startIndexBuilder(void);
 
 		 /*******************************
 		 *	LD-USING FUNCTIONS	*
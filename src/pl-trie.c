@@ -204,6 +204,7 @@ trie_create(alloc_pool *pool)
     trie->magic = TRIE_MAGIC;
     trie->node_count = 1;		/* the root */
     trie->alloc_pool = pool;
+    init_alloc_arena(&trie->arena, pool);
   }
 
   return trie;
@@ -215,6 +216,7 @@ trie_destroy(trie *trie)
 { DEBUG(MSG_TRIE_GC, Sdprintf("Destroying trie %p\n", trie));
   trie->magic = TRIE_CMAGIC;
   trie_empty(trie);
+  destroy_alloc_arena(&trie->arena);
   free_to_pool(trie->alloc_pool, trie, sizeof(*trie));
 }
 
@@ -246,7 +248,9 @@ trie_empty(trie *trie)
   if ( !trie->references )
   { indirect_table *it = trie->indirects;
 
+    trie->arena.discarding = TRUE;		/* no need to free the nodes */
     clear_node(trie, &trie->root, FALSE);	/* TBD: verify not accessed */
+    empty_alloc_arena(&trie->arena);
     if ( it && COMPARE_AND_SWAP_PTR(&trie->indirects, it, NULL) )
       destroy_indirect_table(it);
     trie->node_count = 1;
@@ -306,7 +310,7 @@ static trie_node *
 new_trie_node(trie *trie, word key)
 { trie_node *n;
 
-  if ( (n = alloc_from_pool(trie->alloc_pool, sizeof(*n))) )
+  if ( (n = alloc_from_arena(&trie->arena, sizeof(*n))) )
   { ATOMIC_INC(&trie->node_count);
     memset(n, 0, sizeof(*n));
     acquire_key(key);
@@ -333,7 +337,7 @@ next:
 
   if ( dealloc )
   { ATOMIC_DEC(&trie->node_count);
-    free_to_pool(trie->alloc_pool, n, sizeof(trie_node));
+    free_to_arena(&trie->arena, n, sizeof(trie_node));
   } else
   { n->children.any = NULL;
     clear(n, TN_PRIMARY|TN_SECONDARY);
@@ -343,7 +347,7 @@ next:
   { switch( children.any->type )
     { case TN_KEY:
       { n = children.key->child;
-	free_to_pool(trie->alloc_pool, children.key, sizeof(*children.key));
+	free_to_arena(&trie->arena, children.key, sizeof(*children.key));
 	dealloc = TRUE;
 	goto next;
       }
@@ -354,8 +358,8 @@ next:
 	trie_children_key *os;
 
 	if ( (os=children.hash->old_single) )	/* see insert_child() (*) note */
-	  free_to_pool(trie->alloc_pool, os, sizeof(*os));
-	free_to_pool(trie->alloc_pool, children.hash, sizeof(*children.hash));
+	  free_to_arena(&trie->arena, os, sizeof(*os));
+	free_to_arena(&trie->arena, children.hash, sizeof(*children.hash));
 
 	while(advanceTableEnum(e, &k, &v))
 	{ clear_node(trie, v, TRUE);
@@ -391,6 +395,8 @@ prune_node(trie *trie, trie_node *n)
   for(; empty && n->parent && false(n, TN_PRIMARY|TN_SECONDARY); n = p)
   { trie_children children;
 
+    if ( !trie )
+      trie = get_trie_from_node(n);
     p = n->parent;
     children = p->children;
 
@@ -398,7 +404,7 @@ prune_node(trie *trie, trie_node *n)
     { switch( children.any->type )
       { case TN_KEY:
 	  if ( COMPARE_AND_SWAP_PTR(&p->children.any, children.any, NULL) )
-	    PL_free(children.any);
+	    free_to_arena(&trie->arena, children.key, sizeof(*children.key));
 	  break;
 	case TN_HASHED:
 	  deleteHTable(children.hash->table, (void*)n->key);
@@ -407,8 +413,6 @@ prune_node(trie *trie, trie_node *n)
       }
     }
 
-    if ( !trie )
-      trie = get_trie_from_node(n);
     destroy_node(trie, n);
   }
 }
@@ -480,7 +484,7 @@ prune_trie(trie *trie, trie_node *root,
       { switch( children.any->type )
 	{ case TN_KEY:
 	    if ( COMPARE_AND_SWAP_PTR(&p->children.any, children.any, NULL) )
-	      PL_free(children.any);
+	      free_to_arena(&trie->arena, children.key, sizeof(*children.key));
 	    break;
 	  case TN_HASHED:
 	    deleteHTable(children.hash->table, (void*)n->key);
@@ -567,7 +571,7 @@ insert_child(trie *trie, trie_node *n, word key ARG_LD)
 	  } else
 	  { trie_children_hashed *hnode;
 
-	    if ( !(hnode=alloc_from_pool(trie->alloc_pool, sizeof(*hnode))) )
+	    if ( !(hnode=alloc_from_arena(&trie->arena, sizeof(*hnode))) )
 	    { destroy_node(trie, new);
 	      return NULL;
 	    }
@@ -589,7 +593,7 @@ insert_child(trie *trie, trie_node *n, word key ARG_LD)
 	    { hnode->old_single = NULL;
 	      destroy_node(trie, new);
 	      destroyHTable(hnode->table);
-	      free_to_pool(trie->alloc_pool, hnode, sizeof(*hnode));
+	      free_to_arena(&trie->arena, hnode, sizeof(*hnode));
 	      continue;
 	    }
 	  }
@@ -612,7 +616,7 @@ insert_child(trie *trie, trie_node *n, word key ARG_LD)
     } else
     { trie_children_key *child;
 
-      if ( !(child=alloc_from_pool(trie->alloc_pool, sizeof(*child))) )
+      if ( !(child=alloc_from_arena(&trie->arena, sizeof(*child))) )
       { destroy_node(trie, new);
 	return NULL;
       }
@@ -626,7 +630,7 @@ insert_child(trie *trie, trie_node *n, word key ARG_LD)
 	return child->child;
       }
       destroy_node(trie, new);
-      free_to_pool(trie->alloc_pool, child, sizeof(*child));
+      free_to_arena(&trie->arena, child, sizeof(*child));
     }
   }
 }
@@ -2402,6 +2406,12 @@ PRED_IMPL("$trie_property", 2, trie_property, 0)
 	// assert(stats.nodes  == trie->node_count);
 	// assert(stats.values == trie->value_count);
 	return PL_unify_int64(arg, stats.bytes);
+      } else if ( name == ATOM_memory_slabs )
+      { return PL_unify_int64(arg, trie->arena.slab_count);
+      } else if ( name == ATOM_memory_slab_size )
+      { return PL_unify_int64(arg, trie->arena.slab_bytes);
+      } else if ( name == ATOM_memory_slab_used )
+      { return PL_unify_int64(arg, trie->arena.in_use);
       } else if ( name == ATOM_compiled_size )
       { atom_t dbref;
 	if ( (dbref = trie->clause) )
@@ -117,6 +117,7 @@ typedef struct trie
   indirect_table       *indirects;	/* indirect values */
   void		      (*release_node)(struct trie *, trie_node *);
   alloc_pool	       *alloc_pool;	/* Node allocation pool */
+  alloc_arena		arena;		/* Slabs for nodes (from alloc_pool) */
   atom_t		clause;		/* Compiled representation */
 #ifdef O_TRIE_STATS
   struct
@@ -1194,16 +1194,20 @@ VMI(B_VAR, VIF_LCO, 1, (CA1_VAR), (p))
 }
 END_VMI
 
+#define PUSH_BVAR(voffset) \
+	do \
+	{ Word p = varFrameP(FR, voffset); \
+	  if ( isVar(*p) ) \
+	  { ENSURE_GLOBAL_SPACE(1, p = varFrameP(FR, voffset)); \
+	    globaliseVar(p); \
+	    *ARGP++ = *p; \
+	  } else \
+	  { *ARGP++ = linkValI(p); \
+	  } \
+	} while(0)
+
 VMH(bvar_cont, 1, (int), (voffset))
-{ Word p;
-  p = varFrameP(FR, voffset);
-  if ( isVar(*p) )
-  { ENSURE_GLOBAL_SPACE(1, p = varFrameP(FR, voffset));
-    globaliseVar(p);
-    *ARGP++ = *p;
-  } else
-  { *ARGP++ = linkValI(p);
-  }
+{ PUSH_BVAR(voffset);
   NEXT_INSTRUCTION;
 }
 END_VMH
@@ -3479,6 +3483,23 @@ VMI(S_THREAD_LOCAL, 0, 0, (), ())
 END_VMI
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+S_SHARD: Sharded dynamic predicate. Continue in  the shard selected by
+the shard argument or, if this is unbound, in the predicate that calls
+all shards (see pl-shard.c).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(S_SHARD, 0, 0, (), ())
+{ DEF = shardDefinition(DEF, argFrameP(FR, 0) PASS_LD);
+  setFramePredicate(FR, DEF);
+  setGenerationFrame(FR);
+
+  PC = DEF->codes;
+  NEXT_INSTRUCTION;
+}
+END_VMI
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Supervisor for an  incremental  dynamic  predicate.   Must  call  the  C
 equivalent   of   '$idg_add_dyncall'/1.   We   must    create   a   term
@@ -4127,6 +4148,59 @@ VMI(A_MUL, 0, 0, (), ())
 END_VMI
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A_ADD_F, A_SUB_F, A_MUL_F, A_DIV_F: +, -, * and / for which the compiler
+inferred that an argument is a float: it is a float constant, a variable
+tested with float/1 or an expression yielding a float (see
+compileArithArgument()).  If one operand is a float and the other a float
+or small integer, the operation is done on C doubles and the result is
+stored in place on the arithmetic stack.  Anything else, including results
+that are not normal floats, is handed to the generic function `fn`, which
+applies the float flags.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define AR_FLOAT_ARG(n, d) \
+	( (n)->type == V_FLOAT   ? ((d) = (n)->value.f, TRUE) : \
+	  (n)->type == V_INTEGER ? ((d) = (double)(n)->value.i, TRUE) : \
+				   FALSE )
+
+#define AR_FLOAT_OP(op, cond) \
+  { Number argv = argvArithStack(2 PASS_LD); \
+    double f1, f2; \
+    if ( (argv[0].type == V_FLOAT || argv[1].type == V_FLOAT) && \
+	 AR_FLOAT_ARG(argv+1, f1) && AR_FLOAT_ARG(argv, f2) && (cond) ) \
+    { double r = f1 op f2; \
+      if ( likely(fpclassify(r) == FP_NORMAL || r == 0.0) ) \
+      { popArgvArithStack(1 PASS_LD); \
+	argv->value.f = r; \
+	argv->type    = V_FLOAT; \
+	NEXT_INSTRUCTION; \
+      } \
+    } \
+    VMH_GOTO(common_an, fn, 2); \
+  }
+
+VMI(A_ADD_F, 0, 1, (CA1_AFUNC), (fn))
+{ AR_FLOAT_OP(+, TRUE);
+}
+END_VMI
+
+VMI(A_SUB_F, 0, 1, (CA1_AFUNC), (fn))
+{ AR_FLOAT_OP(-, TRUE);
+}
+END_VMI
+
+VMI(A_MUL_F, 0, 1, (CA1_AFUNC), (fn))
+{ AR_FLOAT_OP(*, TRUE);
+}
+END_VMI
+
+VMI(A_DIV_F, 0, 1, (CA1_AFUNC), (fn))
+{ AR_FLOAT_OP(/, f2 != 0.0 && isfinite(f2));
+}
+END_VMI
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 A_ADD_FC: Simple case A is B + <int>, where   A is a firstvar and B is a
 normal variable. This case is very   common,  especially with relatively
@@ -5473,7 +5547,7 @@ undefined predicate for call/N.
 VMH(i_usercall_common, 3, (Word, int, bool), (a, callargs, is_call0))
 { word goal;
   int arity = 0;
-  functor_t functor = -1;
+  word key = 0;				/* goal functor or atom */
   Word args;
   Module module = NULL;
   closure *clsp = NULL;
@@ -5486,7 +5560,7 @@ VMH(i_usercall_common, 3, (Word, int, bool), (a, callargs, is_call0))
   { Atom ap = atomValue(goal);
 
     if ( true(ap->type, PL_BLOB_TEXT) || goal == ATOM_nil )
-    { functor = lookupFunctorDef(goal, callargs);
+    { key     = goal;
       arity   = 0;
       args    = NULL;
     } else if ( ap->type == &_PL_closure_blob )
@@ -5498,11 +5572,11 @@ VMH(i_usercall_common, 3, (Word, int, bool), (a, callargs, is_call0))
   { FunctorDef fd;
     Functor gt = valueTerm(goal);
 
-    functor = gt->definition;
-    if ( is_call0 && functor == FUNCTOR_colon2 )
+    key = gt->definition;
+    if ( is_call0 && key == FUNCTOR_colon2 )
       VMH_GOTO(call_type_error);
 
-    fd = valueFunctor(functor);
+    fd = valueFunctor(key);
     if ( !isCallableAtom(fd->name) )
     { Atom ap = atomValue(fd->name);
 
@@ -5516,8 +5590,6 @@ VMH(i_usercall_common, 3, (Word, int, bool), (a, callargs, is_call0))
     arity = (int)fd->arity;
     if ( arity + callargs > MAXARITY )
       VMH_GOTO(max_arity_overflow);
-    if (!is_call0)
-      functor = lookupFunctorDef(fd->name, arity + callargs);
 
     if ( is_call0 ) /* checks unique to the I_USERCALL0 case */
     { if ( false(fd, CONTROL_F) &&
@@ -5634,11 +5706,11 @@ to be called to get the context module   right. We must build a complete
 environment before we can call trapUndefined() to make shift/GC happy.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-  assert(clsp != NULL || functor >= 0);
+  assert(clsp != NULL || key);
   if ( clsp )
   { DEF = &clsp->def;
   } else
-  { DEF = resolveProcedure(functor, module)->definition;
+  { DEF = resolveCallSite(PC, key, callargs, module PASS_LD)->definition;
   }
 
   VMH_GOTO(mcall_cont, module);
@@ -6782,3 +6854,165 @@ next_choice:
 }
 END_VMH
 
+
+		 /*******************************
+		 *      SUPERINSTRUCTIONS	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Superinstructions combine frequent sequences  of instructions, selected
+by profiling a COUNTING build (see '$count'/0).  They are introduced  by
+fuseInstructions() in pl-comp.c, which only replaces the opcode of the
+first instruction of the sequence.  A superinstruction thus has the same
+arguments as its first instruction, which is what decode() returns for
+it, and the code remains valid for all code walkers.
+
+After the first instruction, the superinstruction uses NEXT_FUSED() to
+jump directly to the next one, avoiding the indirect dispatch.  Slow
+paths simply re-execute the first instruction using VMI_GOTO().  As the
+opcode of the next instruction is still in place, this is followed by a
+normal dispatch.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(H_ATOM_EXITFACT, 0, 1, (CA1_DATA), (c))
+{ Word k;
+
+  IF_WRITE_MODE_GOTO(H_ATOM, c);
+
+  pushVolatileAtom(c);
+  deRef2(ARGP, k);
+  if ( *k == c )
+  { ARGP++;
+    NEXT_FUSED(I_EXITFACT);
+  }
+  if ( canBind(*k) )
+  { ENSURE_GLOBAL_SPACE(0, deRef2(ARGP, k));
+    bindConst(k, c);
+    ARGP++;
+    NEXT_FUSED(I_EXITFACT);
+  }
+  CLAUSE_FAILED;
+}
+END_VMI
+
+VMI(H_FIRSTVAR_POP, 0, 1, (CA1_FVAR), (v))
+{ if ( UMODE == uwrite )
+  { setVar(*ARGP);
+    *v = makeRefG(ARGP);
+  } else
+  { *v = (needsRef(*ARGP) ? makeRefG(ARGP) : *ARGP);
+  }
+  ARGP++;
+  NEXT_FUSED(H_POP);
+}
+END_VMI
+
+VMI(H_POP_ENTER, 0, 0, (), ())
+{ ARGP = *--aTop;
+  UMODE = ((int)(uintptr_t)ARGP & uwrite);
+  ARGP = (Word)((intptr_t)ARGP&~uwrite);
+  NEXT_FUSED(I_ENTER);
+}
+END_VMI
+
+VMI(I_ENTER_NOLCO, VIF_BREAK, 0, (), ())
+{ if ( unlikely(LD->alerted) )
+    VMI_GOTO(I_ENTER);
+
+  ARGP = argFrameP(lTop, 0);
+  NEXT_FUSED(L_NOLCO);
+}
+END_VMI
+
+VMI(I_ENTER_VAR0_CALL, VIF_BREAK, 0, (), ())
+{ if ( unlikely(LD->alerted) )
+    VMI_GOTO(I_ENTER);
+
+  ARGP = argFrameP(lTop, 0);
+  NEXT_FUSED(B_VAR0_CALL);
+}
+END_VMI
+
+VMI(B_VAR0_CALL, VIF_LCO, 0, (), ())
+{ VMH_GOTO(bvar_call, VAROFFSET(0));
+}
+END_VMI
+
+VMI(B_VAR1_CALL, VIF_LCO, 0, (), ())
+{ VMH_GOTO(bvar_call, VAROFFSET(1));
+}
+END_VMI
+
+VMI(B_VAR_CALL, VIF_LCO, 1, (CA1_VAR), (p))
+{ VMH_GOTO(bvar_call, ARG_VARNUM(p));
+}
+END_VMI
+
+VMH(bvar_call, 1, (int), (voffset))
+{ PUSH_BVAR(voffset);
+  NEXT_FUSED(I_CALL);
+}
+END_VMH
+
+VMI(B_VAR1_VAR_CALL, VIF_LCO, 0, (), ())
+{ VMH_GOTO(bvar_var_call, VAROFFSET(1));
+}
+END_VMI
+
+VMI(B_VAR2_VAR_CALL, VIF_LCO, 0, (), ())
+{ VMH_GOTO(bvar_var_call, VAROFFSET(2));
+}
+END_VMI
+
+VMH(bvar_var_call, 1, (int), (voffset))
+{ PUSH_BVAR(voffset);
+  NEXT_FUSED(B_VAR_CALL);
+}
+END_VMH
+
+VMI(B_NEQ_VV_EXIT, VIF_BREAK, 2, (CA1_VAR,CA1_VAR), (v1, v2))
+{ int rc;
+
+#ifdef O_DEBUGGER
+  if ( debugstatus.debugging )
+    VMI_GOTO(B_NEQ_VV, v1, v2);
+#endif
+
+  if ( (rc=compareStandard(v1, v2, TRUE PASS_LD)) == 0 )
+    FASTCOND_FAILED;
+  if ( rc == CMP_ERROR )
+    THROW_EXCEPTION;
+
+  NEXT_FUSED(I_EXIT);
+}
+END_VMI
+
+VMI(L_VAR_TCALL, 0, 2, (CA1_FVAR,CA1_VAR), (v1, v2))
+{ word w = *v2;
+
+  while(isRef(w))
+  { v2 = unRef(w);
+    if ( needsRef(*v2) )
+      break;
+    w = *v2;
+  }
+
+  *v1 = w;
+  NEXT_FUSED(I_TCALL);
+}
+END_VMI
+
+VMI(L_VAR_VAR_TCALL, 0, 2, (CA1_FVAR,CA1_VAR), (v1, v2))
+{ word w = *v2;
+
+  while(isRef(w))
+  { v2 = unRef(w);
+    if ( needsRef(*v2) )
+      break;
+    w = *v2;
+  }
+
+  *v1 = w;
+  NEXT_FUSED(L_VAR_TCALL);
+}
+END_VMI
@@ -64,7 +64,9 @@
 #include "pl-supervisor.h"
 #include "pl-index.h"
 #include "pl-cont.h"
+#include "pl-shard.h"
 #include <fenv.h>
+#include <math.h>
 #ifdef _MSC_VER
 #pragma warning(disable: 4102)		/* unreferenced labels */
 #endif
@@ -86,36 +88,79 @@ The counting code has been added   while investigating the time critical
 WAM  instructions.  The  current  implementation  runs  on  top  of  the
 information  provided  by  code_info   (from    pl-comp.c)   and  should
 automatically addapt to modifications in the VM instruction set.
+
+Besides the instructions, we count the number of dispatches as well as
+pairs and triples of instructions that are executed in sequence and are
+adjacent in the code.  These are the candidates for superinstructions
+(see initVMIMerge() in pl-comp.c).  Build using -DCOUNTING=1 and use
+'$count'/0 to print the result and '$count_reset'/0 to reset the counts.
+The counters are not thread-safe.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 typedef struct
 { code  code;
-  int	times;
-  int  *vartimesptr;
+  int64_t times;
+  int64_t *vartimesptr;
 } count_info;
 
+typedef struct
+{ code	  codes[3];			/* Instruction sequence */
+  int64_t times;			/* # times executed */
+} count_seq;
+
 #define MAXVAR 8
+#define MAXTRIPLES 4096			/* must be power of 2 */
+#define SHOWSEQ 25			/* # sequences to print */
 
 static count_info counting[I_HIGHEST];
+static int64_t	  pair_counts[I_HIGHEST][I_HIGHEST];
+static count_seq  triple_counts[MAXTRIPLES];
+static int64_t	  dispatch_count;
+static Code	  count_next_pc;	/* PC of next adjacent instruction */
+static code	  count_prev[2] = {I_HIGHEST, I_HIGHEST};
+
+#define countDispatch() (dispatch_count++)
+
+static void
+countTriple(code c1, code c2, code c3)
+{ unsigned int key = (unsigned int)((c1*I_HIGHEST+c2)*I_HIGHEST+c3);
+  unsigned int i = (key*2654435761U) & (MAXTRIPLES-1);
+  int n;
+
+  for(n=0; n<MAXTRIPLES; n++, i = (i+1)&(MAXTRIPLES-1))
+  { count_seq *t = &triple_counts[i];
+
+    if ( t->times == 0 )
+    { t->codes[0] = c1;
+      t->codes[1] = c2;
+      t->codes[2] = c3;
+    } else if ( t->codes[0] != c1 || t->codes[1] != c2 || t->codes[2] != c3 )
+    { continue;
+    }
+    t->times++;
+    return;
+  }
+}
 
 static void
 count(code c, Code PC)
 { const code_info *info = &codeTable[c];
+  Code op = PC-1;
 
   counting[c].times++;
-  switch(info->argtype)
+  switch(info->argtype[0])
   { case CA1_VAR:
     case CA1_FVAR:
     case CA1_CHP:
     { int v = (int)*PC;
 
-      v -= ARGOFFSET/sizeof(word);
+      v -= VAROFFSET(0);
       assert(v>=0);
       if ( v >= MAXVAR )
 	v = MAXVAR-1;
 
       if ( !counting[c].vartimesptr )
-      { int bytes = sizeof(int)*MAXVAR;
+      { int bytes = sizeof(int64_t)*MAXVAR;
 
 	counting[c].vartimesptr = allocHeapOrHalt(bytes);
 	memset(counting[c].vartimesptr, 0, bytes);
@@ -123,21 +168,39 @@ count(code c, Code PC)
       counting[c].vartimesptr[v]++;
     }
   }
+
+  if ( !can_decode(*op) || (*op != encode(c) && fetchop(op) != c) )
+  { count_next_pc = NULL;		/* entered through VMI_GOTO() */
+    count_prev[1] = I_HIGHEST;
+    return;
+  }
+
+  if ( op == count_next_pc )
+  { pair_counts[count_prev[1]][c]++;
+    if ( count_prev[0] != I_HIGHEST )
+      countTriple(count_prev[0], count_prev[1], c);
+    count_prev[0] = count_prev[1];
+  } else
+  { count_prev[0] = I_HIGHEST;
+  }
+  count_prev[1] = c;
+  count_next_pc = stepPC(op);
 }
 
 
 static void
 countHeader()
-{ int m;
+{ GET_LD
+  int m;
   int amax = MAXVAR;
   char last[20];
 
-  Sfprintf(Scurout, "%-13s %8s ", "Instruction", "times");
+  Sfprintf(Scurout, "%-13s %10s ", "Instruction", "times");
   for(m=0; m < amax-1; m++)
     Sfprintf(Scurout, " %8d", m);
   Ssprintf(last, ">%d", m);
   Sfprintf(Scurout, " %8s\n", last);
-  for(m=0; m<(31+amax*8); m++)
+  for(m=0; m<(33+amax*8); m++)
     Sputc('=', Scurout);
   Sfprintf(Scurout, "\n");
 }
@@ -148,44 +211,124 @@ cmpcounts(const void *p1, const void *p2)
 { const count_info *c1 = p1;
   const count_info *c2 = p2;
 
-  return c2->times - c1->times;
+  return c2->times > c1->times ? 1 : c2->times < c1->times ? -1 : 0;
+}
+
+
+static int
+cmpseqs(const void *p1, const void *p2)
+{ const count_seq *c1 = p1;
+  const count_seq *c2 = p2;
+
+  return c2->times > c1->times ? 1 : c2->times < c1->times ? -1 : 0;
+}
+
+
+static void
+printSeqs(const char *title, count_seq *seqs, size_t count, int len)
+{ GET_LD
+  size_t i;
+
+  qsort(seqs, count, sizeof(*seqs), cmpseqs);
+  Sfprintf(Scurout, "\n%-40s %12s\n", title, "times");
+  for(i=0; i<count && i<SHOWSEQ && seqs[i].times; i++)
+  { char buf[100];
+
+    if ( len == 2 )
+      Ssprintf(buf, "%s + %s",
+	       codeTable[seqs[i].codes[0]].name,
+	       codeTable[seqs[i].codes[1]].name);
+    else
+      Ssprintf(buf, "%s + %s + %s",
+	       codeTable[seqs[i].codes[0]].name,
+	       codeTable[seqs[i].codes[1]].name,
+	       codeTable[seqs[i].codes[2]].name);
+    Sfprintf(Scurout, "%-40s %12" PRId64 "\n", buf, seqs[i].times);
+  }
 }
 
 
 word
 pl_count()
-{ int i;
+{ GET_LD
+  int i, j;
   count_info counts[I_HIGHEST];
   count_info *c;
+  count_seq *seqs;
+  size_t nseqs = 0;
+  int64_t total = 0;
 
   countHeader();
 
   memcpy(counts, counting, sizeof(counts));
   for(i=0, c=counts; i<I_HIGHEST; i++, c++)
-    c->code = i;
+  { c->code = i;
+    total += c->times;
+  }
   qsort(counts, I_HIGHEST, sizeof(count_info), cmpcounts);
 
-  for(c = counts, i=0; i<I_HIGHEST; i++, c++)
+  for(c = counts, i=0; i<I_HIGHEST && c->times; i++, c++)
   { const code_info *info = &codeTable[c->code];
 
-    Sfprintf(Scurout, "%-13s %8d ", info->name, c->times);
+    Sfprintf(Scurout, "%-13s %10" PRId64 " ", info->name, c->times);
     if ( c->vartimesptr )
     { int n, m=MAXVAR;
 
       while(m>0 && c->vartimesptr[m-1] == 0 )
 	m--;
       for(n=0; n<m; n++)
-	Sfprintf(Scurout, " %8d", c->vartimesptr[n]);
+	Sfprintf(Scurout, " %8" PRId64, c->vartimesptr[n]);
     }
     Sfprintf(Scurout, "\n");
   }
 
+  seqs = malloc(sizeof(*seqs)*I_HIGHEST*I_HIGHEST);
+  for(i=0; i<I_HIGHEST; i++)
+  { for(j=0; j<I_HIGHEST; j++)
+    { if ( pair_counts[i][j] )
+      { seqs[nseqs].codes[0] = i;
+	seqs[nseqs].codes[1] = j;
+	seqs[nseqs].times = pair_counts[i][j];
+	nseqs++;
+      }
+    }
+  }
+  printSeqs("Pairs", seqs, nseqs, 2);
+  free(seqs);
+
+  seqs = malloc(sizeof(triple_counts));
+  memcpy(seqs, triple_counts, sizeof(triple_counts));
+  printSeqs("Triples", seqs, MAXTRIPLES, 3);
+  free(seqs);
+
+  Sfprintf(Scurout, "\nInstructions: %" PRId64 ", dispatches: %" PRId64 "\n",
+	   total, dispatch_count);
+
+  succeed;
+}
+
+
+word
+pl_count_reset()
+{ int i;
+
+  for(i=0; i<I_HIGHEST; i++)
+  { counting[i].times = 0;
+    if ( counting[i].vartimesptr )
+      memset(counting[i].vartimesptr, 0, sizeof(int64_t)*MAXVAR);
+  }
+  memset(pair_counts, 0, sizeof(pair_counts));
+  memset(triple_counts, 0, sizeof(triple_counts));
+  dispatch_count = 0;
+  count_next_pc = NULL;
+
   succeed;
 }
 
 #else /* ~COUNTING */
 
 #define count(id, pc)			/* no debugging not counting */
+#define countDispatch()			(void)0
 
 #endif /* COUNTING */
 
@@ -2506,6 +2649,67 @@ newChoice(choice_type type, LocalFrame fr ARG_LD)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+resolveCallSite() finds the procedure  for  a  meta-call  at  call  site
+`pc` (I_USERCALL0 or I_USERCALLN).  `goal` is the functor or atom of the
+goal and `callargs` the number of arguments added by call/N.  Resolving
+requires looking up the extended functor and walking the module import
+chain, which is costly for closures that are called repeatedly.   Each
+thread therefore keeps a small cache indexed by  the  call  site  that
+holds the CALL_CACHE_WAYS most recently resolved goals for the site.  An
+entry is valid as long  as  GD->procedures.resolve_epoch  is  unchanged
+(see procedureResolutionChanged()) and the procedure  is  defined.   We
+only cache resolutions that cannot change otherwise  (see
+resolveProcedureStable()).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static Procedure
+resolveCallSite(Code pc, word goal, unsigned int callargs,
+		Module module ARG_LD)
+{ call_cache_entry *set =
+    LD->call_cache.entries[((uintptr_t)pc/sizeof(code))&(CALL_CACHE_SETS-1)];
+  unsigned int epoch = GD->procedures.resolve_epoch;
+  functor_t functor;
+  Procedure proc;
+  int i, stable;
+
+  for(i=0; i<CALL_CACHE_WAYS; i++)
+  { call_cache_entry *e = &set[i];
+
+    if ( e->pc == pc && e->goal == goal && e->module == module &&
+	 e->callargs == callargs && e->epoch == epoch &&
+	 isDefinedOrAutoloadProcedure(e->procedure) )
+    { LD->call_cache.hits++;
+      return e->procedure;
+    }
+  }
+
+  LD->call_cache.misses++;
+  if ( isAtom(goal) )
+  { functor = lookupFunctorDef(goal, callargs);
+  } else if ( callargs )
+  { FunctorDef fd = valueFunctor(goal);
+
+    functor = lookupFunctorDef(fd->name, fd->arity+callargs);
+  } else
+  { functor = goal;
+  }
+
+  proc = resolveProcedureStable(functor, module, &stable PASS_LD);
+  if ( stable )
+  { memmove(&set[1], &set[0], sizeof(*set)*(CALL_CACHE_WAYS-1));
+    set[0].pc        = pc;
+    set[0].goal      = goal;
+    set[0].module    = module;
+    set[0].procedure = proc;
+    set[0].epoch     = epoch;
+    set[0].callargs  = callargs;
+  }
+
+  return proc;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Op top of the query frame there are two   local frames. The top one is a
 dummy one, just enough to satisfy stack-walking   and GC. The first real
@@ -2961,6 +3165,14 @@ typedef struct register_file
 				  assert_exists(__is_vmh, "END_VMH used without VMH!"); \
 				}
 #define NEXT_INSTRUCTION	do { VMI_EXIT; _NEXT_INSTRUCTION; } while(0)
+/* End a superinstruction (see fuseInstructions() in pl-comp.c) by jumping
+ * directly to the next instruction `n`, skipping its opcode.  If the opcode
+ * is not `n`, e.g., because it is replaced by a break point, dispatch.
+ */
+#define NEXT_FUSED(n)		do { if ( likely(*PC == encode(n)) ) \
+				     { PC++; VMI_GOTO(n); } \
+				     NEXT_INSTRUCTION; \
+				   } while(0)
 #define VMI_GOTO(...)		do { VMI_EXIT; _VMI_GOTO(__VA_ARGS__); } while(0)
 #define VMH_GOTO(...)		do { _VMH_GOTO(__VA_ARGS__); } while(0)
 #define SOLUTION_RETURN(val)	do { VMI_EXIT; _SOLUTION_RETURN(val); } while(0)
@@ -3117,7 +3329,8 @@ static vmi_instr jmp_table[] =
 #if VMCODE_IS_ADDRESS
 
 #define _VMI_DECLARATION(Name,...)	Name ## _LBL:
-#define _NEXT_INSTRUCTION		DbgPrintInstruction(FR, PC); _VMI_GOTO_CODE(*PC++)
+#define _NEXT_INSTRUCTION		DbgPrintInstruction(FR, PC); countDispatch(); \
+					_VMI_GOTO_CODE(*PC++)
 #define _VMI_GOTO(n,...)		MARK_USED(__VA_ARGS__); PC -= TOTAL_ARGSIZE(__VA_ARGS__); goto n ## _LBL
 #define _VMI_GOTO_CODE(c)		goto *(void *)(c)
 #undef SEPARATE_VMI
@@ -45,6 +45,7 @@
 		 *******************************/
 
 word		pl_count(void);
+word		pl_count_reset(void);
 void		TrailAssignment__LD(Word p ARG_LD);
 void		do_undo(mark *m);
 Definition	getProcDefinition__LD(Definition def ARG_LD);
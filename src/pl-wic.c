@@ -1632,6 +1632,7 @@ loadPredicate(wic_state *state, int skip ARG_LD)
 	  Clause bcl    = baseBuffer(&buf, struct clause);
 
 	  bcl->code_size = ncodes;
+	  fuseInstructions(bcl->codes, ncodes);
 	  clause = (Clause)PL_malloc_atomic(csize);
 	  memcpy(clause, bcl, csize);
 
@@ -122,7 +122,7 @@ PL_blob_t _PL_closure_blob =
 };
 
 
-static int
+int
 unify_closure(term_t t, Definition def, Code supervisor)
 { closure c;
 
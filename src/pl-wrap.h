@@ -43,6 +43,7 @@ typedef struct closure
 
 GLOBAL PL_blob_t _PL_closure_blob;
 COMMON(void)	  resetWrappedSupervisor(Definition def);
+COMMON(int)	  unify_closure(term_t t, Definition def, Code supervisor);
 COMMON(int)	  get_closure_predicate__LD(term_t t, Definition *def ARG_LD);
 
 #define get_closure_predicate(t, def) get_closure_predicate__LD(t, def PASS_LD)